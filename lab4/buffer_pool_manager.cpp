@@ -11,18 +11,27 @@ fetchpage里面updatepage一个bug修六个多小时，服了，*/
 
 #include "buffer_pool_manager.h"
 
+#include <algorithm>
+#include <cstring>
+
+#include "ssd_page_cache.h"
+
 /**
  * @description: 从free_list或replacer中得到可淘汰帧页的 *frame_id
  * 
  * @return {bool} true: 可替换帧查找成功 , false: 可替换帧查找失败
  * @param {frame_id_t*} frame_id 帧页id指针,返回成功找到的可替换帧id
+ * @param {int} pool_id 要使用这个帧的子池，没有创建子池时忽略
  */
-bool BufferPoolManager::find_victim_page(frame_id_t* frame_id) {
+bool BufferPoolManager::find_victim_page(frame_id_t* frame_id, int pool_id) {
     // Todo:
     // 1 使用BufferPoolManager::free_list_判断缓冲池是否已满需要淘汰页面
     // 1.1 未满获得frame
     // 1.2 已满使用lru_replacer中的方法选择淘汰页面
 
+    if (!sub_pools_.empty()) {
+        return find_victim_in_pools(frame_id, pool_id);
+    }
     
     // free_list_是缓冲池中空闲帧的列表。刚创建的时候，pool_size个帧全在free_list_中。如果free_list_为空，就满了
     if(!free_list_.empty()) {
@@ -40,6 +49,94 @@ bool BufferPoolManager::find_victim_page(frame_id_t* frame_id) {
     return false;
 }
 
+/**
+ * @description: 有子池时按保留帧数选择可替换帧，并把帧的归属改到pool_id。
+ *              1. 池已达到max_frames：只能替换本池的页面
+ *              2. 有空闲帧：直接使用
+ *              3. 池低于min_frames、是不被抢占的池、或者其他池超出保留数的帧比本池多：
+ *                 先从超出保留数最多的池中抢一个帧，抢不到再替换本池的页面
+ *              4. 否则先替换本池的页面，本池的页面都被pin住时再从其他池抢
+ *              这样各个可被抢占的池超出保留数的部分会趋于相等，后创建的池也能分到帧
+ * @return {bool} true: 可替换帧查找成功 , false: 可替换帧查找失败
+ * @param {frame_id_t*} frame_id 返回找到的帧id
+ * @param {int} pool_id 要使用这个帧的子池
+ */
+bool BufferPoolManager::find_victim_in_pools(frame_id_t* frame_id, int pool_id) {
+    BufferSubPool &pool = sub_pools_[pool_id];
+    bool at_max = pool.options.max_frames > 0 && pool.num_frames >= pool.options.max_frames;
+    int from = -1;      // 被淘汰页面所在的池，-1表示用的是空闲帧
+    if (!at_max && !free_list_.empty()) {
+        *frame_id = free_list_.front();
+        free_list_.pop_front();
+    } else {
+        int steal = at_max ? -1 : find_steal_pool(pool_id);
+        bool prefer_steal = steal >= 0 && (pool.num_frames < pool.options.min_frames || pool.options.no_steal ||
+                                           sub_pools_[steal].excess() > pool.excess() + 1);
+        if (prefer_steal && sub_pools_[steal].replacer->victim(frame_id)) {
+            from = steal;
+        } else if (pool.replacer->victim(frame_id)) {
+            from = pool_id;
+        } else if (steal >= 0 && sub_pools_[steal].replacer->victim(frame_id)) {
+            from = steal;
+        } else {
+            return false;
+        }
+    }
+
+    if (from >= 0) {
+        BufferSubPool &victim_pool = sub_pools_[from];
+        victim_pool.stats.evictions++;
+        if (pages_[*frame_id].is_dirty()) {
+            victim_pool.stats.writebacks++;
+        }
+        victim_pool.num_frames--;
+        if (from != pool_id) {
+            pool.steals++;
+        }
+    }
+    frame2pool_[*frame_id] = pool_id;
+    pool.num_frames++;
+    return true;
+}
+
+/**
+ * @description: 找一个可以抢帧的池：不是不被抢占的池、超出保留帧数最多、并且有未被pin住的页面
+ * @return {int} 池的编号，没有时返回-1
+ * @param {int} pool_id 缺帧的池，不从它自己这里抢
+ */
+int BufferPoolManager::find_steal_pool(int pool_id) {
+    int best = -1;
+    size_t best_excess = 0;
+    for (int i = 0; i < (int)sub_pools_.size(); i++) {
+        size_t excess = sub_pools_[i].excess();
+        if (i != pool_id && excess > best_excess && sub_pools_[i].replacer->Size() > 0) {
+            best = i;
+            best_excess = excess;
+        }
+    }
+    return best;
+}
+
+/**
+ * @description: 返回管理该帧的replacer，没有子池时就是replacer_
+ * @param {frame_id_t} frame_id 帧id
+ */
+Replacer *BufferPoolManager::replacer_of(frame_id_t frame_id) {
+    if (sub_pools_.empty() || frame2pool_[frame_id] < 0) {
+        return replacer_;
+    }
+    return sub_pools_[frame2pool_[frame_id]].replacer;
+}
+
+/**
+ * @description: 返回文件所属的子池，没有分配过的文件在0号默认池
+ * @param {int} fd 文件句柄
+ */
+int BufferPoolManager::pool_of(int fd) {
+    auto it = fd2pool_.find(fd);
+    return it == fd2pool_.end() ? 0 : it->second;
+}
+
 /**
  * @description: 更新页面数据, 如果为脏页则需写入磁盘，再更新为新页面，更新page元数据(data, is_dirty, page_id)和page table
  * 描述：更新页面。调用update_page后，原本位置的页就被一个新页替换，iD、脏位、pin_count都是新的，数据刷成空的。
@@ -55,10 +152,21 @@ void BufferPoolManager::update_page(Page *page, PageId new_page_id, frame_id_t n
     // 2 更新page table
     // 3 重置page的data，更新page id
     
-    page_table_.erase(page->get_page_id());  // 删除旧页的映射关系
+    PageId old_page_id = page->get_page_id();
+    bool evicted = page_table_.erase(old_page_id) > 0;  // 删除旧页的映射关系
+    if (evicted) {
+        stats_.evictions++;
+    }
     if (page->is_dirty()) {
-        disk_manager_->write_page(page->get_page_id().fd, page->get_page_id().page_no, page->data_, PAGE_SIZE);
+        disk_manager_->write_page(old_page_id.fd, old_page_id.page_no, page->data_, PAGE_SIZE);
         page->is_dirty_ = false;
+        stats_.writebacks++;
+        note_write(old_page_id);
+        if (ssd_cache_ != nullptr) {
+            ssd_cache_->invalidate(old_page_id);    // 二级缓存里的旧副本过期了
+        }
+    } else if (evicted && ssd_cache_ != nullptr) {
+        ssd_cache_->admit(old_page_id, page->data_);   // 被淘汰的干净页面交给二级缓存
     }
     // 更新页面元数据
     page->id_ = new_page_id;     // 更新page id
@@ -86,14 +194,24 @@ Page* BufferPoolManager::fetch_page(PageId page_id) {
     std::scoped_lock lock{latch_};
     if(page_table_.count(page_id)) {
         // 1.1 page_table_中有目标页的记录
-        replacer_->pin(page_table_[page_id]);   // 调用replacer中pin方法固定page所在frame
+        stats_.hits++;
+        if (!sub_pools_.empty()) {
+            sub_pools_[frame2pool_[page_table_[page_id]]].stats.hits++;
+        }
+        replacer_of(page_table_[page_id])->pin(page_table_[page_id]);   // 调用replacer中pin方法固定page所在frame
+        touch_frame(page_table_[page_id]);
         pages_[page_table_[page_id]].pin_count_++; // pin_count自增
         return &pages_[page_table_[page_id]];
 
     }
+    stats_.misses++;
+    int pool_id = pool_of(page_id.fd);
+    if (!sub_pools_.empty()) {
+        sub_pools_[pool_id].stats.misses++;
+    }
     frame_id_t frame_id;
     // 尝试调用find_victim_page获得一个可用的frame，若失败则返回nullptr
-    if(find_victim_page(&frame_id)) { 
+    if(find_victim_page(&frame_id, pool_id)) { 
 
 
         // 2. 若获得的可用frame存储的为dirty page，则须调用update_page将page写回到磁盘
@@ -110,10 +228,13 @@ Page* BufferPoolManager::fetch_page(PageId page_id) {
         // 将该frame存储的page换成一个新的页，即目标页
         update_page(&pages_[frame_id], page_id, frame_id);
 
-        // 3. 调用disk_manager_的read_page读取目标页到frame
-        disk_manager_->read_page(page_id.fd, page_id.page_no, pages_[frame_id].data_, PAGE_SIZE);
+        // 3. 先查二级缓存，未命中时调用disk_manager_的read_page读取目标页到frame
+        if (ssd_cache_ == nullptr || !ssd_cache_->lookup(page_id, pages_[frame_id].data_)) {
+            disk_manager_->read_page(page_id.fd, page_id.page_no, pages_[frame_id].data_, PAGE_SIZE);
+        }
         // 4. 固定目标页，更新pin_count_
-        replacer_->pin(page_table_[page_id]);
+        replacer_of(frame_id)->pin(frame_id);
+        touch_frame(frame_id);
         pages_[frame_id].pin_count_ = 1;
 
         // ** 要建立新页的页帧id对应关系
@@ -159,7 +280,7 @@ bool BufferPoolManager::unpin_page(PageId page_id, bool is_dirty) {
             if(!page->is_dirty())
                 page->is_dirty_ = is_dirty;     // 稍微改一下，脏位只能0改1，不能1改成0
             if(page->pin_count_ == 0) {
-                replacer_->unpin(page_table_[page_id]);
+                replacer_of(page_table_[page_id])->unpin(page_table_[page_id]);
             }
         }
         
@@ -187,6 +308,10 @@ bool BufferPoolManager::flush_page(PageId page_id) {
         Page* page = &pages_[page_table_[page_id]];
         disk_manager_->write_page(page_id.fd, page_id.page_no, page->data_, PAGE_SIZE);
         page->is_dirty_ = false;
+        note_write(page_id);
+        if (ssd_cache_ != nullptr) {
+            ssd_cache_->invalidate(page_id);
+        }
     }
    
     return true;
@@ -205,16 +330,20 @@ Page* BufferPoolManager::new_page(PageId* page_id) {
     // 5.   返回获得的page
     std::scoped_lock lock{latch_};
     frame_id_t frame_id;
-    if (find_victim_page(&frame_id)) {
+    if (find_victim_page(&frame_id, pool_of(page_id->fd))) {
         
         page_id->page_no = disk_manager_->allocate_page(page_id->fd);
         if (page_id->page_no == INVALID_PAGE_ID) {
             return nullptr; // 分配页面失败
         }
+        if (ssd_cache_ != nullptr) {
+            ssd_cache_->invalidate(*page_id);   // 页号可能是回收后重新分配的
+        }
         update_page(&pages_[frame_id], *page_id, frame_id);
 
         // page_table_[*page_id] = frame_id; update方法里面会完成
         pages_[frame_id].pin_count_ = 1; // 设置pin_count
+        touch_frame(frame_id);
         return &pages_[frame_id];
         
 
@@ -233,6 +362,9 @@ bool BufferPoolManager::delete_page(PageId page_id) {
     // 2.   若目标页的pin_count不为0，则返回false
     // 3.   将目标页数据写回磁盘，从页表中删除目标页，重置其元数据，将其加入free_list_，返回true
     std::scoped_lock lock{latch_};
+    if (ssd_cache_ != nullptr) {
+        ssd_cache_->invalidate(page_id);    // 不在缓冲池中的页面也可能在二级缓存里
+    }
     if(page_table_.count(page_id)) {
         Page* page = &pages_[page_table_[page_id]];
         if(page->pin_count_ != 0) {
@@ -241,9 +373,16 @@ bool BufferPoolManager::delete_page(PageId page_id) {
         if(page->is_dirty()) {
             disk_manager_->write_page(page_id.fd, page_id.page_no, page->data_, PAGE_SIZE);
             page->is_dirty_ = false;
+            note_write(page_id);
         }
         page->reset_memory();   
-        free_list_.push_back(page_table_[page_id]);
+        frame_id_t frame_id = page_table_[page_id];
+        replacer_of(frame_id)->pin(frame_id);     // 未被pin住的帧还在replacer里，放回free_list_前要移出来
+        if (!sub_pools_.empty()) {
+            sub_pools_[frame2pool_[frame_id]].num_frames--;
+            frame2pool_[frame_id] = -1;
+        }
+        free_list_.push_back(frame_id);
         page_table_.erase(page_id);           
 
         return true;
@@ -266,4 +405,302 @@ void BufferPoolManager::flush_all_pages(int fd) {
     
     
     
-}
\ No newline at end of file
+}
+
+/**
+ * @description: 关闭或删除文件前调用：把文件fd在缓冲池中的页面写回并移出缓冲池，并作废二级缓存中该文件的所有页面。
+ *               文件关闭后句柄会被新打开的文件复用，留下的页面会被当成新文件的页面读出来
+ * @return {bool} 全部移出返回true；有页面仍被pin住时返回false，这些页面留在缓冲池中
+ * @param {int} fd 文件句柄
+ */
+bool BufferPoolManager::delete_all_pages(int fd) {
+    std::vector<PageId> page_ids;
+    {
+        std::scoped_lock lock{latch_};
+        for (auto &[page_id, frame_id] : page_table_) {
+            if (page_id.fd == fd) {
+                page_ids.push_back(page_id);
+            }
+        }
+    }
+    bool all_deleted = true;
+    for (PageId page_id : page_ids) {
+        all_deleted = delete_page(page_id) && all_deleted;
+    }
+    std::scoped_lock lock{latch_};
+    if (ssd_cache_ != nullptr) {
+        ssd_cache_->invalidate_file(fd);
+    }
+    return all_deleted;
+}
+
+/**
+ * @description: 获取缓冲池命中统计的一份拷贝
+ * @return {BufferPoolStats} 从创建缓冲池（或上次reset_stats）以来的统计
+ */
+BufferPoolStats BufferPoolManager::get_stats() {
+    std::scoped_lock lock{latch_};
+    return stats_;
+}
+
+/**
+ * @description: 清零缓冲池命中统计
+ */
+void BufferPoolManager::reset_stats() {
+    std::scoped_lock lock{latch_};
+    stats_ = BufferPoolStats();
+    for (BufferSubPool &pool : sub_pools_) {
+        pool.stats = BufferPoolStats();
+        pool.steals = 0;
+    }
+}
+
+/**
+ * @description: 设置二级页面缓存，为nullptr时不使用。应在缓冲池开始使用之前设置
+ * @param {SsdPageCache*} ssd_cache 二级缓存，生命周期由调用方管理
+ */
+void BufferPoolManager::set_ssd_cache(SsdPageCache *ssd_cache) {
+    std::scoped_lock lock{latch_};
+    ssd_cache_ = ssd_cache;
+}
+
+/**
+ * @description: 创建一个命名子池。第一次调用时把缓冲池中已有的页面都归到0号默认池（"default"）
+ * @return {int} 子池编号，传给assign_file
+ * @param {string&} name 子池名字，不能重复
+ * @param {BufferSubPoolOptions&} options 保留帧数、帧数上限、是否不被抢占
+ */
+int BufferPoolManager::create_sub_pool(const std::string &name, const BufferSubPoolOptions &options) {
+    std::scoped_lock lock{latch_};
+    if (sub_pools_.empty()) {
+        BufferSubPool default_pool;
+        default_pool.name = "default";
+        default_pool.replacer = replacer_;
+        frame2pool_.assign(pool_size_, -1);
+        for (auto &[page_id, frame_id] : page_table_) {
+            frame2pool_[frame_id] = 0;
+            default_pool.num_frames++;
+        }
+        sub_pools_.push_back(std::move(default_pool));
+    }
+    size_t reserved = options.min_frames;
+    for (const BufferSubPool &pool : sub_pools_) {
+        if (pool.name == name) {
+            throw InternalError("BufferPoolManager::create_sub_pool: duplicate pool " + name);
+        }
+        reserved += pool.options.min_frames;
+    }
+    if (reserved > pool_size_ || (options.max_frames > 0 && options.max_frames < options.min_frames)) {
+        throw InternalError("BufferPoolManager::create_sub_pool: bad frame reservation for pool " + name);
+    }
+    BufferSubPool pool;
+    pool.name = name;
+    pool.options = options;
+    pool.own_replacer = std::make_unique<LRUReplacer>(pool_size_);
+    pool.replacer = pool.own_replacer.get();
+    sub_pools_.push_back(std::move(pool));
+    return (int)sub_pools_.size() - 1;
+}
+
+/**
+ * @description: 把文件分配到一个子池，文件已经在缓冲池中的页面一起转过去，超出池的max_frames的部分被替换出去。
+ *              关闭文件后fd会被复用，应先assign_file(fd, 0)还给默认池
+ * @param {int} fd 文件句柄
+ * @param {int} pool_id create_sub_pool返回的编号，0是默认池
+ */
+void BufferPoolManager::assign_file(int fd, int pool_id) {
+    std::scoped_lock lock{latch_};
+    if (pool_id < 0 || pool_id >= (int)std::max<size_t>(sub_pools_.size(), 1)) {
+        throw InternalError("BufferPoolManager::assign_file: no such pool");
+    }
+    if (sub_pools_.empty()) {
+        return;     // 只有默认池
+    }
+    if (pool_id == 0) {
+        fd2pool_.erase(fd);
+    } else {
+        fd2pool_[fd] = pool_id;
+    }
+    for (auto &[page_id, frame_id] : page_table_) {
+        int old_pool = frame2pool_[frame_id];
+        if (page_id.fd != fd || old_pool == pool_id) {
+            continue;
+        }
+        if (pages_[frame_id].pin_count_ == 0) {
+            sub_pools_[old_pool].replacer->pin(frame_id);
+            sub_pools_[pool_id].replacer->unpin(frame_id);
+        }
+        sub_pools_[old_pool].num_frames--;
+        sub_pools_[pool_id].num_frames++;
+        frame2pool_[frame_id] = pool_id;
+    }
+    // 转过来的页面可能让池超过max_frames，而池满了之后替换出的帧还归本池，不会自己降下来。
+    // 多出来的未被pin住的页面按LRU顺序写回并放回空闲链表
+    BufferSubPool &pool = sub_pools_[pool_id];
+    frame_id_t frame_id;
+    while (pool.options.max_frames > 0 && pool.num_frames > pool.options.max_frames &&
+           pool.replacer->victim(&frame_id)) {
+        Page *page = &pages_[frame_id];
+        PageId page_id = page->get_page_id();
+        if (page->is_dirty()) {
+            disk_manager_->write_page(page_id.fd, page_id.page_no, page->data_, PAGE_SIZE);
+            page->is_dirty_ = false;
+            note_write(page_id);
+            pool.stats.writebacks++;
+            if (ssd_cache_ != nullptr) {
+                ssd_cache_->invalidate(page_id);
+            }
+        } else if (ssd_cache_ != nullptr) {
+            ssd_cache_->admit(page_id, page->data_);
+        }
+        page_table_.erase(page_id);
+        page->reset_memory();
+        pool.stats.evictions++;
+        pool.num_frames--;
+        frame2pool_[frame_id] = -1;
+        free_list_.push_back(frame_id);
+    }
+}
+
+/**
+ * @description: 把文件从start_page_no开始的所有页面读进缓冲池，用于让不被抢占的池中的小表整个读进内存。
+ *              页面数超过池的max_frames时，后读的页面会替换先读的
+ * @return {int} 读入（或已经在缓冲池中）的页面数
+ * @param {int} fd 文件句柄
+ * @param {page_id_t} start_page_no 第一个读入的页面。记录文件要传RM_FIRST_RECORD_PAGE：
+ *                    文件头页由RmManager直接读写磁盘，缓冲池里的副本会过期
+ */
+int BufferPoolManager::preload_file(int fd, page_id_t start_page_no) {
+    int num_pages = disk_manager_->get_file_size(disk_manager_->get_file_name(fd)) / PAGE_SIZE;
+    int loaded = 0;
+    for (page_id_t page_no = start_page_no; page_no < num_pages; page_no++) {
+        PageId page_id{fd, page_no};
+        if (fetch_page(page_id) == nullptr) {
+            break;
+        }
+        unpin_page(page_id, false);
+        loaded++;
+    }
+    return loaded;
+}
+
+/**
+ * @description: 获取各子池的帧数和命中统计，没有创建子池时返回空
+ */
+std::vector<BufferSubPoolStats> BufferPoolManager::get_sub_pool_stats() {
+    std::scoped_lock lock{latch_};
+    std::vector<BufferSubPoolStats> result;
+    for (const BufferSubPool &pool : sub_pools_) {
+        BufferSubPoolStats stats;
+        stats.name = pool.name;
+        stats.options = pool.options;
+        stats.frames = pool.num_frames;
+        stats.steals = pool.steals;
+        stats.stats = pool.stats;
+        result.push_back(stats);
+    }
+    return result;
+}
+
+/**
+ * @description: 记录帧的最近访问时间，get_hot_pages按它排序
+ * @param {frame_id_t} frame_id 帧id
+ */
+void BufferPoolManager::touch_frame(frame_id_t frame_id) {
+    if (frame_ticks_.empty()) {
+        frame_ticks_.assign(pool_size_, 0);
+    }
+    frame_ticks_[frame_id] = ++access_tick_;
+}
+
+/**
+ * @description: 记录页面被缓冲池写回磁盘。按页面哈希直接映射到write_epochs_，冲突时只会让install_page多跳过一些页面
+ * @param {PageId} page_id 写回的页面
+ */
+void BufferPoolManager::note_write(PageId page_id) {
+    if (write_epochs_.empty()) {
+        write_epochs_.assign(pool_size_ * 4, 0);
+    }
+    write_epochs_[write_slot(page_id)] = ++write_epoch_;
+}
+
+size_t BufferPoolManager::write_slot(PageId page_id) const {
+    uint64_t key = (uint64_t)(uint32_t)page_id.fd << 32 | (uint32_t)page_id.page_no;
+    return (key * 0x9e3779b97f4a7c15ULL >> 32) % write_epochs_.size();
+}
+
+/**
+ * @description: 按最近访问时间从新到旧列出缓冲池中的页面，用于转储预热列表
+ * @return {vector<PageId>} 页面列表，最热的在前
+ * @param {size_t} max_pages 最多返回的页面数，0表示全部
+ */
+std::vector<PageId> BufferPoolManager::get_hot_pages(size_t max_pages) {
+    std::scoped_lock lock{latch_};
+    std::vector<std::pair<uint64_t, PageId>> pages;
+    pages.reserve(page_table_.size());
+    for (auto &[page_id, frame_id] : page_table_) {
+        pages.emplace_back(frame_ticks_.empty() ? 0 : frame_ticks_[frame_id], page_id);
+    }
+    std::sort(pages.begin(), pages.end(),
+              [](const std::pair<uint64_t, PageId> &a, const std::pair<uint64_t, PageId> &b) { return a.first > b.first; });
+    if (max_pages > 0 && pages.size() > max_pages) {
+        pages.resize(max_pages);
+    }
+    std::vector<PageId> result;
+    result.reserve(pages.size());
+    for (auto &entry : pages) {
+        result.push_back(entry.second);
+    }
+    return result;
+}
+
+/**
+ * @description: 获取当前的写回序号。预热线程读磁盘之前取一次，装入时交给install_page
+ */
+uint64_t BufferPoolManager::get_write_epoch() {
+    std::scoped_lock lock{latch_};
+    return write_epoch_;
+}
+
+/**
+ * @description: 把预热线程从磁盘读到的页面装入一个空闲帧，不pin，不淘汰任何页面。
+ *              页面已经在缓冲池中、读盘之后被写回过（磁盘上的内容比data新）、或者所在子池已达到上限时跳过
+ * @return {bool} 缓冲池已经没有空闲帧时返回false，预热应该停止；否则返回true
+ * @param {PageId} page_id 页面
+ * @param {const char*} data 页面内容
+ * @param {uint64_t} read_epoch 读盘之前get_write_epoch()的返回值
+ */
+bool BufferPoolManager::install_page(PageId page_id, const char *data, uint64_t read_epoch) {
+    std::scoped_lock lock{latch_};
+    if (free_list_.empty()) {
+        return false;
+    }
+    if (page_table_.count(page_id) || (!write_epochs_.empty() && write_epochs_[write_slot(page_id)] > read_epoch)) {
+        return true;
+    }
+    int pool_id = pool_of(page_id.fd);
+    if (!sub_pools_.empty()) {
+        BufferSubPool &pool = sub_pools_[pool_id];
+        if (pool.options.max_frames > 0 && pool.num_frames >= pool.options.max_frames) {
+            return true;
+        }
+    }
+    frame_id_t frame_id = free_list_.front();
+    free_list_.pop_front();
+    if (!sub_pools_.empty()) {
+        frame2pool_[frame_id] = pool_id;
+        sub_pools_[pool_id].num_frames++;
+    }
+    Page *page = &pages_[frame_id];
+    page->id_ = page_id;
+    memcpy(page->data_, data, PAGE_SIZE);
+    page->is_dirty_ = false;
+    page->pin_count_ = 0;
+    page_table_[page_id] = frame_id;
+    if (!frame_ticks_.empty()) {
+        frame_ticks_[frame_id] = 0;
+    }
+    replacer_of(frame_id)->unpin(frame_id);
+    stats_.prefetches++;
+    return true;
+}
@@ -0,0 +1,120 @@
+/* Copyright (c) 2023 Renmin University of China
+RMDB is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+        http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#pragma once
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cassert>
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "buffer_pool_stats.h"
+#include "buffer_sub_pool.h"
+#include "disk_manager.h"
+#include "errors.h"
+#include "page.h"
+#include "replacer/lru_replacer.h"
+
+class SsdPageCache;
+
+class BufferPoolManager {
+   private:
+    size_t pool_size_;      // buffer_pool中可容纳页面的个数，即帧的个数
+    Page *pages_;           // buffer_pool中的Page对象数组，在构造空间中申请内存空间，在析构函数中释放，大小为BUFFER_POOL_SIZE
+    std::unordered_map<PageId, frame_id_t> page_table_;    // 帧号和页面号的映射哈希表，用于根据页面的PageId定位该页面的帧编号
+    std::list<frame_id_t> free_list_;   // 空闲帧编号的链表
+    DiskManager *disk_manager_;
+    Replacer *replacer_;    // buffer_pool的置换策略，当前赛题中为LRU置换策略
+    std::mutex latch_;      // 用于共享数据结构的并发控制
+    BufferPoolStats stats_; // 命中统计，在latch_保护下更新
+    SsdPageCache *ssd_cache_ = nullptr;     // 二级页面缓存，为nullptr时不使用
+    std::vector<BufferSubPool> sub_pools_;  // 命名子池，为空表示没有划分子池，0号是默认池
+    std::vector<int> frame2pool_;           // 每个帧所属的子池，-1表示空闲帧
+    std::unordered_map<int, int> fd2pool_;  // 文件所属的子池，不在表中的文件在默认池
+    std::vector<uint64_t> frame_ticks_;     // 每个帧最近一次被访问的时间，get_hot_pages按它排序
+    uint64_t access_tick_ = 0;
+    std::vector<uint64_t> write_epochs_;    // 按页面哈希直接映射的最近写回序号，install_page用来跳过过期的页面
+    uint64_t write_epoch_ = 0;
+
+   public:
+    BufferPoolManager(size_t pool_size, DiskManager *disk_manager)
+        : pool_size_(pool_size), disk_manager_(disk_manager) {
+        // 为buffer pool分配一块连续的内存空间
+        pages_ = new Page[pool_size_];
+        replacer_ = new LRUReplacer(pool_size_);
+        // 初始化时，所有的page都在free_list_中
+        for (size_t i = 0; i < pool_size_; ++i) {
+            free_list_.emplace_back(static_cast<frame_id_t>(i));  // static_cast转换数据类型
+        }
+    }
+
+    ~BufferPoolManager() {
+        delete[] pages_;
+        delete replacer_;
+    }
+
+    Page *fetch_page(PageId page_id);
+
+    bool unpin_page(PageId page_id, bool is_dirty);
+
+    bool flush_page(PageId page_id);
+
+    Page *new_page(PageId *page_id);
+
+    bool delete_page(PageId page_id);
+
+    void flush_all_pages(int fd);
+
+    bool delete_all_pages(int fd);
+
+    BufferPoolStats get_stats();
+
+    void reset_stats();
+
+    void set_ssd_cache(SsdPageCache *ssd_cache);
+
+    int create_sub_pool(const std::string &name, const BufferSubPoolOptions &options);
+
+    void assign_file(int fd, int pool_id);
+
+    int preload_file(int fd, page_id_t start_page_no);
+
+    std::vector<BufferSubPoolStats> get_sub_pool_stats();
+
+    std::vector<PageId> get_hot_pages(size_t max_pages = 0);
+
+    uint64_t get_write_epoch();
+
+    bool install_page(PageId page_id, const char *data, uint64_t read_epoch);
+
+   private:
+    bool find_victim_page(frame_id_t *frame_id, int pool_id = 0);
+
+    bool find_victim_in_pools(frame_id_t *frame_id, int pool_id);
+
+    int find_steal_pool(int pool_id);
+
+    Replacer *replacer_of(frame_id_t frame_id);
+
+    int pool_of(int fd);
+
+    void touch_frame(frame_id_t frame_id);
+
+    void note_write(PageId page_id);
+
+    size_t write_slot(PageId page_id) const;
+
+    void update_page(Page *page, PageId new_page_id, frame_id_t new_frame_id);
+};
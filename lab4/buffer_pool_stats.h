@@ -0,0 +1,33 @@
+/* Copyright (c) 2023 Renmin University of China
+RMDB is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+        http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#pragma once
+
+#include <cstdint>
+
+/* 缓冲池的命中统计。BufferPoolManager在latch_保护下更新，get_stats()返回一份拷贝，
+   两次拷贝相减就是这段时间内的统计 */
+struct BufferPoolStats {
+    uint64_t hits = 0;          // fetch_page时页面已经在缓冲池中
+    uint64_t misses = 0;        // fetch_page时需要从磁盘读入
+    uint64_t evictions = 0;     // 为了腾出帧替换掉的有效页面
+    uint64_t writebacks = 0;    // 淘汰时写回磁盘的脏页
+    uint64_t prefetches = 0;    // 预热时直接装入空闲帧的页面
+
+    double hit_rate() const {
+        uint64_t total = hits + misses;
+        return total == 0 ? 0.0 : (double)hits / total;
+    }
+
+    BufferPoolStats operator-(const BufferPoolStats &rhs) const {
+        return BufferPoolStats{hits - rhs.hits, misses - rhs.misses, evictions - rhs.evictions,
+                               writebacks - rhs.writebacks, prefetches - rhs.prefetches};
+    }
+};
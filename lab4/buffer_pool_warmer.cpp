@@ -0,0 +1,274 @@
+/* Copyright (c) 2023 Renmin University of China
+RMDB is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+        http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#include "buffer_pool_warmer.h"
+
+#include <fcntl.h>      // for open
+#include <sys/stat.h>   // for fstat
+#include <unistd.h>     // for pread, write, fsync
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>       // for rename
+#include <cstring>
+#include <unordered_map>
+
+#include "errors.h"
+
+BufferPoolWarmer::BufferPoolWarmer(BufferPoolManager *buffer_pool_manager, DiskManager *disk_manager,
+                                   std::string dump_path, BufferPoolWarmerOptions options)
+    : buffer_pool_manager_(buffer_pool_manager),
+      disk_manager_(disk_manager),
+      dump_path_(std::move(dump_path)),
+      options_(options) {
+    options_.batch_pages = std::max(1, options_.batch_pages);
+    options_.sort_window = std::max<size_t>(1, options_.sort_window);
+}
+
+BufferPoolWarmer::~BufferPoolWarmer() {
+    try {
+        stop();
+    } catch (std::exception &) {
+        // 析构时转储失败只是下次启动没有预热
+    }
+}
+
+/**
+ * @description: 把缓冲池中的页面按最近访问时间从新到旧写进转储文件。已经关闭的文件中的页面不记录
+ * @return {size_t} 写入的页面数
+ */
+size_t BufferPoolWarmer::dump() {
+    std::vector<PageId> pages = buffer_pool_manager_->get_hot_pages(options_.max_pages);
+    std::vector<std::string> files;
+    std::unordered_map<int, int> fd2file_no;    // -1表示文件已经关闭
+    std::vector<DumpEntry> entries;
+    entries.reserve(pages.size());
+    for (const PageId &page_id : pages) {
+        auto it = fd2file_no.find(page_id.fd);
+        if (it == fd2file_no.end()) {
+            int file_no = -1;
+            try {
+                files.push_back(disk_manager_->get_file_name(page_id.fd));
+                file_no = (int)files.size() - 1;
+            } catch (FileNotOpenError &) {
+            }
+            it = fd2file_no.emplace(page_id.fd, file_no).first;
+        }
+        if (it->second >= 0) {
+            entries.push_back(DumpEntry{(uint32_t)it->second, page_id.page_no});
+        }
+    }
+
+    std::vector<char> buf(sizeof(DumpHdr));
+    DumpHdr hdr{DUMP_MAGIC, (uint32_t)files.size(), (uint32_t)entries.size()};
+    memcpy(buf.data(), &hdr, sizeof(hdr));
+    for (const std::string &name : files) {
+        uint32_t len = name.size();
+        buf.insert(buf.end(), (const char *)&len, (const char *)&len + sizeof(len));
+        buf.insert(buf.end(), name.begin(), name.end());
+    }
+    buf.insert(buf.end(), (const char *)entries.data(), (const char *)(entries.data() + entries.size()));
+
+    // 先写临时文件再rename，进程在转储中途退出时旧的转储文件仍然完整
+    std::string tmp_path = dump_path_ + ".tmp";
+    int fd = open(tmp_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, S_IRUSR | S_IWUSR);
+    if (fd < 0) {
+        throw UnixError();
+    }
+    bool ok = write(fd, buf.data(), buf.size()) == (ssize_t)buf.size() && fsync(fd) == 0;
+    close(fd);
+    if (!ok || rename(tmp_path.c_str(), dump_path_.c_str()) != 0) {
+        unlink(tmp_path.c_str());
+        throw UnixError();
+    }
+    std::scoped_lock lock{latch_};
+    stats_.dumps++;
+    stats_.pages_dumped = entries.size();
+    return entries.size();
+}
+
+/**
+ * @description: 启动后台线程，每隔dump_interval_sec转储一次
+ */
+void BufferPoolWarmer::start_periodic_dump() {
+    if (options_.dump_interval_sec <= 0 || dump_thread_.joinable()) {
+        return;
+    }
+    dump_thread_ = std::thread([this]() { dump_loop(); });
+}
+
+void BufferPoolWarmer::dump_loop() {
+    auto interval = std::chrono::duration<double>(options_.dump_interval_sec);
+    std::unique_lock lock{latch_};
+    while (!stop_cv_.wait_for(lock, interval, [this]() { return stop_.load(); })) {
+        lock.unlock();
+        try {
+            dump();
+        } catch (std::exception &) {
+            // 这次没写成，等下一次
+        }
+        lock.lock();
+    }
+}
+
+/**
+ * @description: 读转储文件，打开其中的文件，然后在后台线程中把页面读进缓冲池。没有转储文件或文件损坏时什么也不做
+ */
+void BufferPoolWarmer::start_restore() {
+    if (restore_thread_.joinable()) {
+        return;
+    }
+    std::vector<char> buf;
+    int fd = open(dump_path_.c_str(), O_RDONLY);
+    if (fd >= 0) {
+        struct stat st;
+        if (fstat(fd, &st) == 0 && st.st_size >= (off_t)sizeof(DumpHdr)) {
+            buf.resize(st.st_size);
+            if (pread(fd, buf.data(), buf.size(), 0) != (ssize_t)buf.size()) {
+                buf.clear();
+            }
+        }
+        close(fd);
+    }
+
+    // 解析：文件名表，然后是(文件序号, 页号)列表
+    std::vector<PageId> pages;
+    size_t files_missing = 0;   // 先在本地计数，最后和pages_listed一起在latch_下写进stats_
+    DumpHdr hdr;
+    if (buf.size() >= sizeof(DumpHdr)) {
+        memcpy(&hdr, buf.data(), sizeof(hdr));
+    }
+    if (buf.size() >= sizeof(DumpHdr) && hdr.magic == DUMP_MAGIC) {
+        size_t pos = sizeof(DumpHdr);
+        std::vector<int> file_fds;
+        for (uint32_t i = 0; i < hdr.num_files && pos + sizeof(uint32_t) <= buf.size(); i++) {
+            uint32_t len;
+            memcpy(&len, buf.data() + pos, sizeof(len));
+            pos += sizeof(len);
+            if (pos + len > buf.size()) {
+                break;
+            }
+            std::string name(buf.data() + pos, len);
+            pos += len;
+            if (disk_manager_->is_file(name)) {
+                file_fds.push_back(disk_manager_->open_file(name));
+            } else {
+                file_fds.push_back(-1);
+                files_missing++;
+            }
+        }
+        if (file_fds.size() == hdr.num_files && pos + (size_t)hdr.num_pages * sizeof(DumpEntry) <= buf.size()) {
+            pages.reserve(hdr.num_pages);
+            for (uint32_t i = 0; i < hdr.num_pages; i++) {
+                DumpEntry entry;
+                memcpy(&entry, buf.data() + pos + i * sizeof(DumpEntry), sizeof(entry));
+                if (entry.file_no < file_fds.size() && file_fds[entry.file_no] >= 0) {
+                    pages.push_back(PageId{file_fds[entry.file_no], entry.page_no});
+                }
+            }
+        }
+    }
+    {
+        std::scoped_lock lock{latch_};
+        stats_.files_missing += files_missing;
+        stats_.pages_listed = pages.size();
+    }
+    restore_thread_ = std::thread([this, pages = std::move(pages)]() mutable { restore(std::move(pages)); });
+}
+
+/**
+ * @description: 后台恢复。pages按热度从高到低排列，每次取sort_window个按(fd, 页号)排序，
+ *              连续的页面合并成最多batch_pages页的一次pread，缓冲池没有空闲帧时停止
+ * @param {vector<PageId>} pages 转储文件中的页面
+ */
+void BufferPoolWarmer::restore(std::vector<PageId> pages) {
+    auto start = std::chrono::steady_clock::now();
+    std::vector<char> buf((size_t)options_.batch_pages * PAGE_SIZE);
+    size_t pages_read = 0;
+    bool pool_full = false;
+    try {
+        for (size_t w = 0; w < pages.size() && !pool_full && !stop_; w += options_.sort_window) {
+            auto window_end = pages.begin() + std::min(pages.size(), w + options_.sort_window);
+            std::sort(pages.begin() + w, window_end, [](const PageId &a, const PageId &b) {
+                return a.fd != b.fd ? a.fd < b.fd : a.page_no < b.page_no;
+            });
+            size_t end = window_end - pages.begin();
+            for (size_t i = w; i < end && !pool_full && !stop_;) {
+                size_t j = i + 1;
+                while (j < end && j - i < (size_t)options_.batch_pages && pages[j].fd == pages[i].fd &&
+                       pages[j].page_no == pages[j - 1].page_no + 1) {
+                    j++;
+                }
+                uint64_t read_epoch = buffer_pool_manager_->get_write_epoch();
+                int n = disk_manager_->read_pages(pages[i].fd, pages[i].page_no, buf.data(), (int)(j - i));
+                for (int k = 0; k < n; k++) {
+                    if (!buffer_pool_manager_->install_page(PageId{pages[i].fd, pages[i].page_no + k},
+                                                            buf.data() + (size_t)k * PAGE_SIZE, read_epoch)) {
+                        pool_full = true;
+                        break;
+                    }
+                }
+                pages_read += n;
+                i = j;
+
+                std::unique_lock lock{latch_};
+                stats_.pages_read = pages_read;
+                stats_.batches++;
+                if (options_.max_pages_per_sec > 0) {
+                    auto next = start + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                                            std::chrono::duration<double>(pages_read / options_.max_pages_per_sec));
+                    stop_cv_.wait_until(lock, next, [this]() { return stop_.load(); });
+                }
+            }
+        }
+    } catch (std::exception &) {
+        // 文件在预热期间被关闭或删除，放弃剩下的页面
+    }
+    std::scoped_lock lock{latch_};
+    stats_.restore_done = true;
+    stats_.restore_sec = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+/**
+ * @description: 等待后台恢复结束
+ */
+void BufferPoolWarmer::wait_restore() {
+    if (restore_thread_.joinable()) {
+        restore_thread_.join();
+    }
+}
+
+/**
+ * @description: 停止后台恢复和定期转储，dump_on_stop时再做最后一次转储。只有第一次调用有效
+ */
+void BufferPoolWarmer::stop() {
+    {
+        std::scoped_lock lock{latch_};
+        if (stop_) {
+            return;
+        }
+        stop_ = true;
+    }
+    stop_cv_.notify_all();
+    if (restore_thread_.joinable()) {
+        restore_thread_.join();
+    }
+    if (dump_thread_.joinable()) {
+        dump_thread_.join();
+    }
+    if (options_.dump_on_stop) {
+        dump();
+    }
+}
+
+BufferPoolWarmerStats BufferPoolWarmer::get_stats() {
+    std::scoped_lock lock{latch_};
+    return stats_;
+}
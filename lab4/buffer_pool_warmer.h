@@ -0,0 +1,99 @@
+/* Copyright (c) 2023 Renmin University of China
+RMDB is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+        http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "storage/buffer_pool_manager.h"
+#include "storage/disk_manager.h"
+
+struct BufferPoolWarmerOptions {
+    int batch_pages = 32;               // 一次pread最多读入的连续页面数
+    size_t sort_window = 4096;          // 恢复时每次取这么多个最热的页面，排序后读入，热的页面先进缓冲池
+    size_t max_pages = 0;               // 转储的最多页面数，0表示缓冲池中的全部页面
+    double dump_interval_sec = 0;       // 定期转储的间隔，0表示不定期转储
+    double max_pages_per_sec = 0;       // 恢复时每秒最多读入的页面数，0表示不限速
+    bool dump_on_stop = true;           // stop()时是否做最后一次转储，只用来恢复的实例可以关掉，以免覆盖原来的转储文件
+};
+
+struct BufferPoolWarmerStats {
+    size_t pages_listed = 0;    // 转储文件中的页面数
+    size_t pages_read = 0;      // 从磁盘读入的页面数
+    size_t files_missing = 0;   // 已经不存在的文件数，它们的页面被跳过
+    size_t batches = 0;
+    size_t dumps = 0;
+    size_t pages_dumped = 0;    // 最近一次转储的页面数
+    bool restore_done = false;
+    double restore_sec = 0;
+};
+
+/* 缓冲池预热。dump()把缓冲池中的页面按最近访问时间从新到旧写到dump_path（文件名表 + (文件序号, 页号)列表，
+   先写临时文件再rename），start_periodic_dump()在后台按间隔转储。
+   重启后start_restore()读转储文件，在后台线程中按热度分段、段内按(文件, 页号)排序，合并成连续的页面用pread批量读入，
+   通过install_page装进空闲帧，不pin、不淘汰页面，缓冲池没有空闲帧时停止；前台的fetch_page照常进行。
+   转储文件中的文件按路径记录，start_restore()在调用线程中用open_file打开（已经打开的直接返回原来的fd），
+   后台线程只做读盘和装入。
+   stop()停止后台线程，dump_on_stop时做最后一次转储，要在关闭数据文件之前调用；析构时没有stop()过会自动调用。
+   只有经过缓冲池写回的页面能被检查出读盘之后是否被改过，不要在预热期间绕过缓冲池写数据页 */
+class BufferPoolWarmer {
+   public:
+    BufferPoolWarmer(BufferPoolManager *buffer_pool_manager, DiskManager *disk_manager, std::string dump_path,
+                     BufferPoolWarmerOptions options = BufferPoolWarmerOptions());
+
+    ~BufferPoolWarmer();
+
+    size_t dump();
+
+    void start_periodic_dump();
+
+    void start_restore();
+
+    void wait_restore();
+
+    void stop();
+
+    BufferPoolWarmerStats get_stats();
+
+   private:
+    static constexpr uint32_t DUMP_MAGIC = 0x57524d50;    // "WRMP"
+
+    struct DumpHdr {
+        uint32_t magic;
+        uint32_t num_files;
+        uint32_t num_pages;
+    };
+
+    struct DumpEntry {
+        uint32_t file_no;
+        int32_t page_no;
+    };
+
+    void restore(std::vector<PageId> pages);
+
+    void dump_loop();
+
+    BufferPoolManager *buffer_pool_manager_;
+    DiskManager *disk_manager_;
+    std::string dump_path_;
+    BufferPoolWarmerOptions options_;
+
+    std::mutex latch_;                  // 保护stats_，以及dump_thread_的等待
+    std::condition_variable stop_cv_;
+    std::atomic<bool> stop_{false};
+    std::thread restore_thread_;
+    std::thread dump_thread_;
+    BufferPoolWarmerStats stats_;
+};
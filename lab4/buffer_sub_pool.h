@@ -0,0 +1,51 @@
+/* Copyright (c) 2023 Renmin University of China
+RMDB is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+        http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <string>
+
+#include "buffer_pool_stats.h"
+#include "replacer/lru_replacer.h"
+
+struct BufferSubPoolOptions {
+    size_t min_frames = 0;      // 保留给该池的帧数，其他池淘汰页面时不会让它低于这个数
+    size_t max_frames = 0;      // 该池最多占用的帧数，0表示不限制。达到上限后只替换本池自己的页面
+    bool no_steal = false;      // 不被抢占：其他池不会从这里抢帧，本池的页面只会被本池的新页面替换。
+                                // 页面没有pin住，池满了照样按LRU替换，不保证常驻内存
+};
+
+/* 一个子池的统计，由BufferPoolManager::get_sub_pool_stats()返回 */
+struct BufferSubPoolStats {
+    std::string name;
+    BufferSubPoolOptions options;
+    size_t frames = 0;          // 当前占用的帧数
+    uint64_t steals = 0;        // 从其他池抢来的帧数
+    BufferPoolStats stats;      // evictions/writebacks是本池的页面被替换、写回的次数
+};
+
+/* 缓冲池中的一个命名子池。每个池有自己的LRU，帧的归属记录在BufferPoolManager::frame2pool_中。
+   0号池是默认池，使用缓冲池原来的replacer_，没有分配到其他池的文件都在默认池中 */
+struct BufferSubPool {
+    std::string name;
+    BufferSubPoolOptions options;
+    std::unique_ptr<Replacer> own_replacer;     // 默认池为空
+    Replacer *replacer = nullptr;
+    size_t num_frames = 0;
+    uint64_t steals = 0;
+    BufferPoolStats stats;
+
+    // 超出保留帧数的部分，其他池缺帧时从超出最多的池中抢
+    size_t excess() const {
+        return options.no_steal || num_frames <= options.min_frames ? 0 : num_frames - options.min_frames;
+    }
+};
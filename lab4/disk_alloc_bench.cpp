@@ -0,0 +1,215 @@
+/* Copyright (c) 2023 Renmin University of China
+RMDB is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+        http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+/* DiskManager页面分配的基准测试：插入密集的文件增长和碎片。
+   几个文件交替地分配、写入页面（模拟多张表同时插入），比较两种方式：
+     append  逐页增长，不预留空间，也不释放页面（原来的行为）
+     extent  按extent用fallocate预留空间，释放的页面被复用
+   输出增长阶段的吞吐、用FIEMAP统计的每个文件的物理extent数、释放一部分页面再重新分配后文件的页面数，
+   以及关闭重新打开后DiskManager恢复出的下一个页号。
+
+   用法: disk_alloc_bench [--files=4] [--pages=20000] [--free-ratio=0.25] [--mode=both|append|extent]
+                          [--dir=alloc_bench_db] [--format=text|json] */
+
+#include <linux/fiemap.h>
+#include <linux/fs.h>
+#include <sys/ioctl.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "storage/disk_manager.h"
+
+namespace {
+
+struct AllocBenchConfig {
+    int files = 4;
+    int pages = 20000;          // 每个文件的页面数
+    double free_ratio = 0.25;   // 增长之后释放再重新分配的页面比例
+    bool run_append = true;
+    bool run_extent = true;
+    std::string dir = "alloc_bench_db";
+    bool json = false;
+};
+
+struct AllocBenchResult {
+    const char *mode;
+    double grow_sec = 0;
+    long long extents = 0;          // 所有文件的物理extent数之和，-1表示文件系统不支持FIEMAP
+    long long pages_after_grow = 0;
+    long long pages_after_churn = 0;
+    double churn_sec = 0;
+    bool recovered_ok = true;       // 重新打开后下一个页号等于文件的页面数
+};
+
+// 用FIEMAP统计文件占用的物理extent数，先把脏数据刷下去，延迟分配的块才有确定的位置
+long long count_extents(int fd) {
+    struct fiemap fm;
+    memset(&fm, 0, sizeof(fm));
+    fm.fm_start = 0;
+    fm.fm_length = FIEMAP_MAX_OFFSET;
+    fm.fm_flags = FIEMAP_FLAG_SYNC;
+    fm.fm_extent_count = 0;     // 只要数量
+    if (ioctl(fd, FS_IOC_FIEMAP, &fm) < 0) {
+        return -1;
+    }
+    return fm.fm_mapped_extents;
+}
+
+AllocBenchResult run_mode(const AllocBenchConfig &config, bool extent) {
+    AllocBenchResult result;
+    result.mode = extent ? "extent" : "append";
+    DiskManager disk_manager;
+    if (extent) {
+        disk_manager.set_extent_pages(16, 1024);
+    } else {
+        disk_manager.set_extent_pages(0, 0);
+    }
+    if (!disk_manager.is_dir(config.dir)) {
+        disk_manager.create_dir(config.dir);
+    }
+
+    std::vector<std::string> paths;
+    std::vector<int> fds;
+    for (int i = 0; i < config.files; i++) {
+        paths.push_back(config.dir + "/" + result.mode + "_" + std::to_string(i));
+        if (disk_manager.is_file(paths.back())) {
+            disk_manager.destroy_file(paths.back());
+        }
+        disk_manager.create_file(paths.back());
+        fds.push_back(disk_manager.open_file(paths.back()));
+    }
+    std::vector<char> buf(PAGE_SIZE, 'x');
+
+    // 增长：各文件交替追加页面
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < config.pages; i++) {
+        for (int fd : fds) {
+            page_id_t page_no = disk_manager.allocate_page(fd);
+            disk_manager.write_page(fd, page_no, buf.data(), PAGE_SIZE);
+        }
+    }
+    result.grow_sec = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    for (size_t i = 0; i < fds.size(); i++) {
+        long long n = count_extents(fds[i]);
+        result.extents = (n < 0 || result.extents < 0) ? -1 : result.extents + n;
+        result.pages_after_grow += disk_manager.get_file_size(paths[i]) / PAGE_SIZE;
+    }
+
+    // 释放一部分页面再分配同样多的页面。append方式下释放不起作用，文件只会继续变长
+    int step = config.free_ratio > 0 ? std::max(1, (int)(1 / config.free_ratio)) : 0;
+    start = std::chrono::steady_clock::now();
+    for (int fd : fds) {
+        int num_freed = 0;
+        for (int page_no = 0; step > 0 && page_no < config.pages; page_no += step) {
+            if (extent) {
+                disk_manager.deallocate_page(fd, page_no);
+            }
+            num_freed++;
+        }
+        for (int i = 0; i < num_freed; i++) {
+            page_id_t page_no = disk_manager.allocate_page(fd);
+            disk_manager.write_page(fd, page_no, buf.data(), PAGE_SIZE);
+        }
+    }
+    result.churn_sec = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    // 关闭后重新打开，检查下一个页号是否从磁盘上正确恢复
+    for (size_t i = 0; i < fds.size(); i++) {
+        long long file_pages = disk_manager.get_file_size(paths[i]) / PAGE_SIZE;
+        result.pages_after_churn += file_pages;
+        disk_manager.close_file(fds[i]);
+        int fd = disk_manager.open_file(paths[i]);
+        if (disk_manager.allocate_page(fd) != file_pages) {
+            result.recovered_ok = false;
+        }
+        disk_manager.close_file(fd);
+        disk_manager.destroy_file(paths[i]);
+    }
+    return result;
+}
+
+bool parse_args(int argc, char **argv, AllocBenchConfig *config) {
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        size_t eq = arg.find('=');
+        std::string key = arg.substr(0, eq);
+        std::string value = eq == std::string::npos ? "" : arg.substr(eq + 1);
+        if (key == "--files") {
+            config->files = std::max(1, std::atoi(value.c_str()));
+        } else if (key == "--pages") {
+            config->pages = std::max(1, std::atoi(value.c_str()));
+        } else if (key == "--free-ratio") {
+            config->free_ratio = std::atof(value.c_str());
+        } else if (key == "--mode") {
+            config->run_append = value == "both" || value == "append";
+            config->run_extent = value == "both" || value == "extent";
+            if (!config->run_append && !config->run_extent) {
+                return false;
+            }
+        } else if (key == "--dir") {
+            config->dir = value;
+        } else if (key == "--format") {
+            config->json = value == "json";
+        } else {
+            return false;
+        }
+    }
+    return true;
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+    AllocBenchConfig config;
+    if (!parse_args(argc, argv, &config)) {
+        fprintf(stderr,
+                "usage: %s [--files=N] [--pages=N] [--free-ratio=F] [--mode=both|append|extent]\n"
+                "          [--dir=PATH] [--format=text|json]\n",
+                argv[0]);
+        return 1;
+    }
+
+    std::vector<AllocBenchResult> results;
+    if (config.run_append) {
+        results.push_back(run_mode(config, false));
+    }
+    if (config.run_extent) {
+        results.push_back(run_mode(config, true));
+    }
+
+    long long total_pages = (long long)config.files * config.pages;
+    if (config.json) {
+        printf("{\"files\":%d,\"pages_per_file\":%d,\"free_ratio\":%.3f,\"modes\":{", config.files, config.pages,
+               config.free_ratio);
+        for (size_t i = 0; i < results.size(); i++) {
+            const AllocBenchResult &r = results[i];
+            printf("%s\"%s\":{\"grow_sec\":%.3f,\"grow_pages_per_sec\":%.1f,\"extents\":%lld,\"pages_after_grow\":%lld,"
+                   "\"churn_sec\":%.3f,\"pages_after_churn\":%lld,\"recovered_ok\":%s}",
+                   i == 0 ? "" : ",", r.mode, r.grow_sec, total_pages / r.grow_sec, r.extents, r.pages_after_grow,
+                   r.churn_sec, r.pages_after_churn, r.recovered_ok ? "true" : "false");
+        }
+        printf("}}\n");
+    } else {
+        printf("files=%d pages/file=%d free_ratio=%.2f\n", config.files, config.pages, config.free_ratio);
+        printf("%-8s %10s %12s %10s %12s %12s %10s\n", "mode", "grow(s)", "pages/s", "extents", "pages", "churn pages",
+               "recovered");
+        for (const AllocBenchResult &r : results) {
+            printf("%-8s %10.3f %12.1f %10lld %12lld %12lld %10s\n", r.mode, r.grow_sec, total_pages / r.grow_sec,
+                   r.extents, r.pages_after_grow, r.pages_after_churn, r.recovered_ok ? "yes" : "no");
+        }
+    }
+    return 0;
+}
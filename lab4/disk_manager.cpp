@@ -12,10 +12,12 @@ See the Mulan PSL v2 for more details. */
 
 #include <assert.h>    // for assert
 #include <string.h>    // for memset
+#include <sys/file.h>  // for flock
 #include <sys/stat.h>  // for stat
 #include <unistd.h>    // for lseek
 
 #include "defs.h"
+#include "page_alloc_map.h"
 
 DiskManager::DiskManager() { memset(fd2pageno_, 0, MAX_FD * (sizeof(std::atomic<page_id_t>) / sizeof(char))); }
 
@@ -31,8 +33,9 @@ void DiskManager::write_page(int fd, page_id_t page_no, const char *offset, int
     // 1.lseek()定位到文件头，通过(fd,page_no)可以定位指定页面及其在磁盘文件中的偏移量
     // 2.调用write()函数
     // 注意write返回值与num_bytes不等时 throw InternalError("DiskManager::write_page Error");
-    lseek(fd, page_no * PAGE_SIZE, SEEK_SET);
-    ssize_t bytes_written = write(fd, offset, num_bytes);
+    // 偏移量先转成off_t再乘，page_no * PAGE_SIZE按int计算在文件超过2GB时会溢出；
+    // 用pwrite不改变文件偏移，和其他线程的读写之间没有lseek和write之间的竞争
+    ssize_t bytes_written = pwrite(fd, offset, num_bytes, (off_t)page_no * PAGE_SIZE);
     if (bytes_written != num_bytes) {
         throw InternalError("DiskManager::write_page Error");
     }
@@ -50,26 +53,114 @@ void DiskManager::read_page(int fd, page_id_t page_no, char *offset, int num_byt
     // 1.lseek()定位到文件头，通过(fd,page_no)可以定位指定页面及其在磁盘文件中的偏移量
     // 2.调用read()函数
     // 注意read返回值与num_bytes不等时，throw InternalError("DiskManager::read_page Error");
-    lseek(fd, page_no * PAGE_SIZE, SEEK_SET);
-    ssize_t bytes_read = read(fd, offset, num_bytes);
+    ssize_t bytes_read = pread(fd, offset, num_bytes, (off_t)page_no * PAGE_SIZE);
     if (bytes_read != num_bytes) {
         throw InternalError("DiskManager::read_page Error");
     }
 }
 
+/**
+ * @description: 从page_no开始连续读取多个页面。用pread，不改变文件偏移，可以和其他线程的read_page同时进行
+ * @return {int} 实际读到的完整页面数，读到文件末尾时小于num_pages
+ * @param {int} fd 磁盘文件的文件句柄
+ * @param {page_id_t} page_no 第一个页面的编号
+ * @param {char} *offset 读取的内容写入到offset中，至少num_pages * PAGE_SIZE字节
+ * @param {int} num_pages 页面数
+ */
+int DiskManager::read_pages(int fd, page_id_t page_no, char *offset, int num_pages) {
+    size_t total = (size_t)num_pages * PAGE_SIZE;
+    size_t done = 0;
+    while (done < total) {
+        ssize_t n = pread(fd, offset + done, total - done, (off_t)page_no * PAGE_SIZE + done);
+        if (n < 0) {
+            throw UnixError();
+        }
+        if (n == 0) {
+            break;
+        }
+        done += n;
+    }
+    return done / PAGE_SIZE;
+}
+
 /**
  * @description: 分配一个新的页号
  * @return {page_id_t} 分配的新页号
  * @param {int} fd 指定文件的文件句柄
  */
 page_id_t DiskManager::allocate_page(int fd) {
-    // 简单的自增分配策略，指定文件的页面编号加1
+    // 通过open_file打开的文件使用分配表：优先复用已释放的页面，否则在文件末尾按extent预留空间后分配
     assert(fd >= 0 && fd < MAX_FD);
-    return fd2pageno_[fd]++;
+    std::scoped_lock lock{alloc_latch_};
+    auto it = fd2alloc_.find(fd);
+    if (it == fd2alloc_.end()) {
+        return fd2pageno_[fd]++;    // 没有分配表的文件还是简单的自增分配
+    }
+    page_id_t page_no = it->second->allocate();
+    fd2pageno_[fd] = it->second->get_num_pages();
+    return page_no;
 }
 
 void DiskManager::deallocate_page(__attribute__((unused)) page_id_t page_id) {}
 
+/**
+ * @description: 释放文件中的一个页面，之后allocate_page会优先复用它。RmFileHandle::truncate_empty_tail用它交还中间的空页面
+ * @return {bool} 页面原来是否处于已分配状态
+ * @param {int} fd 指定文件的文件句柄
+ * @param {page_id_t} page_no 要释放的页号
+ */
+bool DiskManager::deallocate_page(int fd, page_id_t page_no) {
+    std::scoped_lock lock{alloc_latch_};
+    auto it = fd2alloc_.find(fd);
+    return it != fd2alloc_.end() && it->second->deallocate(page_no);
+}
+
+/**
+ * @description: 设置文件下一个从末尾分配的页号，同时更新分配表
+ * @param {int} fd 指定文件的文件句柄
+ * @param {int} start_page_no 下一个分配的页号，即文件的页面数
+ */
+void DiskManager::set_fd2pageno(int fd, int start_page_no) {
+    std::scoped_lock lock{alloc_latch_};
+    auto it = fd2alloc_.find(fd);
+    if (it != fd2alloc_.end()) {
+        it->second->set_num_pages(start_page_no);
+    }
+    fd2pageno_[fd] = start_page_no;
+}
+
+/**
+ * @description: 设置按extent预留空间的大小，从min_pages开始翻倍到max_pages，max_pages为0时不预留。
+ *               只影响之后打开的文件
+ */
+void DiskManager::set_extent_pages(int min_pages, int max_pages) {
+    std::scoped_lock lock{alloc_latch_};
+    min_extent_pages_ = min_pages;
+    max_extent_pages_ = max_pages;
+}
+
+/**
+ * @description: 获取文件中已释放、等待复用的页面数
+ */
+size_t DiskManager::get_num_free_pages(int fd) {
+    std::scoped_lock lock{alloc_latch_};
+    auto it = fd2alloc_.find(fd);
+    return it == fd2alloc_.end() ? 0 : it->second->get_num_free();
+}
+
+/**
+ * @description: 截断文件，只保留前num_pages个页面，之后从num_pages开始分配页号
+ * @param {int} fd 指定文件的文件句柄
+ * @param {page_id_t} num_pages 保留的页面数
+ */
+void DiskManager::truncate_file(int fd, page_id_t num_pages) {
+    assert(fd >= 0 && fd < MAX_FD);
+    if (ftruncate(fd, (off_t)num_pages * PAGE_SIZE) < 0) {
+        throw UnixError();
+    }
+    set_fd2pageno(fd, num_pages);
+}
+
 bool DiskManager::is_dir(const std::string& path) {
     struct stat st;
     return stat(path.c_str(), &st) == 0 && S_ISDIR(st.st_mode);
@@ -119,6 +210,7 @@ void DiskManager::create_file(const std::string &path) {
         if(fd < 0) {
             throw UnixError();
         }
+        unlink(PageAllocMap::map_path(path).c_str());  // 同名文件之前留下的分配表
         set_fd2pageno(fd, 0);
     } else {
         throw FileExistsError(path);
@@ -137,6 +229,7 @@ void DiskManager::destroy_file(const std::string &path) {
     
     // 为了不能删除未关闭的文件，我们应该先检查文件是不是关闭的。是关闭的，才删除
     // 文件打开列表有两个哈希表，用于记录打开的文件。可以用path2fd_检查，效仿get_file_fd
+    std::scoped_lock lock{file_latch_};
     if (!is_file(path)) {
         throw FileNotFoundError(path);
     }
@@ -146,6 +239,7 @@ void DiskManager::destroy_file(const std::string &path) {
     if(unlink(path.c_str()) < 0) {
         throw UnixError();
     }
+    unlink(PageAllocMap::map_path(path).c_str());
 }
 
 
@@ -162,6 +256,8 @@ int DiskManager::open_file(const std::string &path) {
     // 注意get_file_fd的实现，当文件未打开时直接返回了open_file的返回值，因此要返回句柄
     // 要更新两个打开文件列表
     // 不能重复打开，所以应该先检查.
+    // 文件打开列表可能被多个线程同时访问（并行算子的溢出、后台预热线程等），检查和登记都在file_latch_下进行
+    std::scoped_lock file_lock{file_latch_};
     if(path2fd_.count(path)) {
         return path2fd_[path];
     }
@@ -175,6 +271,26 @@ int DiskManager::open_file(const std::string &path) {
         if(fd < 0) {
             throw UnixError();
         }
+        // 读写打开的文件加排他锁。RmMmapFileHandle映射期间持有共享锁，映射着的文件不能被打开来写，
+        // 映射区因此不会读到写了一半的页面，也不会因为文件被截断收到SIGBUS
+        if (flock(fd, LOCK_EX | LOCK_NB) < 0) {
+            close(fd);
+            throw InternalError("DiskManager::open_file: file is mapped or opened elsewhere " + path);
+        }
+        // 读入分配表，下一个页号从磁盘上恢复，而不是从0开始。
+        // 分配表建好之后才登记到打开文件列表，读分配表失败时关闭fd，不留下半打开的文件
+        {
+            std::scoped_lock lock{alloc_latch_};
+            std::unique_ptr<PageAllocMap> alloc_map;
+            try {
+                alloc_map = std::make_unique<PageAllocMap>(fd, path, min_extent_pages_, max_extent_pages_);
+            } catch (...) {
+                close(fd);
+                throw;
+            }
+            fd2pageno_[fd] = alloc_map->get_num_pages();
+            fd2alloc_[fd] = std::move(alloc_map);
+        }
         path2fd_[path] = fd;
         fd2path_[fd] = path;
         return fd;
@@ -192,7 +308,12 @@ void DiskManager::close_file(int fd) {
     // 注意不能关闭未打开的文件，并且需要更新文件打开列表
 
     // 先检查文件是否打开,通过fd2path_检查,若已经打开，就关闭
+    std::scoped_lock file_lock{file_latch_};
     if(fd2path_.count(fd)) {
+        {
+            std::scoped_lock lock{alloc_latch_};
+            fd2alloc_.erase(fd);    // 析构时把分配表写回磁盘
+        }
         close(fd);
         path2fd_.erase(fd2path_[fd]);  // 先删除path2fd_中的项
         fd2path_.erase(fd);  // 再删除fd2path_中的项
@@ -220,10 +341,12 @@ int DiskManager::get_file_size(const std::string &file_name) {
  * @param {int} fd 文件句柄
  */
 std::string DiskManager::get_file_name(int fd) {
-    if (!fd2path_.count(fd)) {
+    std::scoped_lock lock{file_latch_};
+    auto it = fd2path_.find(fd);
+    if (it == fd2path_.end()) {
         throw FileNotOpenError(fd);
     }
-    return fd2path_[fd];
+    return it->second;
 }
 
 /**
@@ -232,10 +355,8 @@ std::string DiskManager::get_file_name(int fd) {
  * @param {string} &file_name 文件名
  */
 int DiskManager::get_file_fd(const std::string &file_name) {
-    if (!path2fd_.count(file_name)) {
-        return open_file(file_name);
-    }
-    return path2fd_[file_name];
+    // open_file在file_latch_下检查，已经打开时直接返回原来的句柄
+    return open_file(file_name);
 }
 
 
@@ -0,0 +1,115 @@
+/* Copyright (c) 2023 Renmin University of China
+RMDB is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+        http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#pragma once
+
+#include <fcntl.h>     // for open
+#include <sys/stat.h>  // for stat
+#include <unistd.h>    // for lseek
+
+#include <atomic>
+#include <cassert>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+#include "common/config.h"
+#include "errors.h"
+#include "page_alloc_map.h"
+
+/**
+ * @description: DiskManager的作用主要是根据上层的需要对磁盘文件进行操作
+ */
+class DiskManager {
+   public:
+    explicit DiskManager();
+
+    ~DiskManager() = default;
+
+    void write_page(int fd, page_id_t page_no, const char *offset, int num_bytes);
+
+    void read_page(int fd, page_id_t page_no, char *offset, int num_bytes);
+
+    int read_pages(int fd, page_id_t page_no, char *offset, int num_pages);
+
+    page_id_t allocate_page(int fd);
+
+    void deallocate_page(page_id_t page_id);
+
+    bool deallocate_page(int fd, page_id_t page_no);
+
+    void set_extent_pages(int min_pages, int max_pages);
+
+    size_t get_num_free_pages(int fd);
+
+    void truncate_file(int fd, page_id_t num_pages);
+
+    /*目录操作*/
+    bool is_dir(const std::string &path);
+
+    void create_dir(const std::string &path);
+
+    void destroy_dir(const std::string &path);
+
+    /*文件操作*/
+    bool is_file(const std::string &path);
+
+    void create_file(const std::string &path);
+
+    void destroy_file(const std::string &path);
+
+    int open_file(const std::string &path);
+
+    void close_file(int fd);
+
+    int get_file_size(const std::string &file_name);
+
+    std::string get_file_name(int fd);
+
+    int get_file_fd(const std::string &file_name);
+
+    /*日志操作*/
+    int read_log(char *log_data, int size, int offset);
+
+    void write_log(char *log_data, int size);
+
+    void SetLogFd(int log_fd) { log_fd_ = log_fd; }
+
+    int GetLogFd() { return log_fd_; }
+
+    void set_fd2pageno(int fd, int start_page_no);
+
+    /**
+     * @description: 获得文件目前已分配的页面个数，即如果文件要分配一个新页面，需要从fd2pageno_[fd]开始分配
+     * @return {page_id_t} 已分配的页面个数
+     * @param {int} fd 文件对应的句柄
+     */
+    page_id_t get_fd2pageno(int fd) { return fd2pageno_[fd]; }
+
+    static constexpr int MAX_FD = 8192;
+
+   private:
+    // 文件打开列表，用于记录文件是否被打开
+    std::unordered_map<std::string, int> path2fd_;  //<Page文件磁盘路径,Page fd>哈希表
+    std::unordered_map<int, std::string> fd2path_;  //<Page fd,Page文件磁盘路径>哈希表
+    std::mutex file_latch_;     // 保护path2fd_和fd2path_，和alloc_latch_一起持有时先拿file_latch_
+
+    int log_fd_ = -1;                             // WAL日志文件的文件句柄，默认为-1，代表未打开日志文件
+    std::atomic<page_id_t> fd2pageno_[MAX_FD]{};  // 文件中已经分配的页面个数，初始值为0
+
+    std::mutex alloc_latch_;    // 保护fd2alloc_和extent设置
+    std::unordered_map<int, std::unique_ptr<PageAllocMap>> fd2alloc_;   // 通过open_file打开的文件的页面分配表
+    int min_extent_pages_ = 16;     // 第一次预留的extent大小
+    int max_extent_pages_ = 1024;   // extent翻倍的上限，0表示不预留
+};
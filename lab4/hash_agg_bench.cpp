@@ -0,0 +1,219 @@
+/* Copyright (c) 2023 Renmin University of China
+RMDB is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+        http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+/* 哈希聚合的基准测试。
+   按lab3/campustakeaway.sql的orders表生成--rows条记录，shangpu_id取--low-groups种值，user_id取--high-groups种值，执行
+     low   select shangpu_id, count(*), sum(price), avg(price) from orders group by shangpu_id
+     high  select user_id, count(*), sum(price), avg(price) from orders group by user_id
+   每个查询分别用RmHashAggregate::run单线程聚合（serial）和run_parallel线程私有预聚合（parallel，--threads个线程）执行。
+   缓冲池默认能放下整个文件，先扫一遍预热。输出每秒聚合的行数、分组数、溢出的分组数和递归层数，
+   ok表示分组数不超过键的种数且所有分组的count之和等于行数。
+
+   用法: hash_agg_bench [--rows=1000000] [--low-groups=500] [--high-groups=500000] [--threads=0]
+                        [--memory=67108864] [--pool=0] [--dir=hash_agg_bench_db] [--format=text|json] */
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "rm_column.h"
+#include "rm_hash_agg.h"
+#include "rm_manager.h"
+#include "rm_parallel_scan.h"
+#include "rm_record_source.h"
+#include "storage/buffer_pool_manager.h"
+#include "storage/disk_manager.h"
+
+namespace {
+
+using bench_clock = std::chrono::steady_clock;
+
+// orders表：order_id, user_id, shangpu_id, price, create_time datetime
+const std::vector<RmColumn> ORDERS_COLS = {
+    {TYPE_INT, 0, 4}, {TYPE_INT, 4, 4}, {TYPE_INT, 8, 4}, {TYPE_FLOAT, 12, 4}, {TYPE_STRING, 16, 19}};
+constexpr int ORDERS_RECORD_SIZE = 35;
+constexpr int USER_COL = 1;
+constexpr int SHANGPU_COL = 2;
+constexpr int PRICE_COL = 3;
+
+struct HashAggBenchConfig {
+    int rows = 1000000;
+    int low_groups = 500;
+    int high_groups = 500000;
+    int threads = 0;            // 0表示hardware_concurrency
+    size_t memory = 64 << 20;
+    size_t pool_size = 0;       // 0表示按文件大小自动设置
+    std::string dir = "hash_agg_bench_db";
+    bool json = false;
+};
+
+struct HashAggBenchResult {
+    const char *query;
+    const char *mode;
+    int threads;
+    double sec = 0;
+    size_t groups = 0;
+    RmHashAggStats stats;
+    bool ok = true;
+};
+
+// 生成一条orders记录，user_id和shangpu_id分别在给定的种数内均匀分布
+void make_order(char *rec, int order_id, const HashAggBenchConfig &config, std::mt19937_64 &rng) {
+    memset(rec, 0, ORDERS_RECORD_SIZE);
+    int user_id = rng() % config.high_groups + 1;
+    int shangpu_id = rng() % config.low_groups + 1;
+    float price = (float)(rng() % 5000) / 100;
+    memcpy(rec + ORDERS_COLS[0].offset, &order_id, sizeof(int));
+    memcpy(rec + ORDERS_COLS[USER_COL].offset, &user_id, sizeof(int));
+    memcpy(rec + ORDERS_COLS[SHANGPU_COL].offset, &shangpu_id, sizeof(int));
+    memcpy(rec + ORDERS_COLS[PRICE_COL].offset, &price, sizeof(float));
+    snprintf(rec + ORDERS_COLS[4].offset, ORDERS_COLS[4].len, "2024-10-%02d 12:00:00", order_id % 28 + 1);
+}
+
+HashAggBenchResult run_agg(const HashAggBenchConfig &config, DiskManager *disk_manager,
+                           BufferPoolManager *buffer_pool_manager, RmFileHandle *file_handle, bool high,
+                           bool parallel) {
+    HashAggBenchResult result;
+    result.query = high ? "high" : "low";
+    result.mode = parallel ? "parallel" : "serial";
+    result.threads = parallel ? config.threads : 1;
+    const RmColumn &price_col = ORDERS_COLS[PRICE_COL];
+    RmHashAggregate agg(disk_manager, {ORDERS_COLS[high ? USER_COL : SHANGPU_COL]},
+                        {{AGG_COUNT, price_col}, {AGG_SUM, price_col}, {AGG_AVG, price_col}}, config.memory,
+                        config.dir + "/agg_");
+    double total_count = 0;
+    auto sink = [&](const char *record) {
+        total_count += agg.get_agg_value(record, 0);
+        result.groups++;
+    };
+    auto start = bench_clock::now();
+    if (parallel) {
+        RmParallelScan scan(file_handle, buffer_pool_manager, config.threads);
+        agg.run_parallel(&scan, sink);
+    } else {
+        agg.run(rm_file_input(file_handle, buffer_pool_manager), sink);
+    }
+    result.sec = std::chrono::duration<double>(bench_clock::now() - start).count();
+    result.stats = agg.get_stats();
+    // 每种键值在行数足够多时都会出现，分组数只检查不超过键的种数
+    size_t max_groups = high ? config.high_groups : config.low_groups;
+    result.ok = (size_t)total_count == (size_t)config.rows && result.groups <= max_groups;
+    return result;
+}
+
+bool parse_args(int argc, char **argv, HashAggBenchConfig *config) {
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        size_t eq = arg.find('=');
+        std::string key = arg.substr(0, eq);
+        std::string value = eq == std::string::npos ? "" : arg.substr(eq + 1);
+        if (key == "--rows") {
+            config->rows = std::max(1, std::atoi(value.c_str()));
+        } else if (key == "--low-groups") {
+            config->low_groups = std::max(1, std::atoi(value.c_str()));
+        } else if (key == "--high-groups") {
+            config->high_groups = std::max(1, std::atoi(value.c_str()));
+        } else if (key == "--threads") {
+            config->threads = std::max(0, std::atoi(value.c_str()));
+        } else if (key == "--memory") {
+            config->memory = std::strtoull(value.c_str(), nullptr, 10);
+        } else if (key == "--pool") {
+            config->pool_size = std::strtoull(value.c_str(), nullptr, 10);
+        } else if (key == "--dir") {
+            config->dir = value;
+        } else if (key == "--format") {
+            config->json = value == "json";
+        } else {
+            return false;
+        }
+    }
+    return true;
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+    HashAggBenchConfig config;
+    if (!parse_args(argc, argv, &config)) {
+        fprintf(stderr,
+                "usage: %s [--rows=N] [--low-groups=N] [--high-groups=N] [--threads=N] [--memory=BYTES] "
+                "[--pool=FRAMES] [--dir=PATH] [--format=text|json]\n",
+                argv[0]);
+        return 1;
+    }
+    if (config.threads == 0) {
+        config.threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    if (config.pool_size == 0) {
+        config.pool_size = (size_t)config.rows / std::max(1, PAGE_SIZE / ORDERS_RECORD_SIZE - 1) + 64;
+    }
+
+    DiskManager disk_manager;
+    BufferPoolManager buffer_pool_manager(config.pool_size, &disk_manager);
+    RmManager rm_manager(&disk_manager, &buffer_pool_manager);
+    if (!disk_manager.is_dir(config.dir)) {
+        disk_manager.create_dir(config.dir);
+    }
+    std::string path = config.dir + "/orders";
+    if (disk_manager.is_file(path)) {
+        disk_manager.destroy_file(path);
+    }
+    rm_manager.create_file(path, ORDERS_RECORD_SIZE);
+    std::unique_ptr<RmFileHandle> file_handle = rm_manager.open_file(path);
+    std::mt19937_64 rng(42);
+    std::vector<char> rec(ORDERS_RECORD_SIZE);
+    for (int i = 1; i <= config.rows; i++) {
+        make_order(rec.data(), i, config, rng);
+        file_handle->insert_record(rec.data(), nullptr);
+    }
+    // 预热：把整个文件读进缓冲池
+    RmParallelScan(file_handle.get(), &buffer_pool_manager, 1).count_if([](const char *record) { return true; });
+
+    std::vector<HashAggBenchResult> results;
+    for (bool high : {false, true}) {
+        for (bool parallel : {false, true}) {
+            results.push_back(
+                run_agg(config, &disk_manager, &buffer_pool_manager, file_handle.get(), high, parallel));
+        }
+    }
+
+    rm_manager.close_file(file_handle.get());
+    file_handle.reset();
+    disk_manager.destroy_file(path);
+
+    if (config.json) {
+        printf("{\"rows\":%d,\"threads\":%d,\"memory\":%zu,\"results\":[", config.rows, config.threads,
+               config.memory);
+        for (size_t i = 0; i < results.size(); i++) {
+            const HashAggBenchResult &r = results[i];
+            printf("%s{\"query\":\"%s\",\"mode\":\"%s\",\"threads\":%d,\"sec\":%.4f,\"rows_per_sec\":%.1f,"
+                   "\"groups\":%zu,\"spilled\":%zu,\"max_level\":%d,\"ok\":%s}",
+                   i == 0 ? "" : ",", r.query, r.mode, r.threads, r.sec, config.rows / r.sec, r.groups,
+                   r.stats.spilled_rows, r.stats.max_level, r.ok ? "true" : "false");
+        }
+        printf("]}\n");
+    } else {
+        printf("rows=%d threads=%d memory=%zu\n", config.rows, config.threads, config.memory);
+        printf("%-6s %-9s %8s %10s %14s %10s %10s %6s %4s\n", "query", "mode", "threads", "sec", "rows/s", "groups",
+               "spilled", "level", "ok");
+        for (const HashAggBenchResult &r : results) {
+            printf("%-6s %-9s %8d %10.4f %14.1f %10zu %10zu %6d %4s\n", r.query, r.mode, r.threads, r.sec,
+                   config.rows / r.sec, r.groups, r.stats.spilled_rows, r.stats.max_level, r.ok ? "yes" : "no");
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,287 @@
+/* Copyright (c) 2023 Renmin University of China
+RMDB is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+        http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+/* 哈希连接的基准测试。
+   按lab3/campustakeaway.sql生成orders、orders_dish、dish三张表，规模随--scale线性增长
+   （每个scale：250个商铺、5000个菜品、50000个订单，每个订单1~5个菜品），执行
+     select sum(od.count * d.price) from orders o, orders_dish od, dish d
+     where o.order_id = od.order_id and od.dish_id = d.dish_id
+   第一个RmHashJoin以orders为build端、orders_dish为探测端，输出直接作为第二个RmHashJoin的探测端，build端是dish。
+   两个连接分别在--memory（通常放得下）和--spill-memory（强制溢出）两种内存预算下各跑一次，
+   输出用时、每秒处理的orders_dish行数、溢出的分区数和被Bloom过滤器挡掉的探测记录数，sum用来确认两次结果一致。
+
+   用法: hash_join_bench [--scale=1] [--memory=67108864] [--spill-memory=262144] [--pool=0]
+                         [--dir=hash_join_bench_db] [--format=text|json] */
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "rm_column.h"
+#include "rm_hash_join.h"
+#include "rm_manager.h"
+#include "rm_record_source.h"
+#include "rm_scan.h"
+#include "storage/buffer_pool_manager.h"
+#include "storage/disk_manager.h"
+
+namespace {
+
+using bench_clock = std::chrono::steady_clock;
+
+// orders：order_id, user_id, shangpu_id, price, create_time（datetime按秒存成int）
+const std::vector<RmColumn> ORDERS_COLS = {
+    {TYPE_INT, 0, 4}, {TYPE_INT, 4, 4}, {TYPE_INT, 8, 4}, {TYPE_FLOAT, 12, 4}, {TYPE_INT, 16, 4}};
+constexpr int ORDERS_RECORD_SIZE = 20;
+// orders_dish：order_id, dish_id, count
+const std::vector<RmColumn> ORDERS_DISH_COLS = {{TYPE_INT, 0, 4}, {TYPE_INT, 4, 4}, {TYPE_INT, 8, 4}};
+constexpr int ORDERS_DISH_RECORD_SIZE = 12;
+// dish：dish_id, shangpu_id, price, dish_name varchar(100), dish_score
+const std::vector<RmColumn> DISH_COLS = {
+    {TYPE_INT, 0, 4}, {TYPE_INT, 4, 4}, {TYPE_FLOAT, 8, 4}, {TYPE_STRING, 12, 100}, {TYPE_FLOAT, 112, 4}};
+constexpr int DISH_RECORD_SIZE = 116;
+// 第一个连接的输出：| orders_dish记录 | orders.user_id |
+const RmColumn JOINED_DISH_ID = {TYPE_INT, 4, 4};
+constexpr int JOINED_RECORD_SIZE = ORDERS_DISH_RECORD_SIZE + 4;
+
+constexpr int SHANGPU_PER_SCALE = 250;
+constexpr int DISHES_PER_SHANGPU = 20;
+constexpr int ORDERS_PER_SCALE = 50000;
+
+struct HashJoinBenchConfig {
+    int scale = 1;
+    size_t memory = 64 << 20;
+    size_t spill_memory = 256 << 10;
+    size_t pool_size = 0;       // 0表示按三个文件的大小自动设置
+    std::string dir = "hash_join_bench_db";
+    bool json = false;
+};
+
+struct HashJoinBenchResult {
+    const char *mode;
+    size_t memory;
+    double sec = 0;
+    size_t output_rows = 0;
+    double amount = 0;
+    RmHashJoinStats join1;
+    RmHashJoinStats join2;
+};
+
+void set_int(char *rec, const RmColumn &col, int v) { memcpy(rec + col.offset, &v, sizeof(int)); }
+
+void set_float(char *rec, const RmColumn &col, float v) { memcpy(rec + col.offset, &v, sizeof(float)); }
+
+int get_int(const char *rec, const RmColumn &col) {
+    int v;
+    memcpy(&v, rec + col.offset, sizeof(int));
+    return v;
+}
+
+float get_float(const char *rec, const RmColumn &col) {
+    float v;
+    memcpy(&v, rec + col.offset, sizeof(float));
+    return v;
+}
+
+struct BenchTables {
+    std::unique_ptr<RmFileHandle> orders;
+    std::unique_ptr<RmFileHandle> orders_dish;
+    std::unique_ptr<RmFileHandle> dish;
+};
+
+// 建一张空表并打开，已经存在的同名文件先删掉
+std::unique_ptr<RmFileHandle> create_table(DiskManager *disk_manager, RmManager *rm_manager, const std::string &path,
+                                           int record_size) {
+    if (disk_manager->is_file(path)) {
+        disk_manager->destroy_file(path);
+    }
+    rm_manager->create_file(path, record_size);
+    return rm_manager->open_file(path);
+}
+
+// 关闭并删除一张表
+void drop_table(DiskManager *disk_manager, RmManager *rm_manager, std::unique_ptr<RmFileHandle> *file_handle) {
+    std::string path = disk_manager->get_file_name((*file_handle)->GetFd());
+    rm_manager->close_file(file_handle->get());
+    file_handle->reset();
+    disk_manager->destroy_file(path);
+}
+
+// 生成三张表，菜品和订单的商铺、价格、数量都随机
+void load_tables(const HashJoinBenchConfig &config, BenchTables *tables) {
+    std::mt19937_64 rng(42);
+    int num_dishes = SHANGPU_PER_SCALE * DISHES_PER_SHANGPU * config.scale;
+    std::vector<char> rec(DISH_RECORD_SIZE);
+    for (int dish_id = 1; dish_id <= num_dishes; dish_id++) {
+        memset(rec.data(), 0, DISH_RECORD_SIZE);
+        set_int(rec.data(), DISH_COLS[0], dish_id);
+        set_int(rec.data(), DISH_COLS[1], (dish_id - 1) / DISHES_PER_SHANGPU + 1);
+        set_float(rec.data(), DISH_COLS[2], (float)(rng() % 5000) / 100);
+        snprintf(rec.data() + DISH_COLS[3].offset, DISH_COLS[3].len, "dish_%d", dish_id);
+        set_float(rec.data(), DISH_COLS[4], (float)(rng() % 50) / 10);
+        tables->dish->insert_record(rec.data(), nullptr);
+    }
+    int num_orders = ORDERS_PER_SCALE * config.scale;
+    int num_shangpu = SHANGPU_PER_SCALE * config.scale;
+    for (int order_id = 1; order_id <= num_orders; order_id++) {
+        int shangpu_id = rng() % num_shangpu + 1;
+        memset(rec.data(), 0, ORDERS_RECORD_SIZE);
+        set_int(rec.data(), ORDERS_COLS[0], order_id);
+        set_int(rec.data(), ORDERS_COLS[1], rng() % (num_orders / 5 + 1) + 1);
+        set_int(rec.data(), ORDERS_COLS[2], shangpu_id);
+        set_float(rec.data(), ORDERS_COLS[3], 0);
+        set_int(rec.data(), ORDERS_COLS[4], 1727712000 + order_id);
+        tables->orders->insert_record(rec.data(), nullptr);
+        int num_items = rng() % 5 + 1;
+        for (int i = 0; i < num_items; i++) {
+            memset(rec.data(), 0, ORDERS_DISH_RECORD_SIZE);
+            set_int(rec.data(), ORDERS_DISH_COLS[0], order_id);
+            int dish_id = (shangpu_id - 1) * DISHES_PER_SHANGPU + rng() % DISHES_PER_SHANGPU + 1;
+            set_int(rec.data(), ORDERS_DISH_COLS[1], dish_id);
+            set_int(rec.data(), ORDERS_DISH_COLS[2], rng() % 3 + 1);
+            tables->orders_dish->insert_record(rec.data(), nullptr);
+        }
+    }
+}
+
+HashJoinBenchResult run_join(const char *mode, size_t memory, const HashJoinBenchConfig &config,
+                             DiskManager *disk_manager, BufferPoolManager *buffer_pool_manager, BenchTables *tables) {
+    HashJoinBenchResult result;
+    result.mode = mode;
+    result.memory = memory;
+    auto start = bench_clock::now();
+
+    RmOperatorInput orders_dish_input = rm_file_input(tables->orders_dish.get(), buffer_pool_manager);
+    RmHashJoin join1(disk_manager, rm_file_input(tables->orders.get(), buffer_pool_manager), ORDERS_COLS[0],
+                     orders_dish_input, ORDERS_DISH_COLS[0], memory, config.dir + "/join1_");
+    // 第一个连接的输出流作为第二个连接的探测端，不落地
+    RmOperatorInput joined_input;
+    joined_input.source = [&join1](const RmRecordSink &sink) {
+        char joined[JOINED_RECORD_SIZE];
+        join1.run([&](const char *orders_rec, const char *orders_dish_rec) {
+            memcpy(joined, orders_dish_rec, ORDERS_DISH_RECORD_SIZE);
+            memcpy(joined + ORDERS_DISH_RECORD_SIZE, ORDERS_COLS[1].get(orders_rec), sizeof(int));
+            sink(joined);
+        });
+    };
+    joined_input.record_size = JOINED_RECORD_SIZE;
+    joined_input.estimated_rows = orders_dish_input.estimated_rows;
+    RmHashJoin join2(disk_manager, rm_file_input(tables->dish.get(), buffer_pool_manager), DISH_COLS[0],
+                     joined_input, JOINED_DISH_ID, memory, config.dir + "/join2_");
+    join2.run([&](const char *dish_rec, const char *joined_rec) {
+        result.amount += get_int(joined_rec, ORDERS_DISH_COLS[2]) * (double)get_float(dish_rec, DISH_COLS[2]);
+        result.output_rows++;
+    });
+
+    result.sec = std::chrono::duration<double>(bench_clock::now() - start).count();
+    result.join1 = join1.get_stats();
+    result.join2 = join2.get_stats();
+    return result;
+}
+
+bool parse_args(int argc, char **argv, HashJoinBenchConfig *config) {
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        size_t eq = arg.find('=');
+        std::string key = arg.substr(0, eq);
+        std::string value = eq == std::string::npos ? "" : arg.substr(eq + 1);
+        if (key == "--scale") {
+            config->scale = std::max(1, std::atoi(value.c_str()));
+        } else if (key == "--memory") {
+            config->memory = std::strtoull(value.c_str(), nullptr, 10);
+        } else if (key == "--spill-memory") {
+            config->spill_memory = std::strtoull(value.c_str(), nullptr, 10);
+        } else if (key == "--pool") {
+            config->pool_size = std::strtoull(value.c_str(), nullptr, 10);
+        } else if (key == "--dir") {
+            config->dir = value;
+        } else if (key == "--format") {
+            config->json = value == "json";
+        } else {
+            return false;
+        }
+    }
+    return true;
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+    HashJoinBenchConfig config;
+    if (!parse_args(argc, argv, &config)) {
+        fprintf(stderr,
+                "usage: %s [--scale=N] [--memory=BYTES] [--spill-memory=BYTES] [--pool=FRAMES] [--dir=PATH] "
+                "[--format=text|json]\n",
+                argv[0]);
+        return 1;
+    }
+    if (config.pool_size == 0) {
+        // orders_dish平均每个订单3条，再加上余量
+        size_t bytes = (size_t)ORDERS_PER_SCALE * config.scale * (ORDERS_RECORD_SIZE + 3 * ORDERS_DISH_RECORD_SIZE) +
+                       (size_t)SHANGPU_PER_SCALE * DISHES_PER_SHANGPU * config.scale * DISH_RECORD_SIZE;
+        config.pool_size = bytes / (PAGE_SIZE / 2) + 64;
+    }
+
+    DiskManager disk_manager;
+    BufferPoolManager buffer_pool_manager(config.pool_size, &disk_manager);
+    RmManager rm_manager(&disk_manager, &buffer_pool_manager);
+    if (!disk_manager.is_dir(config.dir)) {
+        disk_manager.create_dir(config.dir);
+    }
+    BenchTables tables;
+    tables.orders = create_table(&disk_manager, &rm_manager, config.dir + "/orders", ORDERS_RECORD_SIZE);
+    tables.orders_dish =
+        create_table(&disk_manager, &rm_manager, config.dir + "/orders_dish", ORDERS_DISH_RECORD_SIZE);
+    tables.dish = create_table(&disk_manager, &rm_manager, config.dir + "/dish", DISH_RECORD_SIZE);
+    load_tables(config, &tables);
+    size_t orders_dish_rows = 0;
+    for (RmScan scan(tables.orders_dish.get()); !scan.is_end(); scan.next()) {
+        orders_dish_rows++;
+    }
+
+    std::vector<HashJoinBenchResult> results;
+    results.push_back(run_join("in-memory", config.memory, config, &disk_manager, &buffer_pool_manager, &tables));
+    results.push_back(run_join("spill", config.spill_memory, config, &disk_manager, &buffer_pool_manager, &tables));
+
+    for (std::unique_ptr<RmFileHandle> *file_handle : {&tables.orders, &tables.orders_dish, &tables.dish}) {
+        drop_table(&disk_manager, &rm_manager, file_handle);
+    }
+
+    if (config.json) {
+        printf("{\"scale\":%d,\"orders_dish_rows\":%zu,\"modes\":{", config.scale, orders_dish_rows);
+        for (size_t i = 0; i < results.size(); i++) {
+            const HashJoinBenchResult &r = results[i];
+            printf("%s\"%s\":{\"memory\":%zu,\"sec\":%.4f,\"rows_per_sec\":%.1f,\"output_rows\":%zu,\"sum\":%.2f,"
+                   "\"join1_spilled\":%d,\"join1_partitions\":%d,\"join2_spilled\":%d,\"join2_partitions\":%d,"
+                   "\"probe_filtered\":%zu}",
+                   i == 0 ? "" : ",", r.mode, r.memory, r.sec, orders_dish_rows / r.sec, r.output_rows, r.amount,
+                   r.join1.spilled_partitions, r.join1.num_partitions, r.join2.spilled_partitions,
+                   r.join2.num_partitions, r.join1.probe_filtered + r.join2.probe_filtered);
+        }
+        printf("}}\n");
+    } else {
+        printf("scale=%d orders_dish_rows=%zu\n", config.scale, orders_dish_rows);
+        printf("%-10s %10s %10s %14s %10s %16s %12s %12s %10s\n", "mode", "memory", "sec", "rows/s", "output",
+               "sum", "join1_spill", "join2_spill", "filtered");
+        for (const HashJoinBenchResult &r : results) {
+            printf("%-10s %10zu %10.4f %14.1f %10zu %16.2f %6d/%-5d %6d/%-5d %10zu\n", r.mode, r.memory, r.sec,
+                   orders_dish_rows / r.sec, r.output_rows, r.amount, r.join1.spilled_partitions,
+                   r.join1.num_partitions, r.join2.spilled_partitions, r.join2.num_partitions,
+                   r.join1.probe_filtered + r.join2.probe_filtered);
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,253 @@
+/* Copyright (c) 2023 Renmin University of China
+RMDB is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+        http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+/* 缓冲池和mmap只读访问的基准测试。
+   生成一张--rows条、每条--record-size字节的表，通过RmManager写完并关闭，保证文件头和所有页面都在磁盘上，
+   然后分别用缓冲池（RmManager::open_file）和RmMmapFileHandle读同一个文件：
+     scan  全表扫描，每条记录拷贝出来（RmScan + get_record / RmMmapScan + get_record）
+     get   按随机rid点查--lookups次
+   hot是先完整跑一遍再计时，数据已经在缓冲池或映射区里；
+   cold是每次用新的缓冲池并先posix_fadvise(DONTNEED)丢掉操作系统缓存，测的是第一次访问的开销。
+   输出每种组合的用时和每秒操作数，checksum用来确认两种方式读到的数据一致。
+
+   用法: mmap_bench [--rows=200000] [--record-size=128] [--lookups=200000] [--pool=0] [--dir=mmap_bench_db]
+                    [--format=text|json] */
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "rm_manager.h"
+#include "rm_mmap_file_handle.h"
+#include "rm_scan.h"
+#include "storage/buffer_pool_manager.h"
+#include "storage/disk_manager.h"
+
+namespace {
+
+using bench_clock = std::chrono::steady_clock;
+
+struct MmapBenchConfig {
+    int rows = 200000;
+    int record_size = 128;
+    int lookups = 200000;
+    size_t pool_size = 0;       // 0表示按文件大小自动设置，保证hot时整个文件都在缓冲池里
+    std::string dir = "mmap_bench_db";
+    bool json = false;
+};
+
+struct MmapBenchResult {
+    const char *source;         // bpm / mmap
+    const char *access;         // scan / get
+    const char *cache;          // hot / cold
+    size_t ops = 0;
+    double sec = 0;
+    long long checksum = 0;
+};
+
+// 记录的第2个int是写入时的序号，用来求checksum
+int get_value(const char *rec) {
+    int v;
+    memcpy(&v, rec + sizeof(int), sizeof(int));
+    return v;
+}
+
+// 丢掉文件在操作系统页缓存里的页面，文件已经关闭，页面都是干净的
+void drop_os_cache(const std::string &path) {
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd >= 0) {
+        posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+        close(fd);
+    }
+}
+
+// hot时先不计时跑一遍，再计时跑一遍
+MmapBenchResult measure(const char *source, const char *access, bool cold,
+                        const std::function<size_t(long long *)> &body) {
+    MmapBenchResult result;
+    result.source = source;
+    result.access = access;
+    result.cache = cold ? "cold" : "hot";
+    if (!cold) {
+        body(&result.checksum);
+    }
+    result.checksum = 0;
+    auto start = bench_clock::now();
+    result.ops = body(&result.checksum);
+    result.sec = std::chrono::duration<double>(bench_clock::now() - start).count();
+    return result;
+}
+
+MmapBenchResult run_bpm(const MmapBenchConfig &config, DiskManager *disk_manager, const std::string &path,
+                        const std::vector<Rid> &lookups, bool scan, bool cold) {
+    if (cold) {
+        drop_os_cache(path);
+    }
+    BufferPoolManager buffer_pool_manager(config.pool_size, disk_manager);
+    RmManager rm_manager(disk_manager, &buffer_pool_manager);
+    std::unique_ptr<RmFileHandle> file_handle = rm_manager.open_file(path);
+    MmapBenchResult result;
+    if (scan) {
+        result = measure("bpm", "scan", cold, [&](long long *checksum) {
+            size_t n = 0;
+            for (RmScan rm_scan(file_handle.get()); !rm_scan.is_end(); rm_scan.next()) {
+                *checksum += get_value(file_handle->get_record(rm_scan.rid(), nullptr)->data);
+                n++;
+            }
+            return n;
+        });
+    } else {
+        result = measure("bpm", "get", cold, [&](long long *checksum) {
+            for (const Rid &rid : lookups) {
+                *checksum += get_value(file_handle->get_record(rid, nullptr)->data);
+            }
+            return lookups.size();
+        });
+    }
+    rm_manager.close_file(file_handle.get());
+    return result;
+}
+
+MmapBenchResult run_mmap(const std::string &path, const std::vector<Rid> &lookups, bool scan, bool cold) {
+    if (cold) {
+        drop_os_cache(path);
+    }
+    RmMmapFileHandle file_handle(path, scan ? MMAP_ADVICE_SEQUENTIAL : MMAP_ADVICE_RANDOM);
+    if (scan) {
+        return measure("mmap", "scan", cold, [&](long long *checksum) {
+            size_t n = 0;
+            for (RmMmapScan mmap_scan(&file_handle); !mmap_scan.is_end(); mmap_scan.next()) {
+                *checksum += get_value(file_handle.get_record(mmap_scan.rid())->data);
+                n++;
+            }
+            return n;
+        });
+    }
+    return measure("mmap", "get", cold, [&](long long *checksum) {
+        for (const Rid &rid : lookups) {
+            *checksum += get_value(file_handle.get_record(rid)->data);
+        }
+        return lookups.size();
+    });
+}
+
+bool parse_args(int argc, char **argv, MmapBenchConfig *config) {
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        size_t eq = arg.find('=');
+        std::string key = arg.substr(0, eq);
+        std::string value = eq == std::string::npos ? "" : arg.substr(eq + 1);
+        if (key == "--rows") {
+            config->rows = std::max(1, std::atoi(value.c_str()));
+        } else if (key == "--record-size") {
+            config->record_size = std::max(8, std::atoi(value.c_str()));
+        } else if (key == "--lookups") {
+            config->lookups = std::max(1, std::atoi(value.c_str()));
+        } else if (key == "--pool") {
+            config->pool_size = std::strtoull(value.c_str(), nullptr, 10);
+        } else if (key == "--dir") {
+            config->dir = value;
+        } else if (key == "--format") {
+            config->json = value == "json";
+        } else {
+            return false;
+        }
+    }
+    return true;
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+    MmapBenchConfig config;
+    if (!parse_args(argc, argv, &config)) {
+        fprintf(stderr,
+                "usage: %s [--rows=N] [--record-size=BYTES] [--lookups=N] [--pool=FRAMES] [--dir=PATH] "
+                "[--format=text|json]\n",
+                argv[0]);
+        return 1;
+    }
+
+    DiskManager disk_manager;
+    if (!disk_manager.is_dir(config.dir)) {
+        disk_manager.create_dir(config.dir);
+    }
+    std::string path = config.dir + "/table";
+    if (disk_manager.is_file(path)) {
+        disk_manager.destroy_file(path);
+    }
+
+    // 建表并记下所有rid，关闭文件把文件头和数据页都写回磁盘，mmap才能看到完整的文件
+    std::vector<Rid> rids;
+    int num_pages;
+    {
+        BufferPoolManager buffer_pool_manager(256, &disk_manager);
+        RmManager rm_manager(&disk_manager, &buffer_pool_manager);
+        rm_manager.create_file(path, config.record_size);
+        std::unique_ptr<RmFileHandle> file_handle = rm_manager.open_file(path);
+        std::vector<char> rec(config.record_size, 0);
+        rids.reserve(config.rows);
+        for (int i = 0; i < config.rows; i++) {
+            memcpy(rec.data(), &i, sizeof(int));
+            memcpy(rec.data() + sizeof(int), &i, sizeof(int));
+            rids.push_back(file_handle->insert_record(rec.data(), nullptr));
+        }
+        num_pages = file_handle->get_file_hdr().num_pages;
+        rm_manager.close_file(file_handle.get());
+    }
+    if (config.pool_size == 0) {
+        config.pool_size = num_pages + 64;
+    }
+    std::mt19937_64 rng(42);
+    std::vector<Rid> lookups(config.lookups);
+    for (Rid &rid : lookups) {
+        rid = rids[rng() % rids.size()];
+    }
+
+    std::vector<MmapBenchResult> results;
+    for (bool cold : {false, true}) {
+        for (bool scan : {true, false}) {
+            results.push_back(run_bpm(config, &disk_manager, path, lookups, scan, cold));
+            results.push_back(run_mmap(path, lookups, scan, cold));
+        }
+    }
+    disk_manager.destroy_file(path);
+
+    if (config.json) {
+        printf("{\"rows\":%d,\"record_size\":%d,\"pages\":%d,\"lookups\":%d,\"pool\":%zu,\"results\":[", config.rows,
+               config.record_size, num_pages, config.lookups, config.pool_size);
+        for (size_t i = 0; i < results.size(); i++) {
+            const MmapBenchResult &r = results[i];
+            printf("%s{\"source\":\"%s\",\"access\":\"%s\",\"cache\":\"%s\",\"ops\":%zu,\"sec\":%.4f,"
+                   "\"ops_per_sec\":%.1f,\"checksum\":%lld}",
+                   i == 0 ? "" : ",", r.source, r.access, r.cache, r.ops, r.sec, r.ops / r.sec, r.checksum);
+        }
+        printf("]}\n");
+    } else {
+        printf("rows=%d record_size=%d pages=%d lookups=%d pool=%zu\n", config.rows, config.record_size, num_pages,
+               config.lookups, config.pool_size);
+        printf("%-6s %-6s %-6s %10s %10s %14s %16s\n", "source", "access", "cache", "ops", "sec", "ops/s", "checksum");
+        for (const MmapBenchResult &r : results) {
+            printf("%-6s %-6s %-6s %10zu %10.4f %14.1f %16lld\n", r.source, r.access, r.cache, r.ops, r.sec,
+                   r.ops / r.sec, r.checksum);
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,257 @@
+/* Copyright (c) 2023 Renmin University of China
+RMDB is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+        http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+/* 读写混合负载下表锁和快照读的基准测试。
+   建一张--rows条记录的表，--writers个线程持有表的排他锁随机更新记录，--readers个线程反复全表扫描求和：
+     latch     读者持有表的共享锁，用RmScan + get_record扫描，和写者互相阻塞
+     snapshot  表上挂RmVersionStore，读者不持有表锁，用RmSnapshotScan在快照上扫描
+   snapshot模式另有一个线程每--gc-ms毫秒调用一次gc回收旧版本。
+   每种模式运行--seconds秒，输出每秒写次数、每秒完整扫描次数、版本链的峰值和gc回收的版本数；
+   没有插入和删除，每次扫描都应该读到--rows条记录，读到的条数不对时计入bad_scans。
+
+   用法: mvcc_bench [--rows=20000] [--writers=2] [--readers=2] [--seconds=3] [--gc-ms=10] [--pool=0]
+                    [--dir=mvcc_bench_db] [--format=text|json] */
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <shared_mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "rm_manager.h"
+#include "rm_scan.h"
+#include "rm_version_store.h"
+#include "storage/buffer_pool_manager.h"
+#include "storage/disk_manager.h"
+
+namespace {
+
+using bench_clock = std::chrono::steady_clock;
+
+// 记录格式：| id int | value int | 填充 |
+constexpr int RECORD_SIZE = 64;
+
+struct MvccBenchConfig {
+    int rows = 20000;
+    int writers = 2;
+    int readers = 2;
+    double seconds = 3;
+    int gc_ms = 10;
+    size_t pool_size = 0;       // 0表示按文件大小自动设置
+    std::string dir = "mvcc_bench_db";
+    bool json = false;
+};
+
+struct MvccBenchResult {
+    const char *mode;
+    double sec = 0;
+    size_t writes = 0;
+    size_t scans = 0;
+    size_t bad_scans = 0;
+    size_t peak_versions = 0;
+    size_t gc_removed = 0;
+};
+
+int get_value(const char *rec) {
+    int v;
+    memcpy(&v, rec + sizeof(int), sizeof(int));
+    return v;
+}
+
+MvccBenchResult run_mode(const MvccBenchConfig &config, RmFileHandle *file_handle,
+                         BufferPoolManager *buffer_pool_manager, const std::vector<Rid> &rids, bool snapshot) {
+    MvccBenchResult result;
+    result.mode = snapshot ? "snapshot" : "latch";
+    std::shared_mutex table_latch;
+    std::unique_ptr<RmVersionStore> version_store;
+    if (snapshot) {
+        version_store = std::make_unique<RmVersionStore>(file_handle, buffer_pool_manager);
+    }
+    std::atomic<bool> stop{false};
+    std::atomic<size_t> writes{0}, scans{0}, bad_scans{0}, peak_versions{0}, gc_removed{0};
+
+    std::vector<std::thread> threads;
+    for (int w = 0; w < config.writers; w++) {
+        threads.emplace_back([&, w]() {
+            std::mt19937_64 rng(w + 1);
+            std::vector<char> buf(RECORD_SIZE);
+            size_t n = 0;
+            while (!stop.load(std::memory_order_relaxed)) {
+                const Rid &rid = rids[rng() % rids.size()];
+                std::unique_lock<std::shared_mutex> lock(table_latch);
+                auto record = file_handle->get_record(rid, nullptr);
+                memcpy(buf.data(), record->data, RECORD_SIZE);
+                int value = get_value(buf.data()) + 1;
+                memcpy(buf.data() + sizeof(int), &value, sizeof(int));
+                file_handle->update_record(rid, buf.data(), nullptr);
+                n++;
+            }
+            writes += n;
+        });
+    }
+    for (int r = 0; r < config.readers; r++) {
+        threads.emplace_back([&]() {
+            size_t n = 0, bad = 0;
+            while (!stop.load(std::memory_order_relaxed)) {
+                long long sum = 0;
+                int count = 0;
+                if (snapshot) {
+                    for (RmSnapshotScan scan(file_handle, version_store.get(), buffer_pool_manager); !scan.is_end();
+                         scan.next()) {
+                        sum += get_value(scan.record()->data);
+                        count++;
+                    }
+                } else {
+                    std::shared_lock<std::shared_mutex> lock(table_latch);
+                    for (RmScan scan(file_handle); !scan.is_end(); scan.next()) {
+                        sum += get_value(file_handle->get_record(scan.rid(), nullptr)->data);
+                        count++;
+                    }
+                }
+                n++;
+                if (count != config.rows || sum < 0) {
+                    bad++;
+                }
+            }
+            scans += n;
+            bad_scans += bad;
+        });
+    }
+    if (snapshot) {
+        threads.emplace_back([&]() {
+            while (!stop.load(std::memory_order_relaxed)) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(config.gc_ms));
+                peak_versions = std::max(peak_versions.load(), version_store->num_versions());
+                gc_removed += version_store->gc();
+            }
+        });
+    }
+
+    auto start = bench_clock::now();
+    std::this_thread::sleep_for(std::chrono::duration<double>(config.seconds));
+    stop = true;
+    for (std::thread &t : threads) {
+        t.join();
+    }
+    result.sec = std::chrono::duration<double>(bench_clock::now() - start).count();
+    if (snapshot) {
+        peak_versions = std::max(peak_versions.load(), version_store->num_versions());
+        gc_removed += version_store->gc();
+    }
+    result.writes = writes;
+    result.scans = scans;
+    result.bad_scans = bad_scans;
+    result.peak_versions = peak_versions;
+    result.gc_removed = gc_removed;
+    return result;
+}
+
+bool parse_args(int argc, char **argv, MvccBenchConfig *config) {
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        size_t eq = arg.find('=');
+        std::string key = arg.substr(0, eq);
+        std::string value = eq == std::string::npos ? "" : arg.substr(eq + 1);
+        if (key == "--rows") {
+            config->rows = std::max(1, std::atoi(value.c_str()));
+        } else if (key == "--writers") {
+            config->writers = std::max(0, std::atoi(value.c_str()));
+        } else if (key == "--readers") {
+            config->readers = std::max(0, std::atoi(value.c_str()));
+        } else if (key == "--seconds") {
+            config->seconds = std::max(0.1, std::atof(value.c_str()));
+        } else if (key == "--gc-ms") {
+            config->gc_ms = std::max(1, std::atoi(value.c_str()));
+        } else if (key == "--pool") {
+            config->pool_size = std::strtoull(value.c_str(), nullptr, 10);
+        } else if (key == "--dir") {
+            config->dir = value;
+        } else if (key == "--format") {
+            config->json = value == "json";
+        } else {
+            return false;
+        }
+    }
+    return true;
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+    MvccBenchConfig config;
+    if (!parse_args(argc, argv, &config)) {
+        fprintf(stderr,
+                "usage: %s [--rows=N] [--writers=N] [--readers=N] [--seconds=S] [--gc-ms=MS] [--pool=FRAMES] "
+                "[--dir=PATH] [--format=text|json]\n",
+                argv[0]);
+        return 1;
+    }
+    if (config.pool_size == 0) {
+        config.pool_size = (size_t)config.rows / std::max(1, PAGE_SIZE / RECORD_SIZE - 1) + 64;
+    }
+
+    DiskManager disk_manager;
+    BufferPoolManager buffer_pool_manager(config.pool_size, &disk_manager);
+    RmManager rm_manager(&disk_manager, &buffer_pool_manager);
+    if (!disk_manager.is_dir(config.dir)) {
+        disk_manager.create_dir(config.dir);
+    }
+    std::string path = config.dir + "/table";
+    if (disk_manager.is_file(path)) {
+        disk_manager.destroy_file(path);
+    }
+    rm_manager.create_file(path, RECORD_SIZE);
+    std::unique_ptr<RmFileHandle> file_handle = rm_manager.open_file(path);
+    std::vector<Rid> rids;
+    rids.reserve(config.rows);
+    std::vector<char> rec(RECORD_SIZE, 0);
+    for (int i = 0; i < config.rows; i++) {
+        memcpy(rec.data(), &i, sizeof(int));
+        rids.push_back(file_handle->insert_record(rec.data(), nullptr));
+    }
+
+    std::vector<MvccBenchResult> results;
+    results.push_back(run_mode(config, file_handle.get(), &buffer_pool_manager, rids, false));
+    results.push_back(run_mode(config, file_handle.get(), &buffer_pool_manager, rids, true));
+
+    rm_manager.close_file(file_handle.get());
+    file_handle.reset();
+    disk_manager.destroy_file(path);
+
+    if (config.json) {
+        printf("{\"rows\":%d,\"writers\":%d,\"readers\":%d,\"modes\":{", config.rows, config.writers,
+               config.readers);
+        for (size_t i = 0; i < results.size(); i++) {
+            const MvccBenchResult &r = results[i];
+            printf("%s\"%s\":{\"sec\":%.3f,\"writes_per_sec\":%.1f,\"scans_per_sec\":%.2f,\"bad_scans\":%zu,"
+                   "\"peak_versions\":%zu,\"gc_removed\":%zu}",
+                   i == 0 ? "" : ",", r.mode, r.sec, r.writes / r.sec, r.scans / r.sec, r.bad_scans, r.peak_versions,
+                   r.gc_removed);
+        }
+        printf("}}\n");
+    } else {
+        printf("rows=%d writers=%d readers=%d\n", config.rows, config.writers, config.readers);
+        printf("%-9s %8s %14s %10s %10s %14s %12s\n", "mode", "sec", "writes/s", "scans/s", "bad_scans",
+               "peak_versions", "gc_removed");
+        for (const MvccBenchResult &r : results) {
+            printf("%-9s %8.3f %14.1f %10.2f %10zu %14zu %12zu\n", r.mode, r.sec, r.writes / r.sec, r.scans / r.sec,
+                   r.bad_scans, r.peak_versions, r.gc_removed);
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,216 @@
+/* Copyright (c) 2023 Renmin University of China
+RMDB is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+        http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#include "page_alloc_map.h"
+
+#include <fcntl.h>      // for fallocate
+#include <sys/stat.h>   // for fstat
+#include <unistd.h>     // for pread, pwrite
+
+#include <algorithm>
+#include <cerrno>
+
+#include "errors.h"
+
+/**
+ * @description: 为已经打开的数据文件建立分配表，读入<path>.alloc（如果有）并按文件大小修正
+ * @param {int} fd 数据文件的文件句柄
+ * @param {string} &path 数据文件的路径
+ * @param {int} min_extent_pages 第一次预留的页面数
+ * @param {int} max_extent_pages 一次最多预留的页面数，为0时不预留
+ */
+PageAllocMap::PageAllocMap(int fd, const std::string &path, int min_extent_pages, int max_extent_pages)
+    : fd_(fd),
+      map_path_(map_path(path)),
+      min_extent_pages_(std::max(min_extent_pages, 1)),
+      max_extent_pages_(max_extent_pages),
+      extent_pages_(std::max(min_extent_pages, 1)) {
+    struct stat st;
+    if (fstat(fd_, &st) < 0) {
+        throw UnixError();
+    }
+    load((page_id_t)((st.st_size + PAGE_SIZE - 1) / PAGE_SIZE));
+}
+
+PageAllocMap::~PageAllocMap() {
+    try {
+        store_all();
+    } catch (...) {
+    }
+    if (map_fd_ >= 0) {
+        close(map_fd_);
+    }
+}
+
+void PageAllocMap::set_bit(page_id_t page_no, bool allocated) {
+    size_t byte = page_no / 8;
+    if (byte >= bitmap_.size()) {
+        bitmap_.resize(std::max(byte + 1, bitmap_.size() * 2), 0);
+    }
+    if (allocated) {
+        bitmap_[byte] |= (uint8_t)(1 << (page_no % 8));
+    } else {
+        bitmap_[byte] &= (uint8_t)~(1 << (page_no % 8));
+    }
+}
+
+bool PageAllocMap::is_allocated(page_id_t page_no) const {
+    return page_no >= 0 && page_no < num_pages_ && (bitmap_[page_no / 8] >> (page_no % 8) & 1);
+}
+
+// 读入分配表文件；分配表之后追加的页面（文件大小超出的部分）都算已分配
+void PageAllocMap::load(page_id_t file_pages) {
+    page_id_t stored = 0;
+    map_fd_ = open(map_path_.c_str(), O_RDWR);
+    if (map_fd_ >= 0) {
+        MapHdr hdr;
+        if (pread(map_fd_, &hdr, sizeof(hdr), 0) == (ssize_t)sizeof(hdr) && hdr.magic == MAP_MAGIC &&
+            hdr.num_pages >= 0) {
+            size_t bytes = (hdr.num_pages + 7) / 8;
+            bitmap_.assign(bytes, 0);
+            if (pread(map_fd_, bitmap_.data(), bytes, sizeof(hdr)) == (ssize_t)bytes) {
+                stored = hdr.num_pages;
+            } else {
+                bitmap_.clear();
+            }
+        }
+    }
+    num_pages_ = std::max(stored, file_pages);
+    stored_pages_ = stored;
+    for (page_id_t page_no = 0; page_no < num_pages_; page_no++) {
+        if (page_no >= stored) {
+            set_bit(page_no, true);
+        } else if (!is_allocated(page_no)) {
+            free_pages_.insert(page_no);
+        }
+    }
+    extent_end_ = num_pages_;
+}
+
+// 全量写分配表；没有空洞时删掉分配表文件
+void PageAllocMap::store_all() {
+    if (free_pages_.empty()) {
+        if (map_fd_ >= 0) {
+            close(map_fd_);
+            map_fd_ = -1;
+            unlink(map_path_.c_str());
+        }
+        stored_pages_ = 0;
+        return;
+    }
+    if (map_fd_ < 0) {
+        map_fd_ = open(map_path_.c_str(), O_RDWR | O_CREAT, S_IRUSR | S_IWUSR);
+        if (map_fd_ < 0) {
+            throw UnixError();
+        }
+    }
+    MapHdr hdr{MAP_MAGIC, num_pages_};
+    size_t bytes = (num_pages_ + 7) / 8;
+    bitmap_.resize(std::max(bitmap_.size(), bytes), 0);
+    if (pwrite(map_fd_, &hdr, sizeof(hdr), 0) != (ssize_t)sizeof(hdr) ||
+        pwrite(map_fd_, bitmap_.data(), bytes, sizeof(hdr)) != (ssize_t)bytes ||
+        ftruncate(map_fd_, sizeof(hdr) + bytes) < 0) {
+        throw UnixError();
+    }
+    stored_pages_ = num_pages_;
+}
+
+// 只写page_no所在的一个字节；分配表文件还没有覆盖到这个页面时全量写
+void PageAllocMap::store_page(page_id_t page_no) {
+    if (map_fd_ < 0 || page_no >= stored_pages_ || free_pages_.empty()) {
+        store_all();
+        return;
+    }
+    if (pwrite(map_fd_, &bitmap_[page_no / 8], 1, sizeof(MapHdr) + page_no / 8) != 1) {
+        throw UnixError();
+    }
+}
+
+// 为从page_no开始的一个extent预留磁盘空间，不改变文件大小
+void PageAllocMap::reserve_extent(page_id_t page_no) {
+    if (max_extent_pages_ <= 0) {
+        extent_end_ = std::max(extent_end_, page_no + 1);
+        return;
+    }
+    page_id_t start = std::max(extent_end_, page_no);
+    // 预留只是优化，失败时照常按页写入：文件系统不支持时以后不再预留，空间不足等其他错误下次分配时再试
+    if (fallocate(fd_, FALLOC_FL_KEEP_SIZE, (off_t)start * PAGE_SIZE, (off_t)extent_pages_ * PAGE_SIZE) < 0) {
+        if (errno == EOPNOTSUPP || errno == ENOSYS) {
+            max_extent_pages_ = 0;
+        }
+        // 不能调小：start之前的空间已经预留过
+        extent_end_ = std::max(extent_end_, page_no + 1);
+        return;
+    }
+    extent_end_ = start + extent_pages_;
+    extent_pages_ = std::min(extent_pages_ * 2, std::max(max_extent_pages_, min_extent_pages_));
+}
+
+/**
+ * @description: 分配一个页面，优先复用页号最小的已释放页面
+ * @return {page_id_t} 分配的页号
+ */
+page_id_t PageAllocMap::allocate() {
+    if (!free_pages_.empty()) {
+        page_id_t page_no = *free_pages_.begin();
+        free_pages_.erase(free_pages_.begin());
+        set_bit(page_no, true);
+        store_page(page_no);
+        return page_no;
+    }
+    page_id_t page_no = num_pages_++;
+    set_bit(page_no, true);
+    if (page_no >= extent_end_) {
+        reserve_extent(page_no);
+    }
+    return page_no;
+}
+
+/**
+ * @description: 释放一个页面，之后可以被allocate复用。页面上的数据不再需要，打洞把磁盘空间还给文件系统
+ * @return {bool} 页面原来是否处于已分配状态
+ */
+bool PageAllocMap::deallocate(page_id_t page_no) {
+    if (!is_allocated(page_no)) {
+        return false;
+    }
+    // 打洞只是优化，文件系统不支持时页面保留原来的内容
+    fallocate(fd_, FALLOC_FL_PUNCH_HOLE | FALLOC_FL_KEEP_SIZE, (off_t)page_no * PAGE_SIZE, PAGE_SIZE);
+    set_bit(page_no, false);
+    free_pages_.insert(page_no);
+    store_page(page_no);
+    return true;
+}
+
+/**
+ * @description: 设置文件的页面数：增加时新页面都算已分配，减少时（截断文件）丢弃超出部分的分配信息
+ */
+void PageAllocMap::set_num_pages(page_id_t num_pages) {
+    if (num_pages >= num_pages_) {
+        for (page_id_t page_no = num_pages_; page_no < num_pages; page_no++) {
+            set_bit(page_no, true);
+        }
+        num_pages_ = num_pages;
+        extent_end_ = std::max(extent_end_, num_pages);
+        return;
+    }
+    free_pages_.erase(free_pages_.lower_bound(num_pages), free_pages_.end());
+    for (page_id_t page_no = num_pages; page_no < num_pages_; page_no++) {
+        set_bit(page_no, false);
+    }
+    num_pages_ = num_pages;
+    extent_end_ = num_pages;    // ftruncate会释放文件末尾之后预留的空间
+    store_all();
+}
+
+/**
+ * @description: 把分配表完整写到磁盘
+ */
+void PageAllocMap::sync() { store_all(); }
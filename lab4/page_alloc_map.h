@@ -0,0 +1,80 @@
+/* Copyright (c) 2023 Renmin University of China
+RMDB is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+        http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#pragma once
+
+#include <cstdint>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "common/config.h"
+
+/* 一个数据文件的页面分配表。
+   内存中用bitmap记录每个页面是否已分配，已释放的页号放在有序集合里，分配时优先复用最小的已释放页面；
+   释放页面时在数据文件上打洞，把磁盘空间还给文件系统。
+   没有可复用的页面时从文件末尾分配，并用fallocate一次预留一个extent的磁盘空间，
+   extent从min_extent_pages开始翻倍，最大max_extent_pages，避免文件一页一页地增长产生碎片。
+   文件末尾之前没有空洞时，文件大小就是全部的分配信息，不需要分配表文件；
+   有已释放的页面时才把分配表写到<文件名>.alloc，之后每次释放、复用只写对应的一个字节。
+   打开文件时读入分配表，再用文件大小修正下一个页号：写分配表之后追加的页面都算已分配 */
+class PageAllocMap {
+   public:
+    PageAllocMap(int fd, const std::string &path, int min_extent_pages, int max_extent_pages);
+
+    ~PageAllocMap();
+
+    page_id_t allocate();
+
+    bool deallocate(page_id_t page_no);
+
+    void set_num_pages(page_id_t num_pages);
+
+    void sync();
+
+    bool is_allocated(page_id_t page_no) const;
+
+    page_id_t get_num_pages() const { return num_pages_; }
+
+    size_t get_num_free() const { return free_pages_.size(); }
+
+    page_id_t get_extent_end() const { return extent_end_; }
+
+    static std::string map_path(const std::string &path) { return path + ".alloc"; }
+
+   private:
+    struct MapHdr {
+        uint32_t magic;
+        page_id_t num_pages;    // 分配表覆盖的页面数，bitmap紧跟在文件头后面
+    };
+    static constexpr uint32_t MAP_MAGIC = 0x50414d52;
+
+    void load(page_id_t file_pages);
+
+    void store_all();
+
+    void store_page(page_id_t page_no);
+
+    void reserve_extent(page_id_t page_no);
+
+    void set_bit(page_id_t page_no, bool allocated);
+
+    int fd_;
+    std::string map_path_;
+    int map_fd_ = -1;
+    int min_extent_pages_;
+    int max_extent_pages_;
+    int extent_pages_;              // 下一次预留的extent大小
+    page_id_t num_pages_ = 0;       // 下一个从文件末尾分配的页号
+    page_id_t extent_end_ = 0;      // 已经预留到的页号
+    page_id_t stored_pages_ = 0;    // 分配表文件中bitmap覆盖的页面数
+    std::vector<uint8_t> bitmap_;
+    std::set<page_id_t> free_pages_;
+};
@@ -0,0 +1,216 @@
+/* Copyright (c) 2023 Renmin University of China
+RMDB is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+        http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+/* 并行扫描的扩展性基准测试。
+   按lab3/campustakeaway.sql的orders表生成--rows条记录，执行 select count(*) from orders where price > --min-price：
+     serial    RmScan + get_record，单线程逐条拷贝后过滤（现在应用的写法）
+     parallel  RmParallelScan::count_if，线程数从1开始每次翻倍，直到--threads（默认hardware_concurrency）
+   缓冲池默认能放下整个文件，先扫一遍预热，每种配置重复--repeat次，输出每秒行数和相对单线程并行扫描的加速比。
+
+   用法: parallel_scan_bench [--rows=1000000] [--min-price=45] [--threads=0] [--morsel=16] [--repeat=3] [--pool=0]
+                             [--dir=parallel_scan_bench_db] [--format=text|json] */
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "rm_column.h"
+#include "rm_manager.h"
+#include "rm_parallel_scan.h"
+#include "rm_scan.h"
+#include "storage/buffer_pool_manager.h"
+#include "storage/disk_manager.h"
+
+namespace {
+
+using bench_clock = std::chrono::steady_clock;
+
+// orders表：order_id, user_id, shangpu_id, price, create_time datetime
+const std::vector<RmColumn> ORDERS_COLS = {
+    {TYPE_INT, 0, 4}, {TYPE_INT, 4, 4}, {TYPE_INT, 8, 4}, {TYPE_FLOAT, 12, 4}, {TYPE_STRING, 16, 19}};
+constexpr int ORDERS_RECORD_SIZE = 35;
+constexpr int PRICE_COL = 3;
+
+struct ParallelScanBenchConfig {
+    int rows = 1000000;
+    float min_price = 45;
+    int threads = 0;            // 0表示hardware_concurrency
+    int morsel_pages = 16;
+    int repeat = 3;
+    size_t pool_size = 0;       // 0表示按文件大小自动设置
+    std::string dir = "parallel_scan_bench_db";
+    bool json = false;
+};
+
+struct ParallelScanBenchResult {
+    const char *mode;
+    int threads;
+    double sec = 0;             // repeat次扫描的总用时
+    size_t matched = 0;
+};
+
+float get_float(const char *rec, const RmColumn &col) {
+    float v;
+    memcpy(&v, col.get(rec), sizeof(float));
+    return v;
+}
+
+// 生成一条orders记录，价格在[0, 50)之间均匀分布
+void make_order(char *rec, int order_id, std::mt19937_64 &rng) {
+    memset(rec, 0, ORDERS_RECORD_SIZE);
+    int user_id = rng() % 10000 + 1;
+    int shangpu_id = rng() % 500 + 1;
+    float price = (float)(rng() % 5000) / 100;
+    memcpy(rec + ORDERS_COLS[0].offset, &order_id, sizeof(int));
+    memcpy(rec + ORDERS_COLS[1].offset, &user_id, sizeof(int));
+    memcpy(rec + ORDERS_COLS[2].offset, &shangpu_id, sizeof(int));
+    memcpy(rec + ORDERS_COLS[PRICE_COL].offset, &price, sizeof(float));
+    snprintf(rec + ORDERS_COLS[4].offset, ORDERS_COLS[4].len, "2024-10-%02d 12:00:00", order_id % 28 + 1);
+}
+
+// 先扫一遍预热，再计时重复repeat次
+ParallelScanBenchResult measure(const char *mode, int threads, int repeat, const std::function<size_t()> &scan) {
+    ParallelScanBenchResult result;
+    result.mode = mode;
+    result.threads = threads;
+    scan();
+    auto start = bench_clock::now();
+    for (int i = 0; i < repeat; i++) {
+        result.matched = scan();
+    }
+    result.sec = std::chrono::duration<double>(bench_clock::now() - start).count();
+    return result;
+}
+
+bool parse_args(int argc, char **argv, ParallelScanBenchConfig *config) {
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        size_t eq = arg.find('=');
+        std::string key = arg.substr(0, eq);
+        std::string value = eq == std::string::npos ? "" : arg.substr(eq + 1);
+        if (key == "--rows") {
+            config->rows = std::max(1, std::atoi(value.c_str()));
+        } else if (key == "--min-price") {
+            config->min_price = std::atof(value.c_str());
+        } else if (key == "--threads") {
+            config->threads = std::max(0, std::atoi(value.c_str()));
+        } else if (key == "--morsel") {
+            config->morsel_pages = std::max(1, std::atoi(value.c_str()));
+        } else if (key == "--repeat") {
+            config->repeat = std::max(1, std::atoi(value.c_str()));
+        } else if (key == "--pool") {
+            config->pool_size = std::strtoull(value.c_str(), nullptr, 10);
+        } else if (key == "--dir") {
+            config->dir = value;
+        } else if (key == "--format") {
+            config->json = value == "json";
+        } else {
+            return false;
+        }
+    }
+    return true;
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+    ParallelScanBenchConfig config;
+    if (!parse_args(argc, argv, &config)) {
+        fprintf(stderr,
+                "usage: %s [--rows=N] [--min-price=P] [--threads=N] [--morsel=PAGES] [--repeat=N] [--pool=FRAMES] "
+                "[--dir=PATH] [--format=text|json]\n",
+                argv[0]);
+        return 1;
+    }
+    if (config.threads == 0) {
+        config.threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    if (config.pool_size == 0) {
+        config.pool_size = (size_t)config.rows / std::max(1, PAGE_SIZE / ORDERS_RECORD_SIZE - 1) + 64;
+    }
+
+    DiskManager disk_manager;
+    BufferPoolManager buffer_pool_manager(config.pool_size, &disk_manager);
+    RmManager rm_manager(&disk_manager, &buffer_pool_manager);
+    if (!disk_manager.is_dir(config.dir)) {
+        disk_manager.create_dir(config.dir);
+    }
+    std::string path = config.dir + "/orders";
+    if (disk_manager.is_file(path)) {
+        disk_manager.destroy_file(path);
+    }
+    rm_manager.create_file(path, ORDERS_RECORD_SIZE);
+    std::unique_ptr<RmFileHandle> file_handle = rm_manager.open_file(path);
+    std::mt19937_64 rng(42);
+    std::vector<char> rec(ORDERS_RECORD_SIZE);
+    for (int i = 1; i <= config.rows; i++) {
+        make_order(rec.data(), i, rng);
+        file_handle->insert_record(rec.data(), nullptr);
+    }
+    const RmColumn &price_col = ORDERS_COLS[PRICE_COL];
+    auto pred = [&](const char *record) { return get_float(record, price_col) > config.min_price; };
+
+    std::vector<ParallelScanBenchResult> results;
+    results.push_back(measure("serial", 1, config.repeat, [&]() {
+        size_t matched = 0;
+        for (RmScan scan(file_handle.get()); !scan.is_end(); scan.next()) {
+            if (pred(file_handle->get_record(scan.rid(), nullptr)->data)) {
+                matched++;
+            }
+        }
+        return matched;
+    }));
+    std::vector<int> thread_counts;
+    for (int threads = 1; threads < config.threads; threads *= 2) {
+        thread_counts.push_back(threads);
+    }
+    thread_counts.push_back(config.threads);
+    for (int threads : thread_counts) {
+        results.push_back(measure("parallel", threads, config.repeat, [&]() {
+            RmParallelScan scan(file_handle.get(), &buffer_pool_manager, threads, config.morsel_pages);
+            return scan.count_if(pred);
+        }));
+    }
+
+    int num_pages = file_handle->get_file_hdr().num_pages;
+    rm_manager.close_file(file_handle.get());
+    file_handle.reset();
+    disk_manager.destroy_file(path);
+
+    double total_rows = (double)config.rows * config.repeat;
+    double base_sec = results[1].sec;   // 单线程的并行扫描
+    if (config.json) {
+        printf("{\"rows\":%d,\"pages\":%d,\"repeat\":%d,\"morsel\":%d,\"results\":[", config.rows, num_pages,
+               config.repeat, config.morsel_pages);
+        for (size_t i = 0; i < results.size(); i++) {
+            const ParallelScanBenchResult &r = results[i];
+            printf("%s{\"mode\":\"%s\",\"threads\":%d,\"sec\":%.4f,\"rows_per_sec\":%.1f,\"speedup\":%.2f,"
+                   "\"matched\":%zu}",
+                   i == 0 ? "" : ",", r.mode, r.threads, r.sec, total_rows / r.sec, base_sec / r.sec, r.matched);
+        }
+        printf("]}\n");
+    } else {
+        printf("rows=%d pages=%d repeat=%d morsel=%d\n", config.rows, num_pages, config.repeat, config.morsel_pages);
+        printf("%-9s %8s %10s %14s %8s %10s\n", "mode", "threads", "sec", "rows/s", "speedup", "matched");
+        for (const ParallelScanBenchResult &r : results) {
+            printf("%-9s %8d %10.4f %14.1f %8.2f %10zu\n", r.mode, r.threads, r.sec, total_rows / r.sec,
+                   base_sec / r.sec, r.matched);
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,294 @@
+/* Copyright (c) 2023 Renmin University of China
+RMDB is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+        http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+/* 行存和PAX布局的分析型扫描基准测试。
+   按lab3/campustakeaway.sql的dish表生成--rows条记录，同样的数据分别写进普通记录文件和PAX文件，
+   然后对整张表求sum(price)和avg(dish_score)，比较三种扫描：
+     row       RmScan + get_record，每条记录整行拷贝出来（现在应用的写法）
+     row-page  在pin住的页面里直接读slot中的两列，不拷贝整行
+     pax       RmPaxScan只取price和dish_score两列的列批，在连续数组上求和
+   缓冲池默认能放下两个文件，先扫一遍预热，测的是数据都在内存中时的CPU开销。
+   每种扫描重复--repeat次，输出每秒行数和用perf_event统计的每行缓存未命中数（不支持时输出-1）。
+
+   用法: pax_bench [--rows=200000] [--repeat=5] [--pool=0] [--dir=pax_bench_db] [--format=text|json] */
+
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "rm_manager.h"
+#include "rm_parallel_scan.h"
+#include "rm_pax_file_handle.h"
+#include "rm_scan.h"
+#include "storage/buffer_pool_manager.h"
+#include "storage/disk_manager.h"
+
+namespace {
+
+using bench_clock = std::chrono::steady_clock;
+
+// dish表：dish_id, shangpu_id, dish_name varchar(50), dish_text text, price, dish_score
+const std::vector<RmColumn> DISH_COLS = {{TYPE_INT, 0, 4},    {TYPE_INT, 4, 4},     {TYPE_STRING, 8, 50},
+                                         {TYPE_STRING, 58, 128}, {TYPE_FLOAT, 186, 4}, {TYPE_FLOAT, 190, 4}};
+constexpr int DISH_RECORD_SIZE = 194;
+constexpr int PRICE_COL = 4;
+constexpr int SCORE_COL = 5;
+
+struct PaxBenchConfig {
+    int rows = 200000;
+    int repeat = 5;
+    size_t pool_size = 0;       // 0表示按两个文件的大小自动设置
+    std::string dir = "pax_bench_db";
+    bool json = false;
+};
+
+struct PaxBenchResult {
+    const char *mode;
+    double sec = 0;             // repeat次扫描的总用时
+    long long cache_misses = -1;
+    double price_sum = 0;
+    double score_avg = 0;
+};
+
+/* 用perf_event统计本线程的硬件缓存未命中数，容器里没有权限时valid()为false */
+class CacheMissCounter {
+   public:
+    CacheMissCounter() {
+        perf_event_attr attr;
+        memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.config = PERF_COUNT_HW_CACHE_MISSES;
+        attr.disabled = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        fd_ = syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+    }
+
+    ~CacheMissCounter() {
+        if (fd_ >= 0) {
+            close(fd_);
+        }
+    }
+
+    bool valid() const { return fd_ >= 0; }
+
+    void start() {
+        if (fd_ >= 0) {
+            ioctl(fd_, PERF_EVENT_IOC_RESET, 0);
+            ioctl(fd_, PERF_EVENT_IOC_ENABLE, 0);
+        }
+    }
+
+    long long stop() {
+        long long count = -1;
+        if (fd_ >= 0) {
+            ioctl(fd_, PERF_EVENT_IOC_DISABLE, 0);
+            if (read(fd_, &count, sizeof(count)) != sizeof(count)) {
+                count = -1;
+            }
+        }
+        return count;
+    }
+
+   private:
+    int fd_ = -1;
+};
+
+float get_float(const char *rec, const RmColumn &col) {
+    float v;
+    memcpy(&v, col.get(rec), sizeof(float));
+    return v;
+}
+
+// 生成一条dish记录，价格和评分随机
+void make_dish(char *rec, int dish_id, std::mt19937_64 &rng) {
+    memset(rec, 0, DISH_RECORD_SIZE);
+    int shangpu_id = (dish_id - 1) / 20 + 1;
+    float price = (float)(rng() % 5000) / 100;
+    float score = (float)(rng() % 50) / 10;
+    memcpy(rec + DISH_COLS[0].offset, &dish_id, sizeof(int));
+    memcpy(rec + DISH_COLS[1].offset, &shangpu_id, sizeof(int));
+    snprintf(rec + DISH_COLS[2].offset, DISH_COLS[2].len, "dish_%d", dish_id);
+    snprintf(rec + DISH_COLS[3].offset, DISH_COLS[3].len, "description of dish %d", dish_id);
+    memcpy(rec + DISH_COLS[PRICE_COL].offset, &price, sizeof(float));
+    memcpy(rec + DISH_COLS[SCORE_COL].offset, &score, sizeof(float));
+}
+
+// 把一种扫描重复repeat次，第一次之前先扫一遍预热
+PaxBenchResult measure(const char *mode, int repeat, const std::function<void(double *, double *, size_t *)> &scan) {
+    PaxBenchResult result;
+    result.mode = mode;
+    double price_sum = 0, score_sum = 0;
+    size_t rows = 0;
+    scan(&price_sum, &score_sum, &rows);
+
+    CacheMissCounter counter;
+    counter.start();
+    auto start = bench_clock::now();
+    for (int i = 0; i < repeat; i++) {
+        price_sum = score_sum = 0;
+        rows = 0;
+        scan(&price_sum, &score_sum, &rows);
+    }
+    result.sec = std::chrono::duration<double>(bench_clock::now() - start).count();
+    result.cache_misses = counter.stop();
+    result.price_sum = price_sum;
+    result.score_avg = rows == 0 ? 0 : score_sum / rows;
+    return result;
+}
+
+bool parse_args(int argc, char **argv, PaxBenchConfig *config) {
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        size_t eq = arg.find('=');
+        std::string key = arg.substr(0, eq);
+        std::string value = eq == std::string::npos ? "" : arg.substr(eq + 1);
+        if (key == "--rows") {
+            config->rows = std::max(1, std::atoi(value.c_str()));
+        } else if (key == "--repeat") {
+            config->repeat = std::max(1, std::atoi(value.c_str()));
+        } else if (key == "--pool") {
+            config->pool_size = std::strtoull(value.c_str(), nullptr, 10);
+        } else if (key == "--dir") {
+            config->dir = value;
+        } else if (key == "--format") {
+            config->json = value == "json";
+        } else {
+            return false;
+        }
+    }
+    return true;
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+    PaxBenchConfig config;
+    if (!parse_args(argc, argv, &config)) {
+        fprintf(stderr, "usage: %s [--rows=N] [--repeat=N] [--pool=FRAMES] [--dir=PATH] [--format=text|json]\n",
+                argv[0]);
+        return 1;
+    }
+    if (config.pool_size == 0) {
+        // 行存每页约PAGE_SIZE/DISH_RECORD_SIZE条，两个文件加上余量
+        config.pool_size = (size_t)config.rows / std::max(1, PAGE_SIZE / DISH_RECORD_SIZE - 1) * 2 + 64;
+    }
+
+    DiskManager disk_manager;
+    BufferPoolManager buffer_pool_manager(config.pool_size, &disk_manager);
+    RmManager rm_manager(&disk_manager, &buffer_pool_manager);
+    if (!disk_manager.is_dir(config.dir)) {
+        disk_manager.create_dir(config.dir);
+    }
+    std::string row_path = config.dir + "/dish_row";
+    std::string pax_path = config.dir + "/dish_pax";
+    for (const std::string &path : {row_path, pax_path}) {
+        if (disk_manager.is_file(path)) {
+            disk_manager.destroy_file(path);
+        }
+    }
+    rm_manager.create_file(row_path, DISH_RECORD_SIZE);
+    std::unique_ptr<RmFileHandle> row_file = rm_manager.open_file(row_path);
+    RmPaxFileHandle::create_file(&disk_manager, pax_path, DISH_RECORD_SIZE, DISH_COLS);
+    int pax_fd = disk_manager.open_file(pax_path);
+    auto pax_file = std::make_unique<RmPaxFileHandle>(&disk_manager, &buffer_pool_manager, pax_fd);
+
+    std::mt19937_64 rng(42);
+    std::vector<char> rec(DISH_RECORD_SIZE);
+    for (int i = 1; i <= config.rows; i++) {
+        make_dish(rec.data(), i, rng);
+        row_file->insert_record(rec.data(), nullptr);
+        pax_file->insert_record(rec.data(), nullptr);
+    }
+    const RmColumn &price_col = DISH_COLS[PRICE_COL];
+    const RmColumn &score_col = DISH_COLS[SCORE_COL];
+
+    std::vector<PaxBenchResult> results;
+    results.push_back(measure("row", config.repeat, [&](double *price_sum, double *score_sum, size_t *rows) {
+        for (RmScan scan(row_file.get()); !scan.is_end(); scan.next()) {
+            auto record = row_file->get_record(scan.rid(), nullptr);
+            *price_sum += get_float(record->data, price_col);
+            *score_sum += get_float(record->data, score_col);
+            (*rows)++;
+        }
+    }));
+    results.push_back(measure("row-page", config.repeat, [&](double *price_sum, double *score_sum, size_t *rows) {
+        RmParallelScan scan(row_file.get(), &buffer_pool_manager, 1);
+        scan.run([&](int worker_id, const Rid &rid, const char *record) {
+            *price_sum += get_float(record, price_col);
+            *score_sum += get_float(record, score_col);
+            (*rows)++;
+        });
+    }));
+    results.push_back(measure("pax", config.repeat, [&](double *price_sum, double *score_sum, size_t *rows) {
+        RmPaxScan scan(pax_file.get(), {PRICE_COL, SCORE_COL});
+        RmColumnBatch batch;
+        while (scan.next_batch(&batch)) {
+            const float *prices = batch.column<float>(0);
+            const float *scores = batch.column<float>(1);
+            int n = batch.num_rows();
+            float batch_price = 0, batch_score = 0;
+            for (int i = 0; i < n; i++) {
+                batch_price += prices[i];
+                batch_score += scores[i];
+            }
+            *price_sum += batch_price;
+            *score_sum += batch_score;
+            *rows += n;
+        }
+    }));
+
+    int row_pages = row_file->get_file_hdr().num_pages;
+    int pax_pages = pax_file->get_file_hdr().num_pages;
+    rm_manager.close_file(row_file.get());
+    row_file.reset();
+    pax_file->flush_file_hdr();
+    buffer_pool_manager.delete_all_pages(pax_fd);
+    pax_file.reset();
+    disk_manager.close_file(pax_fd);
+    disk_manager.destroy_file(row_path);
+    disk_manager.destroy_file(pax_path);
+
+    double total_rows = (double)config.rows * config.repeat;
+    if (config.json) {
+        printf("{\"rows\":%d,\"repeat\":%d,\"row_pages\":%d,\"pax_pages\":%d,\"modes\":{", config.rows, config.repeat,
+               row_pages, pax_pages);
+        for (size_t i = 0; i < results.size(); i++) {
+            const PaxBenchResult &r = results[i];
+            printf("%s\"%s\":{\"sec\":%.4f,\"rows_per_sec\":%.1f,\"cache_misses_per_row\":%.3f,\"price_sum\":%.2f,"
+                   "\"score_avg\":%.4f}",
+                   i == 0 ? "" : ",", r.mode, r.sec, total_rows / r.sec,
+                   r.cache_misses < 0 ? -1.0 : r.cache_misses / total_rows, r.price_sum, r.score_avg);
+        }
+        printf("}}\n");
+    } else {
+        printf("rows=%d repeat=%d pages: row=%d pax=%d\n", config.rows, config.repeat, row_pages, pax_pages);
+        printf("%-10s %12s %14s %14s %14s %10s\n", "mode", "sec", "rows/s", "misses/row", "sum(price)", "avg(score)");
+        for (const PaxBenchResult &r : results) {
+            printf("%-10s %12.4f %14.1f %14.3f %14.2f %10.4f\n", r.mode, r.sec, total_rows / r.sec,
+                   r.cache_misses < 0 ? -1.0 : r.cache_misses / total_rows, r.price_sum, r.score_avg);
+        }
+    }
+    return 0;
+}
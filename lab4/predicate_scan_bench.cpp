@@ -0,0 +1,234 @@
+/* Copyright (c) 2023 Renmin University of China
+RMDB is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+        http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+/* 谓词下推扫描的基准测试。
+   按lab3/campustakeaway.sql的orders表生成--rows条记录，price在[0, 50)上按0.01均匀分布，
+   对每个选择率s（--selectivity，默认0.1%、1%、10%、50%、100%）执行
+     select sum(price) from orders where price < 50 * s
+   比较两种扫描：
+     scan       RmScan + get_record，每条记录拷贝出来再判断条件（现在应用的写法）
+     predicate  RmPredicateScan，在pin住的页面上直接求值，只拷贝满足条件的记录
+   缓冲池默认能放下整个文件，先扫一遍预热，每种配置重复--repeat次，输出每秒扫描的行数和相对scan的加速比。
+
+   用法: predicate_scan_bench [--rows=1000000] [--selectivity=0.001,0.01,0.1,0.5,1] [--repeat=3] [--pool=0]
+                              [--dir=predicate_scan_bench_db] [--format=text|json] */
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "rm_column.h"
+#include "rm_manager.h"
+#include "rm_predicate.h"
+#include "rm_predicate_scan.h"
+#include "rm_scan.h"
+#include "storage/buffer_pool_manager.h"
+#include "storage/disk_manager.h"
+
+namespace {
+
+using bench_clock = std::chrono::steady_clock;
+
+// orders表：order_id, user_id, shangpu_id, price, create_time datetime
+const std::vector<RmColumn> ORDERS_COLS = {
+    {TYPE_INT, 0, 4}, {TYPE_INT, 4, 4}, {TYPE_INT, 8, 4}, {TYPE_FLOAT, 12, 4}, {TYPE_STRING, 16, 19}};
+constexpr int ORDERS_RECORD_SIZE = 35;
+constexpr int PRICE_COL = 3;
+constexpr int PRICE_STEPS = 5000;   // price = (0..4999) / 100
+
+struct PredicateScanBenchConfig {
+    int rows = 1000000;
+    std::vector<double> selectivities = {0.001, 0.01, 0.1, 0.5, 1};
+    int repeat = 3;
+    size_t pool_size = 0;       // 0表示按文件大小自动设置
+    std::string dir = "predicate_scan_bench_db";
+    bool json = false;
+};
+
+struct PredicateScanBenchResult {
+    double selectivity;
+    const char *mode;
+    double sec = 0;             // repeat次扫描的总用时
+    size_t matched = 0;
+    double price_sum = 0;
+};
+
+float get_float(const char *rec, const RmColumn &col) {
+    float v;
+    memcpy(&v, rec + col.offset, sizeof(float));
+    return v;
+}
+
+// 生成一条orders记录，price在PRICE_STEPS个取值上均匀分布
+void make_order(char *rec, int order_id, std::mt19937_64 &rng) {
+    memset(rec, 0, ORDERS_RECORD_SIZE);
+    int user_id = rng() % 10000 + 1;
+    int shangpu_id = rng() % 500 + 1;
+    float price = (float)(rng() % PRICE_STEPS) / 100;
+    memcpy(rec + ORDERS_COLS[0].offset, &order_id, sizeof(int));
+    memcpy(rec + ORDERS_COLS[1].offset, &user_id, sizeof(int));
+    memcpy(rec + ORDERS_COLS[2].offset, &shangpu_id, sizeof(int));
+    memcpy(rec + ORDERS_COLS[PRICE_COL].offset, &price, sizeof(float));
+    snprintf(rec + ORDERS_COLS[4].offset, ORDERS_COLS[4].len, "2024-10-%02d 12:00:00", order_id % 28 + 1);
+}
+
+// 先扫一遍预热，再计时重复repeat次；scan返回满足条件的行数，并累加price
+PredicateScanBenchResult measure(double selectivity, const char *mode, int repeat,
+                                 const std::function<size_t(double *)> &scan) {
+    PredicateScanBenchResult result;
+    result.selectivity = selectivity;
+    result.mode = mode;
+    double price_sum = 0;
+    scan(&price_sum);
+    auto start = bench_clock::now();
+    for (int i = 0; i < repeat; i++) {
+        price_sum = 0;
+        result.matched = scan(&price_sum);
+    }
+    result.sec = std::chrono::duration<double>(bench_clock::now() - start).count();
+    result.price_sum = price_sum;
+    return result;
+}
+
+bool parse_args(int argc, char **argv, PredicateScanBenchConfig *config) {
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        size_t eq = arg.find('=');
+        std::string key = arg.substr(0, eq);
+        std::string value = eq == std::string::npos ? "" : arg.substr(eq + 1);
+        if (key == "--rows") {
+            config->rows = std::max(1, std::atoi(value.c_str()));
+        } else if (key == "--selectivity") {
+            config->selectivities.clear();
+            std::stringstream ss(value);
+            std::string item;
+            while (std::getline(ss, item, ',')) {
+                config->selectivities.push_back(std::min(1.0, std::max(0.0, std::atof(item.c_str()))));
+            }
+            if (config->selectivities.empty()) {
+                return false;
+            }
+        } else if (key == "--repeat") {
+            config->repeat = std::max(1, std::atoi(value.c_str()));
+        } else if (key == "--pool") {
+            config->pool_size = std::strtoull(value.c_str(), nullptr, 10);
+        } else if (key == "--dir") {
+            config->dir = value;
+        } else if (key == "--format") {
+            config->json = value == "json";
+        } else {
+            return false;
+        }
+    }
+    return true;
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+    PredicateScanBenchConfig config;
+    if (!parse_args(argc, argv, &config)) {
+        fprintf(stderr,
+                "usage: %s [--rows=N] [--selectivity=S1,S2,...] [--repeat=N] [--pool=FRAMES] [--dir=PATH] "
+                "[--format=text|json]\n",
+                argv[0]);
+        return 1;
+    }
+    if (config.pool_size == 0) {
+        config.pool_size = (size_t)config.rows / std::max(1, PAGE_SIZE / ORDERS_RECORD_SIZE - 1) + 64;
+    }
+
+    DiskManager disk_manager;
+    BufferPoolManager buffer_pool_manager(config.pool_size, &disk_manager);
+    RmManager rm_manager(&disk_manager, &buffer_pool_manager);
+    if (!disk_manager.is_dir(config.dir)) {
+        disk_manager.create_dir(config.dir);
+    }
+    std::string path = config.dir + "/orders";
+    if (disk_manager.is_file(path)) {
+        disk_manager.destroy_file(path);
+    }
+    rm_manager.create_file(path, ORDERS_RECORD_SIZE);
+    std::unique_ptr<RmFileHandle> file_handle = rm_manager.open_file(path);
+    std::mt19937_64 rng(42);
+    std::vector<char> rec(ORDERS_RECORD_SIZE);
+    for (int i = 1; i <= config.rows; i++) {
+        make_order(rec.data(), i, rng);
+        file_handle->insert_record(rec.data(), nullptr);
+    }
+    const RmColumn &price_col = ORDERS_COLS[PRICE_COL];
+
+    std::vector<PredicateScanBenchResult> results;
+    for (double selectivity : config.selectivities) {
+        // 取PRICE_STEPS * s个最小的价格，s = 1时上界50大于所有价格
+        float bound = (float)std::round(PRICE_STEPS * selectivity) / 100;
+        std::vector<char> value(sizeof(float));
+        memcpy(value.data(), &bound, sizeof(float));
+        results.push_back(measure(selectivity, "scan", config.repeat, [&](double *price_sum) {
+            size_t matched = 0;
+            for (RmScan scan(file_handle.get()); !scan.is_end(); scan.next()) {
+                auto record = file_handle->get_record(scan.rid(), nullptr);
+                float price = get_float(record->data, price_col);
+                if (price < bound) {
+                    *price_sum += price;
+                    matched++;
+                }
+            }
+            return matched;
+        }));
+        results.push_back(measure(selectivity, "predicate", config.repeat, [&](double *price_sum) {
+            size_t matched = 0;
+            RmPredicate pred({RmCondition{price_col, OP_LT, value}});
+            for (RmPredicateScan scan(file_handle.get(), &buffer_pool_manager, pred); !scan.is_end(); scan.next()) {
+                *price_sum += get_float(scan.record(), price_col);
+                matched++;
+            }
+            return matched;
+        }));
+    }
+
+    rm_manager.close_file(file_handle.get());
+    file_handle.reset();
+    disk_manager.destroy_file(path);
+
+    double total_rows = (double)config.rows * config.repeat;
+    if (config.json) {
+        printf("{\"rows\":%d,\"repeat\":%d,\"results\":[", config.rows, config.repeat);
+        for (size_t i = 0; i < results.size(); i++) {
+            const PredicateScanBenchResult &r = results[i];
+            const PredicateScanBenchResult &base = results[i / 2 * 2];
+            printf("%s{\"selectivity\":%g,\"mode\":\"%s\",\"sec\":%.4f,\"rows_per_sec\":%.1f,\"speedup\":%.2f,"
+                   "\"matched\":%zu,\"price_sum\":%.2f}",
+                   i == 0 ? "" : ",", r.selectivity, r.mode, r.sec, total_rows / r.sec, base.sec / r.sec, r.matched,
+                   r.price_sum);
+        }
+        printf("]}\n");
+    } else {
+        printf("rows=%d repeat=%d\n", config.rows, config.repeat);
+        printf("%-11s %-10s %10s %14s %8s %10s %14s\n", "selectivity", "mode", "sec", "rows/s", "speedup", "matched",
+               "sum(price)");
+        for (size_t i = 0; i < results.size(); i++) {
+            const PredicateScanBenchResult &r = results[i];
+            const PredicateScanBenchResult &base = results[i / 2 * 2];
+            printf("%-11g %-10s %10.4f %14.1f %8.2f %10zu %14.2f\n", r.selectivity, r.mode, r.sec, total_rows / r.sec,
+                   base.sec / r.sec, r.matched, r.price_sum);
+        }
+    }
+    return 0;
+}
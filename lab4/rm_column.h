@@ -0,0 +1,70 @@
+/* Copyright (c) 2023 Renmin University of China
+RMDB is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+        http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+
+#include "defs.h"
+#include "errors.h"
+
+/* 记录中一列的物理描述：类型、在记录中的偏移和长度。
+   是ColMeta去掉表名、列名等元信息后的精简版，记录层的算子只需要这几个字段就能直接在slot字节上取值 */
+struct RmColumn {
+    ColType type;   // 列的类型，TYPE_INT / TYPE_FLOAT / TYPE_STRING
+    int offset;     // 列在记录中的偏移
+    int len;        // 列的长度
+
+    // 返回这一列在记录rec中的首地址
+    const char *get(const char *rec) const { return rec + offset; }
+};
+
+/**
+ * @description: 按列类型比较两个列值
+ * @return {int} a<b返回负数，a==b返回0，a>b返回正数
+ */
+inline int rm_compare(const char *a, const char *b, ColType type, int len) {
+    // slot在页面中不一定按4字节对齐，用memcpy取值
+    switch (type) {
+        case TYPE_INT: {
+            int ia, ib;
+            memcpy(&ia, a, sizeof(int));
+            memcpy(&ib, b, sizeof(int));
+            return (ia < ib) ? -1 : ((ia > ib) ? 1 : 0);
+        }
+        case TYPE_FLOAT: {
+            float fa, fb;
+            memcpy(&fa, a, sizeof(float));
+            memcpy(&fb, b, sizeof(float));
+            return (fa < fb) ? -1 : ((fa > fb) ? 1 : 0);
+        }
+        case TYPE_STRING:
+            return memcmp(a, b, len);
+        default:
+            throw InternalError("Unexpected data type");
+    }
+}
+
+/**
+ * @description: 列值的64位哈希，直接对字节做FNV-1a再做一次混合，
+ *               高位用来做分区（radix partition），低位用来定位桶
+ */
+inline uint64_t rm_hash(const char *data, int len) {
+    uint64_t h = 14695981039346656037ULL;
+    for (int i = 0; i < len; i++) {
+        h ^= static_cast<unsigned char>(data[i]);
+        h *= 1099511628211ULL;
+    }
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    return h;
+}
@@ -0,0 +1,135 @@
+/* Copyright (c) 2023 Renmin University of China
+RMDB is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+        http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#include "rm_compactor.h"
+
+#include <algorithm>
+#include <chrono>
+#include <mutex>
+#include <thread>
+
+/**
+ * @description: 创建整理任务，两个指针分别指向第一个记录页和最后一个页面
+ * @param {RmFileHandle*} file_handle 要整理的记录文件
+ * @param {BufferPoolManager*} buffer_pool_manager
+ * @param {shared_mutex*} table_latch 前台操作使用的表锁，为空时调用方自己保证没有并发访问
+ * @param {RmCompactOptions} options 批大小和限速
+ */
+RmCompactor::RmCompactor(RmFileHandle *file_handle, BufferPoolManager *buffer_pool_manager,
+                         std::shared_mutex *table_latch, RmCompactOptions options)
+    : file_handle_(file_handle),
+      buffer_pool_manager_(buffer_pool_manager),
+      table_latch_(table_latch),
+      options_(options) {
+    options_.batch_records = std::max(options_.batch_records, 1);
+    RmFileHdr file_hdr = file_handle_->get_file_hdr();
+    lo_ = RM_FIRST_RECORD_PAGE;
+    hi_ = file_hdr.num_pages - 1;
+    stats_.pages_before = file_hdr.num_pages;
+    stats_.pages_after = file_hdr.num_pages;
+}
+
+/**
+ * @description: 在表锁下搬一批记录，两个指针相遇后截掉文件末尾的空页（有快照时RmFileHandle会跳过截断）
+ * @return {bool} 整理是否已经完成
+ */
+bool RmCompactor::step() {
+    if (done_) {
+        return true;
+    }
+    std::unique_lock<std::shared_mutex> lock;
+    if (table_latch_ != nullptr) {
+        lock = std::unique_lock<std::shared_mutex>(*table_latch_);
+    }
+    stats_.batches++;
+    if (move_batch()) {
+        stats_.pages_after = options_.truncate_tail ? file_handle_->truncate_empty_tail()
+                                                    : file_handle_->get_file_hdr().num_pages;
+        done_ = true;
+    }
+    return done_;
+}
+
+// 搬至多batch_records条记录，返回两个指针是否已经相遇
+bool RmCompactor::move_batch() {
+    RmFileHdr file_hdr = file_handle_->get_file_hdr();
+    int n = file_hdr.num_records_per_page;
+    hi_ = std::min(hi_, file_hdr.num_pages - 1);
+
+    for (int moved = 0; moved < options_.batch_records;) {
+        if (lo_ >= hi_) {
+            return true;
+        }
+        RmPageHandle dst = file_handle_->fetch_page_handle(lo_);
+        int dst_slot = Bitmap::first_bit(false, dst.bitmap, n);
+        buffer_pool_manager_->unpin_page(dst.page->get_page_id(), false);
+        if (dst_slot == n) {
+            lo_++;
+            continue;
+        }
+        RmPageHandle src = file_handle_->fetch_page_handle(hi_);
+        int src_slot = Bitmap::first_bit(true, src.bitmap, n);
+        buffer_pool_manager_->unpin_page(src.page->get_page_id(), false);
+        if (src_slot == n) {
+            hi_--;
+            continue;
+        }
+
+        Rid old_rid{hi_, src_slot};
+        Rid new_rid{lo_, dst_slot};
+        auto record = file_handle_->get_record(old_rid, nullptr);
+        file_handle_->insert_record(new_rid, record->data);
+        file_handle_->delete_record(old_rid, nullptr);
+        if (on_move_) {
+            on_move_(old_rid, new_rid, record->data);
+        }
+        stats_.records_moved++;
+        moved++;
+    }
+    return lo_ >= hi_;
+}
+
+/**
+ * @description: 一批一批地整理直到完成或被stop()打断，批与批之间按max_records_per_sec限速
+ * @return {RmCompactStats} 整理的统计信息
+ */
+RmCompactStats RmCompactor::run() {
+    auto start = std::chrono::steady_clock::now();
+    while (!stop_ && !step()) {
+        if (options_.max_records_per_sec > 0) {
+            // 按已经搬过的记录数算出应该用掉的时间，跑快了就睡到那个时间点
+            auto due = start + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                                   std::chrono::duration<double>(stats_.records_moved / options_.max_records_per_sec));
+            std::this_thread::sleep_until(due);
+        } else {
+            std::this_thread::yield();
+        }
+    }
+    stats_.elapsed_sec = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return stats_;
+}
+
+/**
+ * @description: 计算文件的填充率：记录数 / 记录页能容纳的记录数
+ */
+double RmCompactor::fill_factor(RmFileHandle *file_handle, BufferPoolManager *buffer_pool_manager) {
+    RmFileHdr file_hdr = file_handle->get_file_hdr();
+    int num_record_pages = file_hdr.num_pages - RM_FIRST_RECORD_PAGE;
+    if (num_record_pages <= 0) {
+        return 1.0;
+    }
+    size_t num_records = 0;
+    for (int page_no = RM_FIRST_RECORD_PAGE; page_no < file_hdr.num_pages; page_no++) {
+        RmPageHandle page_handle = file_handle->fetch_page_handle(page_no);
+        num_records += page_handle.page_hdr->num_records;
+        buffer_pool_manager->unpin_page(page_handle.page->get_page_id(), false);
+    }
+    return (double)num_records / ((size_t)num_record_pages * file_hdr.num_records_per_page);
+}
@@ -0,0 +1,77 @@
+/* Copyright (c) 2023 Renmin University of China
+RMDB is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+        http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#pragma once
+
+#include <atomic>
+#include <functional>
+#include <shared_mutex>
+
+#include "rm_file_handle.h"
+
+struct RmCompactOptions {
+    int batch_records = 64;             // 每批移动的记录数，两批之间释放表锁，让前台操作进来
+    double max_records_per_sec = 0;     // 移动速率上限，0表示不限速
+    bool truncate_tail = true;          // 整理完是否截掉文件末尾的空页
+};
+
+struct RmCompactStats {
+    size_t records_moved = 0;
+    size_t batches = 0;
+    int pages_before = 0;
+    int pages_after = 0;
+    double elapsed_sec = 0;
+};
+
+/* 记录文件的在线整理。删除只清bitmap，页面会一直稀疏下去，扫描仍要读每个半空的页面。
+   整理用两个指针：lo_从前往后找有空位的页面，hi_从后往前找有记录的页面，把hi_页面上的记录
+   逐条搬到lo_页面的空位上（insert_record(rid)+delete_record，文件的写回调照常触发），
+   两个指针相遇后截掉文件末尾的空页。
+   每搬一条记录调用一次MoveFunc告知新旧rid，供索引维护。
+   给了table_latch时每批在独占锁下进行，批与批之间按限速睡眠，前台操作只在一批的时间内被阻塞。
+   截断对不持有表锁的读者不可见：快照（RmVersionStore::begin_snapshot）期间RmFileHandle拒绝截断；
+   RmMmapFileHandle映射着的文件不能被DiskManager打开，也就不会被整理 */
+class RmCompactor {
+   public:
+    // 回调参数：记录原来的rid、新的rid、记录内容
+    using MoveFunc = std::function<void(const Rid &old_rid, const Rid &new_rid, const char *record)>;
+
+    RmCompactor(RmFileHandle *file_handle, BufferPoolManager *buffer_pool_manager,
+                std::shared_mutex *table_latch = nullptr, RmCompactOptions options = RmCompactOptions());
+
+    void set_move_callback(MoveFunc on_move) { on_move_ = std::move(on_move); }
+
+    bool step();
+
+    RmCompactStats run();
+
+    void stop() { stop_ = true; }
+
+    bool is_done() const { return done_; }
+
+    const RmCompactStats &get_stats() const { return stats_; }
+
+    static double fill_factor(RmFileHandle *file_handle, BufferPoolManager *buffer_pool_manager);
+
+   private:
+    bool move_batch();
+
+    RmFileHandle *file_handle_;
+    BufferPoolManager *buffer_pool_manager_;
+    std::shared_mutex *table_latch_;
+    RmCompactOptions options_;
+    MoveFunc on_move_;
+
+    int lo_;        // 这个页面之前的页面都已经满了
+    int hi_;        // 这个页面之后的页面都已经空了
+    bool done_ = false;
+    std::atomic<bool> stop_{false};
+    RmCompactStats stats_;
+};
@@ -0,0 +1,233 @@
+/* Copyright (c) 2023 Renmin University of China
+RMDB is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+        http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#include "rm_external_sort.h"
+
+#include <algorithm>
+#include <cstring>
+
+RmLoserTree::RmLoserTree(int k, LessFunc less) : k_(k), less_(std::move(less)) {
+    // 内部节点先全部填成哨兵k，哨兵比任何一路都小，逐个叶子调整后哨兵全部被替换掉
+    tree_.assign(std::max(k_, 1), k_);
+    for (int i = k_ - 1; i >= 0; i--) {
+        adjust(i);
+    }
+}
+
+bool RmLoserTree::beats(int a, int b) const {
+    if (a == k_) return true;
+    if (b == k_) return false;
+    return less_(a, b);
+}
+
+/**
+ * @description: 第leaf路的当前记录变化后，从叶子到根重新比赛，败者留在节点上，胜者继续向上
+ */
+void RmLoserTree::adjust(int leaf) {
+    int winner = leaf;
+    for (int t = (leaf + k_) / 2; t > 0; t /= 2) {
+        if (beats(tree_[t], winner)) {
+            std::swap(winner, tree_[t]);
+        }
+    }
+    tree_[0] = winner;
+}
+
+/**
+ * @param {DiskManager*} disk_manager 用于创建有序段文件
+ * @param {RmOperatorInput&} input 输入
+ * @param {vector<RmSortKey>} keys 排序键，按顺序比较
+ * @param {size_t} memory_budget 排序可以使用的内存字节数
+ * @param {string&} spill_prefix 有序段文件的路径前缀
+ * @param {size_t} limit 只需要前limit条时填写，0表示全部输出
+ * @param {int} io_pages 有序段文件每次读写的页面数
+ */
+RmExternalSort::RmExternalSort(DiskManager *disk_manager, const RmOperatorInput &input, std::vector<RmSortKey> keys,
+                               size_t memory_budget, const std::string &spill_prefix, size_t limit, int io_pages)
+    : disk_manager_(disk_manager),
+      input_(input),
+      keys_(std::move(keys)),
+      memory_budget_(std::max<size_t>(memory_budget, PAGE_SIZE)),
+      spill_prefix_(spill_prefix),
+      limit_(limit),
+      io_pages_(std::max(io_pages, 1)) {}
+
+int RmExternalSort::compare(const char *a, const char *b) const {
+    for (const RmSortKey &key : keys_) {
+        int ret = rm_compare(key.col.get(a), key.col.get(b), key.col.type, key.col.len);
+        if (ret != 0) {
+            return key.desc ? -ret : ret;
+        }
+    }
+    return 0;
+}
+
+/**
+ * @description: 执行排序，按顺序把记录推给sink
+ */
+void RmExternalSort::run(const RmRecordSink &sink) {
+    int record_size = input_.record_size;
+    if (limit_ > 0 && limit_ * record_size <= memory_budget_) {
+        run_top_n(sink);
+        return;
+    }
+
+    size_t max_rows = std::max<size_t>(memory_budget_ / (record_size + sizeof(const char *)), 1);
+    std::vector<char> buf;
+    buf.reserve(max_rows * record_size);
+    std::vector<const char *> order;
+    std::vector<std::unique_ptr<RmSpillFile>> runs;
+
+    input_.source([&](const char *record) {
+        stats_.input_rows++;
+        buf.insert(buf.end(), record, record + record_size);
+        if (buf.size() == max_rows * record_size) {
+            sort_buffer(&buf, &order);
+            runs.push_back(write_run(order));
+            buf.clear();
+        }
+    });
+
+    if (runs.empty()) {
+        // 全部放得进内存，不需要写盘
+        sort_buffer(&buf, &order);
+        size_t n = limit_ > 0 ? std::min(limit_, order.size()) : order.size();
+        for (size_t i = 0; i < n; i++) {
+            sink(order[i]);
+        }
+        return;
+    }
+    if (!buf.empty()) {
+        sort_buffer(&buf, &order);
+        runs.push_back(write_run(order));
+    }
+    stats_.num_runs = runs.size();
+    std::vector<char>().swap(buf);
+    std::vector<const char *>().swap(order);
+    merge(std::move(runs), sink);
+}
+
+/**
+ * @description: ORDER BY ... LIMIT的快速路径。维护一个最多limit条记录的大顶堆，
+ *               堆顶是目前保留的记录中排在最后的一条，新记录比它小时替换掉它
+ */
+void RmExternalSort::run_top_n(const RmRecordSink &sink) {
+    stats_.top_n = true;
+    int record_size = input_.record_size;
+    std::vector<char> slots(limit_ * record_size);
+    std::vector<int> heap;
+    heap.reserve(limit_);
+    auto slot = [&](int i) { return slots.data() + (size_t)i * record_size; };
+    auto heap_less = [&](int a, int b) { return compare(slot(a), slot(b)) < 0; };
+
+    input_.source([&](const char *record) {
+        stats_.input_rows++;
+        if (heap.size() < limit_) {
+            int i = heap.size();
+            memcpy(slot(i), record, record_size);
+            heap.push_back(i);
+            std::push_heap(heap.begin(), heap.end(), heap_less);
+        } else if (compare(record, slot(heap.front())) < 0) {
+            std::pop_heap(heap.begin(), heap.end(), heap_less);
+            memcpy(slot(heap.back()), record, record_size);
+            std::push_heap(heap.begin(), heap.end(), heap_less);
+        }
+    });
+
+    std::sort_heap(heap.begin(), heap.end(), heap_less);
+    for (int i : heap) {
+        sink(slot(i));
+    }
+}
+
+void RmExternalSort::sort_buffer(std::vector<char> *buf, std::vector<const char *> *order) const {
+    int record_size = input_.record_size;
+    size_t n = buf->size() / record_size;
+    order->resize(n);
+    for (size_t i = 0; i < n; i++) {
+        (*order)[i] = buf->data() + i * record_size;
+    }
+    std::stable_sort(order->begin(), order->end(), [this](const char *a, const char *b) { return compare(a, b) < 0; });
+}
+
+std::unique_ptr<RmSpillFile> RmExternalSort::write_run(const std::vector<const char *> &order) {
+    std::string path = spill_prefix_ + "_run" + std::to_string(next_run_id_++);
+    auto run = std::make_unique<RmSpillFile>(disk_manager_, path, input_.record_size, io_pages_);
+    for (const char *record : order) {
+        run->append(record);
+    }
+    run->finish();
+    return run;
+}
+
+/**
+ * @description: 归并所有有序段。每一路读取时占用两块缓冲（当前块和预读块），
+ *               按内存预算算出一趟最多归并的路数，超过时先把每fan_in个段成组归并成更长的段，直到剩下的段一趟能归并完
+ */
+void RmExternalSort::merge(std::vector<std::unique_ptr<RmSpillFile>> runs, const RmRecordSink &sink) {
+    size_t block_size = (size_t)io_pages_ * PAGE_SIZE;
+    size_t fan_in = std::max<size_t>(memory_budget_ / (2 * block_size), 2);
+
+    auto merge_group = [this](std::vector<std::unique_ptr<RmSpillFile>> &group, size_t limit,
+                              const RmRecordSink &out) {
+        int k = group.size();
+        std::vector<std::unique_ptr<RmSpillReader>> readers;
+        std::vector<const char *> cur(k, nullptr);
+        for (int i = 0; i < k; i++) {
+            readers.push_back(std::make_unique<RmSpillReader>(group[i].get(), true));
+            if (!readers[i]->next(&cur[i])) {
+                cur[i] = nullptr;
+            }
+        }
+        RmLoserTree tree(k, [this, &cur](int a, int b) {
+            if (cur[a] == nullptr) return false;
+            if (cur[b] == nullptr) return true;
+            int ret = compare(cur[a], cur[b]);
+            return ret < 0 || (ret == 0 && a < b);
+        });
+        size_t emitted = 0;
+        while (limit == 0 || emitted < limit) {
+            int w = tree.winner();
+            if (cur[w] == nullptr) {
+                break;
+            }
+            out(cur[w]);
+            emitted++;
+            if (!readers[w]->next(&cur[w])) {
+                cur[w] = nullptr;
+            }
+            tree.adjust(w);
+        }
+    };
+
+    while (runs.size() > fan_in) {
+        stats_.merge_passes++;
+        std::vector<std::unique_ptr<RmSpillFile>> next_runs;
+        for (size_t start = 0; start < runs.size(); start += fan_in) {
+            std::vector<std::unique_ptr<RmSpillFile>> group;
+            for (size_t i = start; i < std::min(start + fan_in, runs.size()); i++) {
+                group.push_back(std::move(runs[i]));
+            }
+            if (group.size() == 1) {
+                next_runs.push_back(std::move(group[0]));
+                continue;
+            }
+            std::string path = spill_prefix_ + "_run" + std::to_string(next_run_id_++);
+            auto merged = std::make_unique<RmSpillFile>(disk_manager_, path, input_.record_size, io_pages_);
+            merge_group(group, 0, [&merged](const char *record) { merged->append(record); });
+            merged->finish();
+            next_runs.push_back(std::move(merged));
+        }
+        runs = std::move(next_runs);
+    }
+
+    stats_.merge_passes++;
+    merge_group(runs, limit_, sink);
+}
@@ -0,0 +1,90 @@
+/* Copyright (c) 2023 Renmin University of China
+RMDB is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+        http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#pragma once
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "rm_column.h"
+#include "rm_record_source.h"
+#include "rm_spill_file.h"
+
+/* 排序键中的一列，desc为true表示降序 */
+struct RmSortKey {
+    RmColumn col;
+    bool desc;
+};
+
+struct RmSortStats {
+    size_t input_rows = 0;
+    size_t num_runs = 0;        // 生成的初始有序段个数，0表示全部在内存中完成
+    int merge_passes = 0;       // 归并的趟数，包括最后一趟直接输出的归并
+    bool top_n = false;         // 是否走了ORDER BY ... LIMIT的快速路径
+};
+
+/* 内存受限的外部归并排序。
+   1. 生成有序段：按memory_budget攒一批记录，在内存中排好序后写成一个溢出文件，读写都按io_pages个页面为一块顺序进行；
+      输入能全部放进内存时不写盘，直接输出。
+   2. 归并：用败者树做k路归并，每一路带后台预读。段数超过一趟能归并的路数（受内存预算限制）时先做多趟中间归并。
+   limit > 0且limit条记录能放进内存时，用一个大小为limit的堆只保留前limit条，不生成有序段 */
+class RmExternalSort {
+   public:
+    RmExternalSort(DiskManager *disk_manager, const RmOperatorInput &input, std::vector<RmSortKey> keys,
+                   size_t memory_budget, const std::string &spill_prefix, size_t limit = 0, int io_pages = 16);
+
+    void run(const RmRecordSink &sink);
+
+    const RmSortStats &get_stats() const { return stats_; }
+
+   private:
+    int compare(const char *a, const char *b) const;
+
+    void run_top_n(const RmRecordSink &sink);
+
+    void sort_buffer(std::vector<char> *buf, std::vector<const char *> *order) const;
+
+    std::unique_ptr<RmSpillFile> write_run(const std::vector<const char *> &order);
+
+    void merge(std::vector<std::unique_ptr<RmSpillFile>> runs, const RmRecordSink &sink);
+
+    DiskManager *disk_manager_;
+    RmOperatorInput input_;
+    std::vector<RmSortKey> keys_;
+    size_t memory_budget_;
+    std::string spill_prefix_;
+    size_t limit_;
+    int io_pages_;
+    int next_run_id_ = 0;
+    RmSortStats stats_;
+};
+
+/* k路归并用的败者树。tree_[0]是当前最小的一路，其余内部节点保存在该节点比赛中输掉的一路；
+   每次取走最小记录后只需要沿着这一路的叶子到根重新比赛一次，比较次数为log(k) */
+class RmLoserTree {
+   public:
+    // less(a, b)：第a路的当前记录是否应该排在第b路前面，已经读完的路视为无穷大
+    using LessFunc = std::function<bool(int a, int b)>;
+
+    RmLoserTree(int k, LessFunc less);
+
+    int winner() const { return tree_[0]; }
+
+    void adjust(int leaf);
+
+   private:
+    bool beats(int a, int b) const;
+
+    int k_;
+    std::vector<int> tree_;
+    LessFunc less_;
+};
@@ -10,6 +10,12 @@ See the Mulan PSL v2 for more details. */
 
 #include "rm_file_handle.h"
 
+#include <algorithm>
+#include <mutex>
+#include <vector>
+
+#include "rm_file_hook.h"
+
 /**
  * @description: 获取当前表中记录号为rid的记录
  * @param {Rid&} rid 记录号，指定记录的位置
@@ -22,13 +28,19 @@ std::unique_ptr<RmRecord> RmFileHandle::get_record(const Rid& rid, Context* cont
     // 2. 初始化一个指向RmRecord的指针（赋值其内部的data和size）
     // PageId pageid_ = PageId{.fd = fd_, .page_no = rid.page_no};
 
-    if (is_record(rid)) {
-        RmPageHandle page_handle = fetch_page_handle(rid.page_no);
-        RmRecord * record = new RmRecord(file_hdr_.record_size, page_handle.get_slot(rid.slot_no));// RmRecord的构造方法，传入record_size和slot的地址，slot的地址可以用方法获取
-        return std::unique_ptr<RmRecord>(record);
+    // 页面可能已经被整理截掉了，这时和空slot一样按记录不存在处理
+    if (rid.page_no >= file_hdr_.num_pages) {
+        return nullptr;
+    }
+    // 不用is_record()，它fetch了页面却没有unpin，这里取一次页面，检查bitmap、拷贝记录后就unpin
+    RmPageHandle page_handle = fetch_page_handle(rid.page_no);
+    RmRecord * record = nullptr;
+    if (Bitmap::is_set(page_handle.bitmap, rid.slot_no)) {
+        record = new RmRecord(file_hdr_.record_size, page_handle.get_slot(rid.slot_no));// RmRecord的构造方法，传入record_size和slot的地址，slot的地址可以用方法获取
     }
+    buffer_pool_manager_->unpin_page(page_handle.page->get_page_id(), false);
 
-    return nullptr;
+    return std::unique_ptr<RmRecord>(record);
 }
 
 /**
@@ -54,23 +66,26 @@ Rid RmFileHandle::insert_record(char* buf, Context* context) {
     // 通过get_slot方法来得到插入数据的首地址
     char* slot = page_handle.get_slot(free_slot);
 
-    // 用memcpy来把数据复制上去
+    // 构建返回的rid
+    Rid rid = {.page_no = page_handle.page->get_page_id().page_no, .slot_no = free_slot};
+
+    // 用memcpy来把数据复制上去，写之前通知登记在这个文件上的回调
+    RmFileHookRegistry::on_insert(fd_, rid, buf);
     memcpy(slot, buf, file_hdr_.record_size);
 
     Bitmap::set(page_handle.bitmap, free_slot); // 设置bitmap中的对应位为1
     // 4 更新页头
     page_handle.page_hdr->num_records++; // 更新记录数
 
-    // 构建返回的rid
-    Rid rid = {.page_no = page_handle.page->get_page_id().page_no, .slot_no = free_slot};
-
     // 检查是否已满
     //page_handle.page_hdr->num_records == file_hdr_.num_records_per_page  这个条件应该是等价
     if (Bitmap::first_bit(false, page_handle.bitmap, file_hdr_.num_records_per_page) == file_hdr_.num_records_per_page) {
         //如果满了，要更新 第一个空闲页
         file_hdr_.first_free_page_no = page_handle.page_hdr->next_free_page_no;
     }
+    buffer_pool_manager_->unpin_page(page_handle.page->get_page_id(), true);
 
+    RmFileHookRegistry::on_write_done(fd_, rid);
     return rid;
 }
 
@@ -80,10 +95,14 @@ Rid RmFileHandle::insert_record(char* buf, Context* context) {
  * @param {char*} buf 要插入记录的数据
  */
 void RmFileHandle::insert_record(const Rid& rid, char* buf) {
-    if(is_record(rid)) return; // 我们预期rid位置不应该有记录，如果有的话就不对了
-
     RmPageHandle page_handle = fetch_page_handle(rid.page_no);
+    if (Bitmap::is_set(page_handle.bitmap, rid.slot_no)) {
+        // 我们预期rid位置不应该有记录，如果有的话就不对了
+        buffer_pool_manager_->unpin_page(page_handle.page->get_page_id(), false);
+        return;
+    }
     char* slot = page_handle.get_slot(rid.slot_no); 
+    RmFileHookRegistry::on_insert(fd_, rid, buf);
     memcpy(slot, buf, file_hdr_.record_size);
     // set bitmap
     Bitmap::set(page_handle.bitmap, rid.slot_no);
@@ -96,9 +115,12 @@ void RmFileHandle::insert_record(const Rid& rid, char* buf) {
         for (int i = page_no_this - 1; i > 0; i--) {
             // 取页检查 
             RmPageHandle former_page_handle = fetch_page_handle(i);
-            if (former_page_handle.page_hdr->next_free_page_no == page_no_this) {
+            bool linked = former_page_handle.page_hdr->next_free_page_no == page_no_this;
+            if (linked) {
                 former_page_handle.page_hdr->next_free_page_no = page_handle.page_hdr->next_free_page_no;
-            } else {
+            }
+            buffer_pool_manager_->unpin_page(former_page_handle.page->get_page_id(), linked);
+            if (!linked) {
                 break;
             }
         }
@@ -106,6 +128,8 @@ void RmFileHandle::insert_record(const Rid& rid, char* buf) {
             file_hdr_.first_free_page_no = page_handle.page_hdr->next_free_page_no;
         }
     }
+    buffer_pool_manager_->unpin_page(page_handle.page->get_page_id(), true);
+    RmFileHookRegistry::on_write_done(fd_, rid);
 }
 
 /**
@@ -123,10 +147,16 @@ void RmFileHandle::delete_record(const Rid& rid, Context* context) {
     
     // get page handle
     RmPageHandle page_handle = fetch_page_handle(rid.page_no);
+    // 空slot或过期的rid上没有记录，不能通知回调，否则回调会把slot里的旧字节当成记录减掉，记录数也会减成负数
+    if (rid.slot_no < 0 || rid.slot_no >= file_hdr_.num_records_per_page ||
+        !Bitmap::is_set(page_handle.bitmap, rid.slot_no)) {
+        buffer_pool_manager_->unpin_page(page_handle.page->get_page_id(), false);
+        throw RecordNotFoundError(rid.page_no, rid.slot_no);
+    }
 
-    
     // get slot
     char* slot = page_handle.get_slot(rid.slot_no);
+    RmFileHookRegistry::on_delete(fd_, rid, slot);
     // reset this slot
     Bitmap::reset(page_handle.bitmap, rid.slot_no);
     // slot里面具体数据好像不用改，只要改掉bitmap等记录，就可以看作是删掉了
@@ -136,7 +166,8 @@ void RmFileHandle::delete_record(const Rid& rid, Context* context) {
     }
     // 更新记录数
     page_handle.page_hdr->num_records--;
-    
+    buffer_pool_manager_->unpin_page(page_handle.page->get_page_id(), true);
+    RmFileHookRegistry::on_write_done(fd_, rid);
 }
 
 
@@ -152,10 +183,19 @@ void RmFileHandle::update_record(const Rid& rid, char* buf, Context* context) {
     // 2. 更新记录
 
     RmPageHandle page_handle = fetch_page_handle(rid.page_no);
+    // 和delete_record一样，rid上没有记录时在通知回调之前报错
+    if (rid.slot_no < 0 || rid.slot_no >= file_hdr_.num_records_per_page ||
+        !Bitmap::is_set(page_handle.bitmap, rid.slot_no)) {
+        buffer_pool_manager_->unpin_page(page_handle.page->get_page_id(), false);
+        throw RecordNotFoundError(rid.page_no, rid.slot_no);
+    }
 
     char * slot = page_handle.get_slot(rid.slot_no);
 
+    RmFileHookRegistry::on_update(fd_, rid, slot, buf);
     memcpy(slot, buf, file_hdr_.record_size); // 更新记录
+    buffer_pool_manager_->unpin_page(page_handle.page->get_page_id(), true);
+    RmFileHookRegistry::on_write_done(fd_, rid);
 
 }
 
@@ -171,6 +211,10 @@ RmPageHandle RmFileHandle::fetch_page_handle(int page_no) const {
     // Todo:
     // 使用缓冲池获取指定页面，并生成page_handle返回给上层
     // if page_no is invalid, throw PageNotExistError exception
+    // 超出文件页面数的页面（包括被截掉的）不能交给缓冲池，否则read_page读不满一页会抛InternalError
+    if (page_no < 0 || page_no >= file_hdr_.num_pages) {
+        throw PageNotExistError(disk_manager_->get_file_name(fd_), page_no);
+    }
     
     Page* page_;
     page_ = buffer_pool_manager_->fetch_page(PageId{fd_, page_no});
@@ -194,8 +238,9 @@ RmPageHandle RmFileHandle::create_new_page_handle() {
     Page * page_ = buffer_pool_manager_->new_page(&new_page_id);
     RmPageHandle new_page_handle = RmPageHandle(&file_hdr_, page_);
     
-    file_hdr_.first_free_page_no = file_hdr_.num_pages;   // 如果这种情况应该新页就是文件头的第一个空闲页，它的页号应该正好是新增前的总页数
-    file_hdr_.num_pages++; // 创建了新页，更新文件头信息
+    // 新页就是文件头的第一个空闲页。DiskManager可能复用之前释放的页面，所以用分配到的页号，不假设它等于新增前的总页数
+    file_hdr_.first_free_page_no = new_page_id.page_no;
+    file_hdr_.num_pages = std::max(file_hdr_.num_pages, new_page_id.page_no + 1); // 创建了新页，更新文件头信息
 
 
     // 得手动设置页头
@@ -242,9 +287,12 @@ void RmFileHandle::release_page_handle(RmPageHandle&page_handle) {
     int page_no_this = page_handle.page->get_page_id().page_no;
     for (int i = page_no_this - 1; i > 0; i--) {
         RmPageHandle former_page_handle = fetch_page_handle(i);
-        if (former_page_handle.page_hdr->next_free_page_no > page_no_this) {
+        bool linked = former_page_handle.page_hdr->next_free_page_no > page_no_this;
+        if (linked) {
             former_page_handle.page_hdr->next_free_page_no = page_no_this;
-        } else {
+        }
+        buffer_pool_manager_->unpin_page(former_page_handle.page->get_page_id(), linked);
+        if (!linked) {
             break;
         }
     }
@@ -252,4 +300,123 @@ void RmFileHandle::release_page_handle(RmPageHandle&page_handle) {
         file_hdr_.first_free_page_no = page_no_this;
     }
     
-}
\ No newline at end of file
+}
+/**
+ * @description: 禁止截断文件，供不持有表锁、自己记着页面数的读者（快照扫描等）使用，用完调用release_truncate
+ */
+void RmFileHandle::hold_truncate() {
+    std::scoped_lock lock{truncate_latch_};
+    num_truncate_holds_++;
+}
+
+void RmFileHandle::release_truncate() {
+    std::scoped_lock lock{truncate_latch_};
+    num_truncate_holds_--;
+}
+
+/**
+ * @description: 去掉文件中没有记录的页面：从空闲链表中摘除、从缓冲池删除，末尾的页面截断磁盘文件，
+ *               中间的页面交还给DiskManager的分配表，之后分配新页面时优先复用
+ * @return {int} 截断后文件的页面数
+ * @note 末尾页面若仍被pin住则在该页停止，只截掉它之后的页面，中间被pin住的页面留在空闲链表里；
+ *       有读者调用了hold_truncate时什么都不做
+ */
+int RmFileHandle::truncate_empty_tail() {
+    std::scoped_lock lock{truncate_latch_};
+    if (num_truncate_holds_ > 0) {
+        return file_hdr_.num_pages;
+    }
+    int new_num_pages = file_hdr_.num_pages;
+    while (new_num_pages > RM_FIRST_RECORD_PAGE) {
+        RmPageHandle page_handle = fetch_page_handle(new_num_pages - 1);
+        int num_records = page_handle.page_hdr->num_records;
+        buffer_pool_manager_->unpin_page(page_handle.page->get_page_id(), false);
+        if (num_records > 0) {
+            break;
+        }
+        new_num_pages--;
+    }
+
+    // 末尾之前的空页面。空闲链表不一定能走到所有有空位的页面，所以逐页看页头
+    std::vector<int> empty_pages;
+    for (int page_no = RM_FIRST_RECORD_PAGE; page_no < new_num_pages; page_no++) {
+        RmPageHandle page_handle = fetch_page_handle(page_no);
+        if (page_handle.page_hdr->num_records == 0) {
+            empty_pages.push_back(page_no);
+        }
+        buffer_pool_manager_->unpin_page(page_handle.page->get_page_id(), false);
+    }
+    if (new_num_pages == file_hdr_.num_pages && empty_pages.empty()) {
+        return new_num_pages;
+    }
+
+    // release_page_handle只改写前面连续几个页面的next指针，遇到不指向后面的页面就停下，链表不保证按页号有序，
+    // 要去掉的页面可能出现在链表的任何位置。先在页面还在缓冲池里的时候把整条链表读出来
+    std::vector<int> free_pages;
+    for (int page_no = file_hdr_.first_free_page_no;
+         page_no != RM_NO_PAGE && (int)free_pages.size() < file_hdr_.num_pages;) {
+        free_pages.push_back(page_no);
+        RmPageHandle page_handle = fetch_page_handle(page_no);
+        page_no = page_handle.page_hdr->next_free_page_no;
+        buffer_pool_manager_->unpin_page(page_handle.page->get_page_id(), false);
+    }
+
+    // 被截掉的页面不能再留在缓冲池里，否则淘汰时会被写回到文件末尾之后
+    for (int page_no = file_hdr_.num_pages - 1; page_no >= new_num_pages; page_no--) {
+        if (!buffer_pool_manager_->delete_page(PageId{fd_, page_no})) {
+            new_num_pages = page_no + 1;
+            break;
+        }
+    }
+
+    // 中间的空页面写回后移出缓冲池再释放，释放的页面上没有记录，扫描读到的是空页面；被pin住的留在链表里
+    std::vector<int> released_pages;
+    for (int page_no : empty_pages) {
+        if (buffer_pool_manager_->delete_page(PageId{fd_, page_no})) {
+            disk_manager_->deallocate_page(fd_, page_no);
+            released_pages.push_back(page_no);
+        }
+    }
+    std::sort(released_pages.begin(), released_pages.end());
+    auto removed = [new_num_pages, &released_pages](int page_no) {
+        return page_no >= new_num_pages ||
+               std::binary_search(released_pages.begin(), released_pages.end(), page_no);
+    };
+
+    // 保留没有去掉的结点，按原来的顺序重新串起来，只改next变了的页面
+    free_pages.erase(std::remove_if(free_pages.begin(), free_pages.end(), removed), free_pages.end());
+    for (size_t i = 0; i < free_pages.size(); i++) {
+        int next = i + 1 < free_pages.size() ? free_pages[i + 1] : RM_NO_PAGE;
+        RmPageHandle page_handle = fetch_page_handle(free_pages[i]);
+        bool relinked = page_handle.page_hdr->next_free_page_no != next;
+        if (relinked) {
+            page_handle.page_hdr->next_free_page_no = next;
+        }
+        buffer_pool_manager_->unpin_page(page_handle.page->get_page_id(), relinked);
+    }
+    file_hdr_.first_free_page_no = free_pages.empty() ? RM_NO_PAGE : free_pages[0];
+    // 不在链表上的页面（已满的页面等）的next可能还指向去掉的页面，这些页面之后可能被DiskManager重新分配，
+    // 页面变成链表头再写满时会顺着旧的next把它当成空闲页面，所以清成RM_NO_PAGE
+    for (int page_no = RM_FIRST_RECORD_PAGE; page_no < new_num_pages; page_no++) {
+        if (std::binary_search(released_pages.begin(), released_pages.end(), page_no)) {
+            continue;
+        }
+        RmPageHandle page_handle = fetch_page_handle(page_no);
+        int next = page_handle.page_hdr->next_free_page_no;
+        bool stale = next != RM_NO_PAGE && removed(next);
+        if (stale) {
+            page_handle.page_hdr->next_free_page_no = RM_NO_PAGE;
+        }
+        buffer_pool_manager_->unpin_page(page_handle.page->get_page_id(), stale);
+    }
+
+    int old_num_pages = file_hdr_.num_pages;
+    file_hdr_.num_pages = new_num_pages;
+    // 文件头直接写盘，不经过缓冲池；先作废缓冲池和二级缓存里可能有的第0页副本，免得之后读到旧的文件头
+    buffer_pool_manager_->delete_page(PageId{fd_, RM_FILE_HDR_PAGE});
+    disk_manager_->write_page(fd_, RM_FILE_HDR_PAGE, (char *)&file_hdr_, sizeof(file_hdr_));
+    if (new_num_pages < old_num_pages) {
+        disk_manager_->truncate_file(fd_, new_num_pages);
+    }
+    return new_num_pages;
+}
@@ -0,0 +1,107 @@
+/* Copyright (c) 2023 Renmin University of China
+RMDB is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+        http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#include "rm_file_hook.h"
+
+#include <algorithm>
+#include <cassert>
+#include <iterator>
+#include <thread>
+
+std::mutex RmFileHookRegistry::latch_;
+std::atomic<int> RmFileHookRegistry::num_hooks_{0};
+std::shared_ptr<const RmFileHookRegistry::HookList> RmFileHookRegistry::fd2hooks_[DiskManager::MAX_FD];
+
+/**
+ * @description: 为文件fd登记一个回调，文件关闭前需要remove_hook
+ * @param {int} fd 文件句柄
+ * @param {RmFileHook*} hook 回调对象，由调用方管理生命周期
+ */
+void RmFileHookRegistry::add_hook(int fd, RmFileHook *hook) {
+    assert(fd >= 0 && fd < DiskManager::MAX_FD);
+    std::scoped_lock lock{latch_};
+    auto hooks = std::make_shared<HookList>();
+    if (auto old = std::atomic_load(&fd2hooks_[fd])) {
+        *hooks = *old;
+    }
+    hooks->push_back(hook);
+    std::atomic_store(&fd2hooks_[fd], std::shared_ptr<const HookList>(std::move(hooks)));
+    num_hooks_++;
+}
+
+/**
+ * @description: 注销回调，返回时已经没有写操作还在调用这个回调，调用方可以析构hook
+ * @param {int} fd 文件句柄
+ * @param {RmFileHook*} hook 回调对象
+ */
+void RmFileHookRegistry::remove_hook(int fd, RmFileHook *hook) {
+    assert(fd >= 0 && fd < DiskManager::MAX_FD);
+    std::shared_ptr<const HookList> old;
+    {
+        std::scoped_lock lock{latch_};
+        old = std::atomic_load(&fd2hooks_[fd]);
+        if (old == nullptr || std::find(old->begin(), old->end(), hook) == old->end()) {
+            return;
+        }
+        std::shared_ptr<const HookList> hooks;
+        if (old->size() > 1) {
+            auto remain = std::make_shared<HookList>();
+            std::remove_copy(old->begin(), old->end(), std::back_inserter(*remain), hook);
+            hooks = std::move(remain);
+        }
+        std::atomic_store(&fd2hooks_[fd], std::move(hooks));
+        num_hooks_--;
+    }
+    // 旧列表已经摘下，不会再有新的写操作拿到它；等还在遍历它的写操作都结束（宽限期）
+    while (old.use_count() > 1) {
+        std::this_thread::yield();
+    }
+}
+
+// 取fd当前回调列表的快照，持有期间列表不会被释放，回调执行期间不持有latch_
+std::shared_ptr<const RmFileHookRegistry::HookList> RmFileHookRegistry::get_hooks(int fd) {
+    return std::atomic_load(&fd2hooks_[fd]);
+}
+
+void RmFileHookRegistry::on_insert(int fd, const Rid &rid, const char *new_buf) {
+    if (num_hooks_.load() == 0) return;
+    auto hooks = get_hooks(fd);
+    if (hooks == nullptr) return;
+    for (RmFileHook *hook : *hooks) {
+        hook->on_insert(rid, new_buf);
+    }
+}
+
+void RmFileHookRegistry::on_update(int fd, const Rid &rid, const char *old_buf, const char *new_buf) {
+    if (num_hooks_.load() == 0) return;
+    auto hooks = get_hooks(fd);
+    if (hooks == nullptr) return;
+    for (RmFileHook *hook : *hooks) {
+        hook->on_update(rid, old_buf, new_buf);
+    }
+}
+
+void RmFileHookRegistry::on_delete(int fd, const Rid &rid, const char *old_buf) {
+    if (num_hooks_.load() == 0) return;
+    auto hooks = get_hooks(fd);
+    if (hooks == nullptr) return;
+    for (RmFileHook *hook : *hooks) {
+        hook->on_delete(rid, old_buf);
+    }
+}
+
+void RmFileHookRegistry::on_write_done(int fd, const Rid &rid) {
+    if (num_hooks_.load() == 0) return;
+    auto hooks = get_hooks(fd);
+    if (hooks == nullptr) return;
+    for (RmFileHook *hook : *hooks) {
+        hook->on_write_done(rid);
+    }
+}
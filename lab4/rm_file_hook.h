@@ -0,0 +1,63 @@
+/* Copyright (c) 2023 Renmin University of China
+RMDB is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+        http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "defs.h"
+#include "storage/disk_manager.h"
+
+/* 记录文件写操作的回调接口。
+   RmFileHandle在修改slot之前调用on_insert/on_update/on_delete，此时页面中还是旧数据，
+   修改完成后调用on_write_done。回调里不能再对同一个文件做写操作 */
+class RmFileHook {
+   public:
+    virtual ~RmFileHook() = default;
+
+    virtual void on_insert(const Rid &rid, const char *new_buf) {}
+
+    virtual void on_update(const Rid &rid, const char *old_buf, const char *new_buf) {}
+
+    virtual void on_delete(const Rid &rid, const char *old_buf) {}
+
+    virtual void on_write_done(const Rid &rid) {}
+};
+
+/* 按文件句柄登记的回调表。没有任何回调时写路径只多一次原子读。
+   每个fd对应一个不可变的回调列表，写路径原子地取一份shared_ptr快照直接遍历，不加全局锁也不拷贝列表；
+   add_hook/remove_hook在latch_下生成新列表再整体替换（RCU式）。remove_hook替换后会等旧列表不再被任何写操作持有才返回，
+   之后调用方可以放心析构回调对象，所以不能在回调里调用remove_hook */
+class RmFileHookRegistry {
+   public:
+    static void add_hook(int fd, RmFileHook *hook);
+
+    static void remove_hook(int fd, RmFileHook *hook);
+
+    static void on_insert(int fd, const Rid &rid, const char *new_buf);
+
+    static void on_update(int fd, const Rid &rid, const char *old_buf, const char *new_buf);
+
+    static void on_delete(int fd, const Rid &rid, const char *old_buf);
+
+    static void on_write_done(int fd, const Rid &rid);
+
+   private:
+    using HookList = std::vector<RmFileHook *>;
+
+    static std::shared_ptr<const HookList> get_hooks(int fd);
+
+    static std::mutex latch_;       // 串行化add_hook/remove_hook，写路径不使用
+    static std::atomic<int> num_hooks_;
+    static std::shared_ptr<const HookList> fd2hooks_[DiskManager::MAX_FD];
+};
@@ -0,0 +1,400 @@
+/* Copyright (c) 2023 Renmin University of China
+RMDB is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+        http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#include "rm_hash_agg.h"
+
+#include <algorithm>
+#include <mutex>
+
+static constexpr size_t RM_AGG_INIT_SLOTS = 64;
+static constexpr int RM_AGG_FANOUT = 16;        // 每一层的溢出分区数，对应哈希值的4位
+static constexpr int RM_AGG_MAX_LEVEL = 14;     // 64位哈希最多支持的递归层数
+
+RmAggHashTable::RmAggHashTable(int key_len, int num_aggs) : key_len_(key_len) {
+    state_offset_ = (key_len_ + 7) / 8 * 8;
+    entry_size_ = state_offset_ + num_aggs * sizeof(RmAggState);
+    slots_.assign(RM_AGG_INIT_SLOTS, Slot{0, -1});
+}
+
+/**
+ * @description: 查找分组，不存在时插入（聚合状态未初始化，由调用方根据inserted初始化）
+ * @return {RmAggState*} 分组的聚合状态，下一次插入之前有效
+ */
+RmAggState *RmAggHashTable::find_or_insert(const char *key, uint64_t hash, bool *inserted) {
+    // 装填因子保持在1/2以下，线性探测的平均探测长度很短
+    if ((num_groups_ + 1) * 2 > slots_.size()) {
+        grow();
+    }
+    size_t mask = slots_.size() - 1;
+    for (size_t pos = hash & mask;; pos = (pos + 1) & mask) {
+        Slot &slot = slots_[pos];
+        if (slot.idx == -1) {
+            slot.hash = hash;
+            slot.idx = num_groups_;
+            entries_.resize(entries_.size() + entry_size_);
+            hashes_.push_back(hash);
+            char *entry = entries_.data() + num_groups_ * entry_size_;
+            memcpy(entry, key, key_len_);
+            num_groups_++;
+            *inserted = true;
+            return reinterpret_cast<RmAggState *>(entry + state_offset_);
+        }
+        if (slot.hash == hash) {
+            char *entry = entries_.data() + slot.idx * entry_size_;
+            if (memcmp(entry, key, key_len_) == 0) {
+                *inserted = false;
+                return reinterpret_cast<RmAggState *>(entry + state_offset_);
+            }
+        }
+    }
+}
+
+RmAggState *RmAggHashTable::find(const char *key, uint64_t hash) {
+    size_t mask = slots_.size() - 1;
+    for (size_t pos = hash & mask;; pos = (pos + 1) & mask) {
+        const Slot &slot = slots_[pos];
+        if (slot.idx == -1) {
+            return nullptr;
+        }
+        if (slot.hash == hash) {
+            char *entry = entries_.data() + slot.idx * entry_size_;
+            if (memcmp(entry, key, key_len_) == 0) {
+                return reinterpret_cast<RmAggState *>(entry + state_offset_);
+            }
+        }
+    }
+}
+
+/**
+ * @description: 删除分组。最后一个分组移到被删分组的下标，之前通过get_entry得到的下标和指针失效
+ * @return {bool} 分组是否存在
+ */
+bool RmAggHashTable::erase(const char *key, uint64_t hash) {
+    size_t mask = slots_.size() - 1;
+    size_t pos = hash & mask;
+    for (;; pos = (pos + 1) & mask) {
+        const Slot &slot = slots_[pos];
+        if (slot.idx == -1) {
+            return false;
+        }
+        if (slot.hash == hash && memcmp(entries_.data() + slot.idx * entry_size_, key, key_len_) == 0) {
+            break;
+        }
+    }
+    int64_t idx = slots_[pos].idx;
+    // 线性探测不能直接留空槽，否则会截断后面槽的探测链：把后面不在自己起始位置到空槽之间的槽依次前移
+    for (size_t next = (pos + 1) & mask; slots_[next].idx != -1; next = (next + 1) & mask) {
+        size_t home = slots_[next].hash & mask;
+        if (((next - home) & mask) >= ((next - pos) & mask)) {
+            slots_[pos] = slots_[next];
+            pos = next;
+        }
+    }
+    slots_[pos] = Slot{0, -1};
+
+    // 最后一个分组移到idx，改掉指向它的槽
+    int64_t last = num_groups_ - 1;
+    if (idx != last) {
+        memcpy(entries_.data() + idx * entry_size_, entries_.data() + last * entry_size_, entry_size_);
+        hashes_[idx] = hashes_[last];
+        for (size_t p = hashes_[idx] & mask;; p = (p + 1) & mask) {
+            if (slots_[p].idx == last) {
+                slots_[p].idx = idx;
+                break;
+            }
+        }
+    }
+    entries_.resize(last * entry_size_);
+    hashes_.pop_back();
+    num_groups_--;
+    return true;
+}
+
+void RmAggHashTable::clear() {
+    std::vector<char>().swap(entries_);
+    std::vector<uint64_t>().swap(hashes_);
+    slots_.assign(RM_AGG_INIT_SLOTS, Slot{0, -1});
+    slots_.shrink_to_fit();
+    num_groups_ = 0;
+}
+
+void RmAggHashTable::grow() {
+    std::vector<Slot> old_slots(slots_.size() * 2, Slot{0, -1});
+    old_slots.swap(slots_);
+    size_t mask = slots_.size() - 1;
+    for (const Slot &slot : old_slots) {
+        if (slot.idx == -1) {
+            continue;
+        }
+        size_t pos = slot.hash & mask;
+        while (slots_[pos].idx != -1) {
+            pos = (pos + 1) & mask;
+        }
+        slots_[pos] = slot;
+    }
+}
+
+/**
+ * @param {DiskManager*} disk_manager 用于创建溢出分区文件
+ * @param {vector<RmColumn>} group_cols 分组列
+ * @param {vector<RmAggSpec>} aggs 聚合函数
+ * @param {size_t} memory_budget 分组哈希表可以使用的内存字节数
+ * @param {string&} spill_prefix 溢出文件路径前缀
+ */
+RmHashAggregate::RmHashAggregate(DiskManager *disk_manager, std::vector<RmColumn> group_cols,
+                                 std::vector<RmAggSpec> aggs, size_t memory_budget, const std::string &spill_prefix)
+    : disk_manager_(disk_manager),
+      group_cols_(std::move(group_cols)),
+      aggs_(std::move(aggs)),
+      memory_budget_(memory_budget),
+      spill_prefix_(spill_prefix),
+      key_len_(0),
+      table_(0, 0) {
+    for (const RmColumn &col : group_cols_) {
+        key_len_ += col.len;
+    }
+    for (const RmAggSpec &agg : aggs_) {
+        if (agg.type != AGG_COUNT && agg.col.type != TYPE_INT && agg.col.type != TYPE_FLOAT) {
+            throw IncompatibleTypeError(coltype2str(agg.col.type), "INT or FLOAT");
+        }
+    }
+    table_ = RmAggHashTable(key_len_, aggs_.size());
+    key_buf_.resize(std::max(key_len_, 1));
+    entry_buf_.resize(table_.entry_size());
+}
+
+// 递归处理溢出分区或者线程私有预聚合时使用，配置和parent相同
+RmHashAggregate::RmHashAggregate(const RmHashAggregate &parent, int level, const std::string &spill_prefix)
+    : disk_manager_(parent.disk_manager_),
+      group_cols_(parent.group_cols_),
+      aggs_(parent.aggs_),
+      memory_budget_(parent.memory_budget_),
+      spill_prefix_(level > RM_AGG_MAX_LEVEL ? "" : spill_prefix),
+      level_(level),
+      key_len_(parent.key_len_),
+      table_(parent.key_len_, parent.aggs_.size()) {
+    key_buf_.resize(std::max(key_len_, 1));
+    entry_buf_.resize(table_.entry_size());
+}
+
+std::unique_ptr<RmHashAggregate> RmHashAggregate::make_local() const {
+    return std::unique_ptr<RmHashAggregate>(new RmHashAggregate(*this, level_, ""));
+}
+
+void RmHashAggregate::build_key(const char *record, char *key) const {
+    for (const RmColumn &col : group_cols_) {
+        memcpy(key, col.get(record), col.len);
+        key += col.len;
+    }
+}
+
+void RmHashAggregate::init_states(RmAggState *states) const {
+    for (size_t i = 0; i < aggs_.size(); i++) {
+        states[i].val = 0;
+        states[i].cnt = 0;
+    }
+}
+
+void RmHashAggregate::update_states(RmAggState *states, const char *record) const {
+    for (size_t i = 0; i < aggs_.size(); i++) {
+        RmAggState &state = states[i];
+        const RmAggSpec &agg = aggs_[i];
+        if (agg.type == AGG_COUNT) {
+            state.cnt++;
+            continue;
+        }
+        double v = rm_agg_value(record, agg.col);
+        if (agg.type == AGG_SUM || agg.type == AGG_AVG) {
+            state.val += v;
+        } else if (state.cnt == 0 || (agg.type == AGG_MIN && v < state.val) || (agg.type == AGG_MAX && v > state.val)) {
+            state.val = v;
+        }
+        state.cnt++;
+    }
+}
+
+void RmHashAggregate::merge_states(RmAggState *states, const RmAggState *other) const {
+    for (size_t i = 0; i < aggs_.size(); i++) {
+        RmAggState &state = states[i];
+        const RmAggState &o = other[i];
+        RmAggType type = aggs_[i].type;
+        if (type == AGG_SUM || type == AGG_AVG) {
+            state.val += o.val;
+        } else if ((type == AGG_MIN || type == AGG_MAX) && o.cnt > 0 &&
+                   (state.cnt == 0 || (type == AGG_MIN && o.val < state.val) ||
+                    (type == AGG_MAX && o.val > state.val))) {
+            state.val = o.val;
+        }
+        state.cnt += o.cnt;
+    }
+}
+
+/**
+ * @description: 聚合一条输入记录
+ */
+void RmHashAggregate::consume(const char *record) {
+    stats_.input_rows++;
+    char *key = key_buf_.data();
+    build_key(record, key);
+    uint64_t hash = rm_hash(key, key_len_);
+
+    if (!spilling_) {
+        bool inserted;
+        RmAggState *states = table_.find_or_insert(key, hash, &inserted);
+        if (inserted) {
+            init_states(states);
+        }
+        update_states(states, record);
+        if (!spill_prefix_.empty() && table_.memory_usage() > memory_budget_) {
+            spilling_ = true;
+        }
+        return;
+    }
+
+    RmAggState *states = table_.find(key, hash);
+    if (states != nullptr) {
+        update_states(states, record);
+        return;
+    }
+    // 新分组放不下了，转成只含这一行的部分状态写到溢出分区
+    char *entry = entry_buf_.data();
+    memcpy(entry, key, key_len_);
+    RmAggState *entry_states = reinterpret_cast<RmAggState *>(entry + table_.state_offset());
+    init_states(entry_states);
+    update_states(entry_states, record);
+    spill_entry(entry, hash);
+}
+
+/**
+ * @description: 合并一个部分状态（分组键 + 各聚合函数的状态），来源是线程私有的预聚合表或者溢出分区
+ */
+void RmHashAggregate::consume_partial(const char *entry, uint64_t hash) {
+    const RmAggState *other = reinterpret_cast<const RmAggState *>(entry + table_.state_offset());
+    if (!spilling_) {
+        bool inserted;
+        RmAggState *states = table_.find_or_insert(entry, hash, &inserted);
+        if (inserted) {
+            init_states(states);
+        }
+        merge_states(states, other);
+        if (!spill_prefix_.empty() && table_.memory_usage() > memory_budget_) {
+            spilling_ = true;
+        }
+        return;
+    }
+    RmAggState *states = table_.find(entry, hash);
+    if (states != nullptr) {
+        merge_states(states, other);
+    } else {
+        spill_entry(entry, hash);
+    }
+}
+
+void RmHashAggregate::spill_entry(const char *entry, uint64_t hash) {
+    if (partitions_.empty()) {
+        for (int i = 0; i < RM_AGG_FANOUT; i++) {
+            std::string path = spill_prefix_ + "_l" + std::to_string(level_) + "_p" + std::to_string(i);
+            partitions_.push_back(std::make_unique<RmSpillFile>(disk_manager_, path, table_.entry_size()));
+        }
+    }
+    partitions_[partition_of(hash)]->append(entry);
+    stats_.spilled_rows++;
+}
+
+/**
+ * @description: 把线程私有预聚合表中的部分状态合并进来
+ */
+void RmHashAggregate::merge(const RmHashAggregate &local) {
+    for (size_t i = 0; i < local.table_.size(); i++) {
+        const char *entry = local.table_.get_entry(i);
+        consume_partial(entry, rm_hash(entry, key_len_));
+    }
+    stats_.input_rows += local.stats_.input_rows;
+}
+
+/**
+ * @description: 输出所有分组。先输出内存中的分组，再逐个递归处理溢出分区
+ */
+void RmHashAggregate::finish(const RmRecordSink &sink) {
+    std::vector<char> out(output_record_size());
+    for (size_t i = 0; i < table_.size(); i++) {
+        const char *entry = table_.get_entry(i);
+        const RmAggState *states = reinterpret_cast<const RmAggState *>(entry + table_.state_offset());
+        memcpy(out.data(), entry, key_len_);
+        for (size_t j = 0; j < aggs_.size(); j++) {
+            double v;
+            if (aggs_[j].type == AGG_COUNT) {
+                v = states[j].cnt;
+            } else if (aggs_[j].type == AGG_AVG) {
+                v = states[j].cnt == 0 ? 0 : states[j].val / states[j].cnt;
+            } else {
+                v = states[j].val;
+            }
+            memcpy(out.data() + key_len_ + j * sizeof(double), &v, sizeof(double));
+        }
+        sink(out.data());
+        stats_.output_groups++;
+    }
+    table_.clear();
+    spilling_ = false;
+
+    for (size_t i = 0; i < partitions_.size(); i++) {
+        RmSpillFile *file = partitions_[i].get();
+        file->finish();
+        if (file->num_records() > 0) {
+            RmHashAggregate sub(*this, level_ + 1, spill_prefix_ + "_p" + std::to_string(i));
+            RmSpillReader reader(file, true);
+            const char *entry;
+            while (reader.next(&entry)) {
+                sub.consume_partial(entry, rm_hash(entry, key_len_));
+            }
+            sub.finish(sink);
+            stats_.output_groups += sub.stats_.output_groups;
+            stats_.spilled_rows += sub.stats_.spilled_rows;
+            stats_.max_level = std::max({stats_.max_level, level_ + 1, sub.stats_.max_level});
+        }
+        partitions_[i].reset();
+    }
+    partitions_.clear();
+}
+
+/**
+ * @description: 单线程聚合整个输入并输出结果
+ */
+void RmHashAggregate::run(const RmOperatorInput &input, const RmRecordSink &sink) {
+    input.source([this](const char *record) { consume(record); });
+    finish(sink);
+}
+
+/**
+ * @description: 并行聚合。每个工作线程在私有的预聚合表中聚合，分组数达到local_groups时加锁合并进全局表并清空，
+ *               低基数分组键时绝大多数记录都在线程私有表里完成聚合，几乎不需要加锁
+ */
+void RmHashAggregate::run_parallel(RmParallelScan *scan, const RmRecordSink &sink, size_t local_groups) {
+    std::vector<std::unique_ptr<RmHashAggregate>> locals;
+    for (int i = 0; i < scan->get_num_workers(); i++) {
+        locals.push_back(make_local());
+    }
+    std::mutex latch;
+    scan->run([&](int worker_id, const Rid &rid, const char *record) {
+        RmHashAggregate &local = *locals[worker_id];
+        local.consume(record);
+        if (local.table_.size() >= local_groups) {
+            std::scoped_lock lock{latch};
+            merge(local);
+            local.table_.clear();
+            local.stats_.input_rows = 0;
+        }
+    });
+    for (auto &local : locals) {
+        merge(*local);
+    }
+    finish(sink);
+}
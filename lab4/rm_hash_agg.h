@@ -0,0 +1,163 @@
+/* Copyright (c) 2023 Renmin University of China
+RMDB is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+        http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "rm_column.h"
+#include "rm_record_source.h"
+#include "rm_spill_file.h"
+
+enum RmAggType { AGG_COUNT, AGG_SUM, AGG_MIN, AGG_MAX, AGG_AVG };
+
+/* 一个聚合函数，col是被聚合的列（AGG_COUNT不使用），只支持TYPE_INT和TYPE_FLOAT */
+struct RmAggSpec {
+    RmAggType type;
+    RmColumn col;
+};
+
+// 取出记录中被聚合的列的值，列类型为TYPE_INT或TYPE_FLOAT
+inline double rm_agg_value(const char *record, const RmColumn &col) {
+    if (col.type == TYPE_INT) {
+        int v;
+        memcpy(&v, col.get(record), sizeof(int));
+        return v;
+    }
+    float v;
+    memcpy(&v, col.get(record), sizeof(float));
+    return v;
+}
+
+/* 一个分组上一个聚合函数的中间状态，所有聚合函数都用同样的两个字段表示，便于合并 */
+struct RmAggState {
+    double val;     // SUM/AVG为累加和，MIN/MAX为当前最值
+    int64_t cnt;    // 参与聚合的记录数
+};
+
+/* 开放定址（线性探测）的分组哈希表。
+   分组按插入顺序紧密存放在entries_中，每个分组是 | 分组键 | 各聚合函数的RmAggState |；
+   槽数组只存哈希值和分组下标，探测时先比哈希值，命中后再比较分组键，探测序列在一段连续内存上 */
+class RmAggHashTable {
+   public:
+    RmAggHashTable(int key_len, int num_aggs);
+
+    RmAggState *find_or_insert(const char *key, uint64_t hash, bool *inserted);
+
+    RmAggState *find(const char *key, uint64_t hash);
+
+    bool erase(const char *key, uint64_t hash);
+
+    void clear();
+
+    size_t size() const { return num_groups_; }
+
+    size_t memory_usage() const {
+        return entries_.capacity() + hashes_.capacity() * sizeof(uint64_t) + slots_.capacity() * sizeof(Slot);
+    }
+
+    int entry_size() const { return entry_size_; }
+
+    const char *get_entry(size_t i) const { return entries_.data() + i * entry_size_; }
+
+    int state_offset() const { return state_offset_; }
+
+   private:
+    struct Slot {
+        uint64_t hash;
+        int64_t idx;    // 分组下标，-1表示空槽
+    };
+
+    void grow();
+
+    int key_len_;
+    int state_offset_;
+    int entry_size_;
+    std::vector<char> entries_;
+    std::vector<uint64_t> hashes_;  // 每个分组的哈希值，erase把最后一个分组移到空出的位置时用来找它的槽
+    std::vector<Slot> slots_;
+    size_t num_groups_ = 0;
+};
+
+struct RmHashAggStats {
+    size_t input_rows = 0;
+    size_t output_groups = 0;
+    size_t spilled_rows = 0;        // 写入溢出分区的（部分）分组数
+    int max_level = 0;              // 最深的递归分区层数
+};
+
+/* GROUP BY哈希聚合。
+   输出记录的格式为 | 各分组列依次拼接 | 每个聚合函数的结果(double) |。
+   内存中的分组数超过预算后，已经在表中的分组继续原地聚合，新分组转成只含一行的部分状态，
+   按哈希值的4位分到16个溢出分区；输入结束后先输出内存中的分组，再对每个分区递归聚合，下一层使用哈希值的下4位。
+   并行扫描时每个线程先在自己的小表里预聚合，小表满了或扫描结束时把部分状态合并进全局聚合 */
+class RmHashAggregate {
+   public:
+    RmHashAggregate(DiskManager *disk_manager, std::vector<RmColumn> group_cols, std::vector<RmAggSpec> aggs,
+                    size_t memory_budget, const std::string &spill_prefix);
+
+    void consume(const char *record);
+
+    void merge(const RmHashAggregate &local);
+
+    void finish(const RmRecordSink &sink);
+
+    void run(const RmOperatorInput &input, const RmRecordSink &sink);
+
+    void run_parallel(RmParallelScan *scan, const RmRecordSink &sink, size_t local_groups = 4096);
+
+    int output_record_size() const { return key_len_ + (int)aggs_.size() * sizeof(double); }
+
+    // 输出记录中第i个聚合函数的结果
+    double get_agg_value(const char *out_rec, int i) const {
+        double ret;
+        memcpy(&ret, out_rec + key_len_ + i * sizeof(double), sizeof(double));
+        return ret;
+    }
+
+    const RmHashAggStats &get_stats() const { return stats_; }
+
+   private:
+    RmHashAggregate(const RmHashAggregate &parent, int level, const std::string &spill_prefix);
+
+    std::unique_ptr<RmHashAggregate> make_local() const;
+
+    void build_key(const char *record, char *key) const;
+
+    void init_states(RmAggState *states) const;
+
+    void update_states(RmAggState *states, const char *record) const;
+
+    void merge_states(RmAggState *states, const RmAggState *other) const;
+
+    void consume_partial(const char *entry, uint64_t hash);
+
+    void spill_entry(const char *entry, uint64_t hash);
+
+    int partition_of(uint64_t hash) const { return (hash >> (60 - 4 * level_)) & 15; }
+
+    DiskManager *disk_manager_;
+    std::vector<RmColumn> group_cols_;
+    std::vector<RmAggSpec> aggs_;
+    size_t memory_budget_;
+    std::string spill_prefix_;      // 为空时不溢出（线程私有的预聚合表）
+    int level_ = 0;
+    int key_len_;
+
+    RmAggHashTable table_;
+    std::vector<std::unique_ptr<RmSpillFile>> partitions_;
+    bool spilling_ = false;
+    std::vector<char> key_buf_;
+    std::vector<char> entry_buf_;
+    RmHashAggStats stats_;
+};
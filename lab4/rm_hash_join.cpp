@@ -0,0 +1,330 @@
+/* Copyright (c) 2023 Renmin University of China
+RMDB is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+        http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#include "rm_hash_join.h"
+
+#include <algorithm>
+#include <cstring>
+
+static constexpr size_t RM_JOIN_PARTITION_TARGET = 256 * 1024;  // 每个分区的目标大小，大致是一个核的L2缓存
+static constexpr int RM_JOIN_MAX_RADIX_BITS = 12;
+static constexpr int RM_JOIN_FANOUT_BITS = 4;       // 溢出分区每一层再分的份数为2^4
+static constexpr int RM_JOIN_MIN_SHIFT = 32;        // 低32位留给桶定位，递归分区只用它上面的位
+
+static uint64_t next_pow2(uint64_t n) {
+    uint64_t ret = 1;
+    while (ret < n) {
+        ret <<= 1;
+    }
+    return ret;
+}
+
+RmBloomFilter::RmBloomFilter(size_t expected_keys, int bits_per_key) {
+    num_bits_ = next_pow2(std::max<uint64_t>((uint64_t)expected_keys * bits_per_key, 1024));
+    // 最优探测次数约为 bits_per_key * ln2
+    num_probes_ = std::max(1, std::min(16, (int)(bits_per_key * 0.69)));
+    bits_.assign(num_bits_ / 64, 0);
+}
+
+void RmBloomFilter::add(uint64_t hash) {
+    uint64_t h2 = (hash >> 32) | 1;
+    for (int i = 0; i < num_probes_; i++) {
+        uint64_t bit = (hash + i * h2) & (num_bits_ - 1);
+        bits_[bit >> 6] |= 1ULL << (bit & 63);
+    }
+}
+
+bool RmBloomFilter::may_contain(uint64_t hash) const {
+    uint64_t h2 = (hash >> 32) | 1;
+    for (int i = 0; i < num_probes_; i++) {
+        uint64_t bit = (hash + i * h2) & (num_bits_ - 1);
+        if ((bits_[bit >> 6] & (1ULL << (bit & 63))) == 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @description: 初始化哈希连接，根据build端的估计大小确定radix分区数
+ * @param {DiskManager*} disk_manager 用于创建溢出文件
+ * @param {RmOperatorInput&} build build端输入，一般是较小的表
+ * @param {RmColumn&} build_key build端连接键
+ * @param {RmOperatorInput&} probe 探测端输入
+ * @param {RmColumn&} probe_key 探测端连接键，类型和长度必须与build_key相同
+ * @param {size_t} memory_budget build端哈希表可以使用的内存字节数
+ * @param {string&} spill_prefix 溢出文件路径前缀
+ */
+RmHashJoin::RmHashJoin(DiskManager *disk_manager, const RmOperatorInput &build, const RmColumn &build_key,
+                       const RmOperatorInput &probe, const RmColumn &probe_key, size_t memory_budget,
+                       const std::string &spill_prefix)
+    : disk_manager_(disk_manager),
+      build_(build),
+      build_key_(build_key),
+      probe_(probe),
+      probe_key_(probe_key),
+      memory_budget_(std::max<size_t>(memory_budget, PAGE_SIZE)),
+      spill_prefix_(spill_prefix),
+      bloom_(0) {
+    if (build_key_.type != probe_key_.type || build_key_.len != probe_key_.len) {
+        throw IncompatibleTypeError(coltype2str(build_key_.type), coltype2str(probe_key_.type));
+    }
+
+    // 分区数取2的幂：既要让每个分区的哈希表大致放进L2，又要让溢出时单个分区不超过预算
+    size_t estimated_bytes = build_.estimated_rows * row_cost();
+    radix_bits_ = 0;
+    while (radix_bits_ < RM_JOIN_MAX_RADIX_BITS &&
+           ((estimated_bytes >> radix_bits_) > RM_JOIN_PARTITION_TARGET ||
+            (estimated_bytes >> radix_bits_) > memory_budget_ / 2)) {
+        radix_bits_++;
+    }
+    partitions_.resize(1 << radix_bits_);
+    stats_.num_partitions = partitions_.size();
+}
+
+/**
+ * @description: 执行连接，对每一对匹配的记录调用emit
+ */
+void RmHashJoin::run(const EmitFunc &emit) {
+    build_phase();
+    probe_phase(emit);
+    for (int i = 0; i < (int)partitions_.size(); i++) {
+        if (partitions_[i].build_spill != nullptr) {
+            join_spilled_partition(i, emit);
+        }
+    }
+}
+
+void RmHashJoin::build_phase() {
+    build_.source([this](const char *record) {
+        uint64_t hash = rm_hash(build_key_.get(record), build_key_.len);
+        add_build_record(record, hash);
+        stats_.build_rows++;
+    });
+    for (Partition &part : partitions_) {
+        if (part.build_spill != nullptr) {
+            part.build_spill->finish();
+        } else {
+            build_table(&part);
+        }
+    }
+    build_bloom();
+}
+
+/**
+ * @description: 按实际的build记录数建Bloom过滤器。build端的估计行数可能是0（比如上一个连接的输出），
+ *               按估计值建的过滤器太小，几乎挡不掉任何探测记录。溢出分区的哈希要重新读一遍溢出文件算出来
+ */
+void RmHashJoin::build_bloom() {
+    bloom_ = RmBloomFilter(stats_.build_rows);
+    for (Partition &part : partitions_) {
+        if (part.build_spill == nullptr) {
+            for (uint64_t hash : part.hashes) {
+                bloom_.add(hash);
+            }
+            continue;
+        }
+        RmSpillReader reader(part.build_spill.get(), true);
+        const char *record;
+        while (reader.next(&record)) {
+            bloom_.add(rm_hash(build_key_.get(record), build_key_.len));
+        }
+    }
+}
+
+void RmHashJoin::probe_phase(const EmitFunc &emit) {
+    probe_.source([this, &emit](const char *record) {
+        stats_.probe_rows++;
+        uint64_t hash = rm_hash(probe_key_.get(record), probe_key_.len);
+        if (!bloom_.may_contain(hash)) {
+            stats_.probe_filtered++;
+            return;
+        }
+        Partition &part = partitions_[partition_of(hash)];
+        if (part.probe_spill != nullptr) {
+            part.probe_spill->append(record);
+        } else {
+            probe_table(part, record, hash, emit);
+        }
+    });
+    for (Partition &part : partitions_) {
+        if (part.probe_spill != nullptr) {
+            part.probe_spill->finish();
+        }
+    }
+}
+
+/**
+ * @description: 把一条build记录放进所属分区，内存超出预算时溢出最大的分区
+ */
+void RmHashJoin::add_build_record(const char *record, uint64_t hash) {
+    int part_id = partition_of(hash);
+    Partition &part = partitions_[part_id];
+    if (part.build_spill != nullptr) {
+        part.build_spill->append(record);
+        return;
+    }
+    part.records.insert(part.records.end(), record, record + build_.record_size);
+    part.hashes.push_back(hash);
+    memory_used_ += row_cost();
+
+    while (memory_used_ > memory_budget_) {
+        int victim = -1;
+        for (int i = 0; i < (int)partitions_.size(); i++) {
+            if (partitions_[i].build_spill == nullptr && partitions_[i].num_rows() > 0 &&
+                (victim == -1 || partitions_[i].num_rows() > partitions_[victim].num_rows())) {
+                victim = i;
+            }
+        }
+        if (victim == -1) {
+            break;
+        }
+        spill_partition(victim);
+    }
+}
+
+void RmHashJoin::spill_partition(int part_id) {
+    Partition &part = partitions_[part_id];
+    std::string prefix = spill_prefix_ + "_" + std::to_string(part_id);
+    part.build_spill = std::make_unique<RmSpillFile>(disk_manager_, prefix + ".build", build_.record_size);
+    part.probe_spill = std::make_unique<RmSpillFile>(disk_manager_, prefix + ".probe", probe_.record_size);
+    for (size_t i = 0; i < part.num_rows(); i++) {
+        part.build_spill->append(part.records.data() + i * build_.record_size);
+    }
+    memory_used_ -= part.num_rows() * row_cost();
+    std::vector<char>().swap(part.records);
+    std::vector<uint64_t>().swap(part.hashes);
+    stats_.spilled_partitions++;
+}
+
+/**
+ * @description: 为分区建立链式哈希表，桶数取不小于两倍记录数的2的幂，用哈希的低位定位桶
+ */
+void RmHashJoin::build_table(Partition *part) {
+    int n = part->num_rows();
+    if (n == 0) {
+        return;
+    }
+    uint64_t num_buckets = next_pow2(std::max(2 * n, 16));
+    part->buckets.assign(num_buckets, -1);
+    part->next.resize(n);
+    for (int i = 0; i < n; i++) {
+        uint64_t bucket = part->hashes[i] & (num_buckets - 1);
+        part->next[i] = part->buckets[bucket];
+        part->buckets[bucket] = i;
+    }
+}
+
+void RmHashJoin::probe_table(const Partition &part, const char *probe_rec, uint64_t hash, const EmitFunc &emit) {
+    if (part.buckets.empty()) {
+        return;
+    }
+    const char *probe_val = probe_key_.get(probe_rec);
+    uint64_t bucket = hash & (part.buckets.size() - 1);
+    for (int i = part.buckets[bucket]; i != -1; i = part.next[i]) {
+        const char *build_rec = part.records.data() + (size_t)i * build_.record_size;
+        if (part.hashes[i] == hash &&
+            rm_compare(build_key_.get(build_rec), probe_val, build_key_.type, build_key_.len) == 0) {
+            emit(build_rec, probe_rec);
+            stats_.output_rows++;
+        }
+    }
+}
+
+/**
+ * @description: 处理一个溢出的分区，处理完删除两个溢出文件
+ */
+void RmHashJoin::join_spilled_partition(int part_id, const EmitFunc &emit) {
+    Partition &part = partitions_[part_id];
+    join_spilled(part.build_spill.get(), part.probe_spill.get(), 1, spill_prefix_ + "_" + std::to_string(part_id),
+                 emit);
+    part.build_spill.reset();
+    part.probe_spill.reset();
+}
+
+/**
+ * @description: 连接一对溢出文件。build端放得进内存预算时直接建表探测；
+ *               放不下时用哈希值中前level层没用过的下4位把两边各分成16份，逐份递归
+ * @param {int} level 递归层数，第level层使用radix分区位之后的第level组4位
+ */
+void RmHashJoin::join_spilled(const RmSpillFile *build_file, const RmSpillFile *probe_file, int level,
+                              const std::string &prefix, const EmitFunc &emit) {
+    if (build_file->num_records() == 0 || probe_file->num_records() == 0) {
+        return;
+    }
+    stats_.max_level = std::max(stats_.max_level, level);
+    size_t max_rows = std::max<size_t>(memory_budget_ / row_cost(), 1);
+    int shift = 64 - radix_bits_ - level * RM_JOIN_FANOUT_BITS;
+    if (build_file->num_records() <= max_rows || shift < RM_JOIN_MIN_SHIFT) {
+        join_chunked(build_file, probe_file, emit);
+        return;
+    }
+
+    int fanout = 1 << RM_JOIN_FANOUT_BITS;
+    std::vector<std::unique_ptr<RmSpillFile>> sub_builds;
+    std::vector<std::unique_ptr<RmSpillFile>> sub_probes;
+    for (int i = 0; i < fanout; i++) {
+        std::string sub_prefix = prefix + "_" + std::to_string(i);
+        sub_builds.push_back(std::make_unique<RmSpillFile>(disk_manager_, sub_prefix + ".build", build_.record_size));
+        sub_probes.push_back(std::make_unique<RmSpillFile>(disk_manager_, sub_prefix + ".probe", probe_.record_size));
+    }
+    const char *record;
+    RmSpillReader build_reader(build_file, true);
+    while (build_reader.next(&record)) {
+        uint64_t hash = rm_hash(build_key_.get(record), build_key_.len);
+        sub_builds[(hash >> shift) & (fanout - 1)]->append(record);
+    }
+    RmSpillReader probe_reader(probe_file, true);
+    while (probe_reader.next(&record)) {
+        uint64_t hash = rm_hash(probe_key_.get(record), probe_key_.len);
+        sub_probes[(hash >> shift) & (fanout - 1)]->append(record);
+    }
+    for (int i = 0; i < fanout; i++) {
+        sub_builds[i]->finish();
+        sub_probes[i]->finish();
+        // 所有记录都分到了同一份，说明键基本相同，再分下去也不会变小，直接分块处理
+        if (sub_builds[i]->num_records() == build_file->num_records()) {
+            join_chunked(sub_builds[i].get(), sub_probes[i].get(), emit);
+        } else {
+            join_spilled(sub_builds[i].get(), sub_probes[i].get(), level + 1, prefix + "_" + std::to_string(i), emit);
+        }
+        sub_builds[i].reset();
+        sub_probes[i].reset();
+    }
+}
+
+/**
+ * @description: 最后的办法：把build端溢出文件按内存预算分块读入，每块建一个哈希表并完整扫描一遍探测端溢出文件
+ */
+void RmHashJoin::join_chunked(const RmSpillFile *build_file, const RmSpillFile *probe_file, const EmitFunc &emit) {
+    RmSpillReader build_reader(build_file);
+    size_t max_rows = std::max<size_t>(memory_budget_ / row_cost(), 1);
+    bool build_done = false;
+    while (!build_done) {
+        Partition chunk;
+        const char *record;
+        while (chunk.num_rows() < max_rows) {
+            if (!build_reader.next(&record)) {
+                build_done = true;
+                break;
+            }
+            chunk.records.insert(chunk.records.end(), record, record + build_.record_size);
+            chunk.hashes.push_back(rm_hash(build_key_.get(record), build_key_.len));
+        }
+        if (chunk.num_rows() == 0) {
+            break;
+        }
+        build_table(&chunk);
+        RmSpillReader probe_reader(probe_file);
+        while (probe_reader.next(&record)) {
+            probe_table(chunk, record, rm_hash(probe_key_.get(record), probe_key_.len), emit);
+        }
+    }
+}
@@ -0,0 +1,117 @@
+/* Copyright (c) 2023 Renmin University of China
+RMDB is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+        http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "rm_column.h"
+#include "rm_record_source.h"
+#include "rm_spill_file.h"
+
+/* 用于在探测前过滤掉一定不会匹配的探测记录，k个位置由同一个64位哈希的两半做double hashing得到 */
+class RmBloomFilter {
+   public:
+    explicit RmBloomFilter(size_t expected_keys, int bits_per_key = 10);
+
+    void add(uint64_t hash);
+
+    bool may_contain(uint64_t hash) const;
+
+   private:
+    std::vector<uint64_t> bits_;
+    uint64_t num_bits_;
+    int num_probes_;
+};
+
+struct RmHashJoinStats {
+    size_t build_rows = 0;
+    size_t probe_rows = 0;
+    size_t probe_filtered = 0;      // 被Bloom过滤器挡掉的探测记录数
+    size_t output_rows = 0;
+    int num_partitions = 0;
+    int spilled_partitions = 0;
+    int max_level = 0;              // 溢出分区最深的递归分区层数
+};
+
+/* 等值哈希连接。
+   build端按键的哈希高位做radix分区，每个分区单独建一个小哈希表，让探测时访问的哈希表能放进缓存；
+   build阶段结束后按实际的build记录数建Bloom过滤器，探测记录先查过滤器再查哈希表。
+   内存占用超过memory_budget时把最大的分区整个溢出到磁盘，这个分区后续的build记录和对应的探测记录都写到溢出文件，
+   内存中的分区处理完后再逐个处理溢出的分区：仍然放不下时用哈希值的下4位把两边再分成16份递归处理，
+   哈希位用完或者某份没有变小（大量相同的键）时才按预算分块，每块扫描一遍探测端的溢出文件 */
+class RmHashJoin {
+   public:
+    // 每找到一对匹配的记录调用一次，两个地址只在调用期间有效
+    using EmitFunc = std::function<void(const char *build_rec, const char *probe_rec)>;
+
+    RmHashJoin(DiskManager *disk_manager, const RmOperatorInput &build, const RmColumn &build_key,
+               const RmOperatorInput &probe, const RmColumn &probe_key, size_t memory_budget,
+               const std::string &spill_prefix);
+
+    void run(const EmitFunc &emit);
+
+    const RmHashJoinStats &get_stats() const { return stats_; }
+
+   private:
+    struct Partition {
+        std::vector<char> records;          // 分区中的build记录，紧密排列
+        std::vector<uint64_t> hashes;       // 每条build记录键的哈希
+        std::vector<int> buckets;           // 桶内第一条记录的下标，-1表示空桶
+        std::vector<int> next;              // 同一个桶中下一条记录的下标
+        std::unique_ptr<RmSpillFile> build_spill;
+        std::unique_ptr<RmSpillFile> probe_spill;
+
+        size_t num_rows() const { return hashes.size(); }
+    };
+
+    void build_phase();
+
+    void probe_phase(const EmitFunc &emit);
+
+    void build_bloom();
+
+    void join_spilled_partition(int part_id, const EmitFunc &emit);
+
+    void join_spilled(const RmSpillFile *build_file, const RmSpillFile *probe_file, int level,
+                      const std::string &prefix, const EmitFunc &emit);
+
+    void join_chunked(const RmSpillFile *build_file, const RmSpillFile *probe_file, const EmitFunc &emit);
+
+    void add_build_record(const char *record, uint64_t hash);
+
+    void spill_partition(int part_id);
+
+    void build_table(Partition *part);
+
+    void probe_table(const Partition &part, const char *probe_rec, uint64_t hash, const EmitFunc &emit);
+
+    int partition_of(uint64_t hash) const { return radix_bits_ == 0 ? 0 : (int)(hash >> (64 - radix_bits_)); }
+
+    size_t row_cost() const { return build_.record_size + sizeof(uint64_t) + 2 * sizeof(int); }
+
+    DiskManager *disk_manager_;
+    RmOperatorInput build_;
+    RmColumn build_key_;
+    RmOperatorInput probe_;
+    RmColumn probe_key_;
+    size_t memory_budget_;
+    std::string spill_prefix_;
+
+    int radix_bits_;
+    std::vector<Partition> partitions_;
+    size_t memory_used_ = 0;
+    RmBloomFilter bloom_;
+    RmHashJoinStats stats_;
+};
@@ -0,0 +1,236 @@
+/* Copyright (c) 2023 Renmin University of China
+RMDB is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+        http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#include "rm_materialized_agg.h"
+
+#include <algorithm>
+#include <cmath>
+
+/**
+ * @description: 创建物化聚合，登记为文件的写回调并扫描一遍文件得到初始结果
+ * @param {RmFileHandle*} file_handle 记录文件
+ * @param {BufferPoolManager*} buffer_pool_manager
+ * @param {shared_mutex*} table_latch 写操作持有的表锁，扫描期间持有它的共享锁；为空时调用方自己保证没有并发的写
+ * @param {vector<RmColumn>} group_cols 分组列，分组键为各列依次拼接
+ * @param {vector<RmAggSpec>} aggs 聚合函数，只能是AGG_COUNT/AGG_SUM/AGG_AVG，至少一个
+ */
+RmMaterializedAgg::RmMaterializedAgg(RmFileHandle *file_handle, BufferPoolManager *buffer_pool_manager,
+                                     std::shared_mutex *table_latch, std::vector<RmColumn> group_cols,
+                                     std::vector<RmAggSpec> aggs)
+    : file_handle_(file_handle),
+      buffer_pool_manager_(buffer_pool_manager),
+      table_latch_(table_latch),
+      group_cols_(std::move(group_cols)),
+      aggs_(std::move(aggs)),
+      table_(0, 0) {
+    for (const RmColumn &col : group_cols_) {
+        key_len_ += col.len;
+    }
+    // 分组的记录数记在每个聚合状态的cnt里，没有聚合函数就不知道分组什么时候变空
+    if (aggs_.empty()) {
+        throw InternalError("RmMaterializedAgg: at least one aggregate is required");
+    }
+    for (const RmAggSpec &agg : aggs_) {
+        if (agg.type == AGG_MIN || agg.type == AGG_MAX) {
+            throw InternalError("RmMaterializedAgg: MIN/MAX cannot be maintained incrementally");
+        }
+        if (agg.type != AGG_COUNT && agg.col.type != TYPE_INT && agg.col.type != TYPE_FLOAT) {
+            throw IncompatibleTypeError(coltype2str(agg.col.type), "INT or FLOAT");
+        }
+    }
+    table_ = RmAggHashTable(key_len_, aggs_.size());
+    key_buf_.resize(std::max(key_len_, 1));
+    // 先登记回调再扫描，两步都在latch_下：扫描期间的写会在回调里等latch_，等到扫描结束才计入，
+    // 而它们在回调之后才改页面，扫描读不到，不会重复或遗漏。
+    // 登记之前已经越过回调、还没改完页面的写会漏掉，所以先拿表锁的共享锁，等这样的写做完
+    std::shared_lock<std::shared_mutex> table_lock;
+    if (table_latch_ != nullptr) {
+        table_lock = std::shared_lock<std::shared_mutex>(*table_latch_);
+    }
+    std::scoped_lock lock{latch_};
+    RmFileHookRegistry::add_hook(file_handle_->GetFd(), this);
+    scan_into(&table_);
+}
+
+RmMaterializedAgg::~RmMaterializedAgg() { RmFileHookRegistry::remove_hook(file_handle_->GetFd(), this); }
+
+void RmMaterializedAgg::build_key(const char *record, char *key) const {
+    for (const RmColumn &col : group_cols_) {
+        memcpy(key, col.get(record), col.len);
+        key += col.len;
+    }
+}
+
+// sign为1时把记录加入它的分组，为-1时移出，分组变空时从表中删除
+void RmMaterializedAgg::apply(RmAggHashTable *table, const char *record, int sign) {
+    char *key = key_buf_.data();
+    build_key(record, key);
+    bool inserted;
+    RmAggState *states = table->find_or_insert(key, rm_hash(key, key_len_), &inserted);
+    if (inserted) {
+        for (size_t i = 0; i < aggs_.size(); i++) {
+            states[i].val = 0;
+            states[i].cnt = 0;
+        }
+    }
+    for (size_t i = 0; i < aggs_.size(); i++) {
+        states[i].cnt += sign;
+        if (aggs_[i].type != AGG_COUNT) {
+            states[i].val += sign * rm_agg_value(record, aggs_[i].col);
+        }
+    }
+    if (states[0].cnt <= 0) {
+        table->erase(key, rm_hash(key, key_len_));
+    }
+}
+
+// 扫描文件中的所有记录，聚合到table中
+void RmMaterializedAgg::scan_into(RmAggHashTable *table) {
+    RmFileHdr file_hdr = file_handle_->get_file_hdr();
+    int n = file_hdr.num_records_per_page;
+    for (int page_no = RM_FIRST_RECORD_PAGE; page_no < file_hdr.num_pages; page_no++) {
+        RmPageHandle page_handle = file_handle_->fetch_page_handle(page_no);
+        for (int slot_no = Bitmap::first_bit(true, page_handle.bitmap, n); slot_no < n;
+             slot_no = Bitmap::next_bit(true, page_handle.bitmap, n, slot_no)) {
+            apply(table, page_handle.get_slot(slot_no), 1);
+        }
+        buffer_pool_manager_->unpin_page(page_handle.page->get_page_id(), false);
+    }
+}
+
+double RmMaterializedAgg::agg_result(const RmAggState *states, int i) const {
+    switch (aggs_[i].type) {
+        case AGG_COUNT: return (double)states[i].cnt;
+        case AGG_AVG: return states[i].cnt == 0 ? 0 : states[i].val / states[i].cnt;
+        default: return states[i].val;
+    }
+}
+
+/**
+ * @description: 扫描整个文件，重新计算所有分组
+ */
+void RmMaterializedAgg::rebuild() {
+    std::shared_lock<std::shared_mutex> table_lock;
+    if (table_latch_ != nullptr) {
+        table_lock = std::shared_lock<std::shared_mutex>(*table_latch_);
+    }
+    std::scoped_lock lock{latch_};
+    table_.clear();
+    scan_into(&table_);
+}
+
+/**
+ * @description: 读取一个分组的所有聚合结果
+ * @return {bool} 分组是否存在（有至少一条记录）
+ * @param {char*} key 分组键，各分组列按存储格式依次拼接
+ * @param {vector<double>*} values 按aggs的顺序输出各聚合函数的结果
+ */
+bool RmMaterializedAgg::get(const char *key, std::vector<double> *values) {
+    std::scoped_lock lock{latch_};
+    RmAggState *states = table_.find(key, rm_hash(key, key_len_));
+    if (states == nullptr) {
+        return false;
+    }
+    values->resize(aggs_.size());
+    for (size_t i = 0; i < aggs_.size(); i++) {
+        (*values)[i] = agg_result(states, i);
+    }
+    return true;
+}
+
+/**
+ * @description: 读取一个分组第i个聚合函数的结果，分组不存在时返回0
+ */
+double RmMaterializedAgg::get(const char *key, int i) {
+    std::scoped_lock lock{latch_};
+    RmAggState *states = table_.find(key, rm_hash(key, key_len_));
+    return states == nullptr ? 0 : agg_result(states, i);
+}
+
+/**
+ * @description: 读取一个分组中的记录数
+ */
+int64_t RmMaterializedAgg::get_count(const char *key) {
+    std::scoped_lock lock{latch_};
+    RmAggState *states = table_.find(key, rm_hash(key, key_len_));
+    return states == nullptr ? 0 : states[0].cnt;
+}
+
+/**
+ * @description: 当前有记录的分组数
+ */
+size_t RmMaterializedAgg::num_groups() {
+    std::scoped_lock lock{latch_};
+    return table_.size();
+}
+
+/**
+ * @description: 重新扫描文件计算一遍，和增量维护的结果逐个分组比较，期间阻塞文件上的写
+ * @return {RmAggCheckResult} 比较的分组数和不一致的分组数
+ */
+RmAggCheckResult RmMaterializedAgg::check_consistency() {
+    std::shared_lock<std::shared_mutex> table_lock;
+    if (table_latch_ != nullptr) {
+        table_lock = std::shared_lock<std::shared_mutex>(*table_latch_);
+    }
+    std::scoped_lock lock{latch_};
+    RmAggHashTable fresh(key_len_, aggs_.size());
+    scan_into(&fresh);
+
+    RmAggCheckResult result;
+    auto states_of = [&](const RmAggHashTable &table, size_t i) {
+        return (const RmAggState *)(table.get_entry(i) + table.state_offset());
+    };
+    auto same = [&](const RmAggState *a, const RmAggState *b) {
+        for (size_t i = 0; i < aggs_.size(); i++) {
+            int64_t a_cnt = a == nullptr ? 0 : a[i].cnt;
+            int64_t b_cnt = b == nullptr ? 0 : b[i].cnt;
+            double a_val = a == nullptr ? 0 : a[i].val;
+            double b_val = b == nullptr ? 0 : b[i].val;
+            // 累加和经过多次加减会有浮点误差，按相对误差比较
+            if (a_cnt != b_cnt || std::fabs(a_val - b_val) > 1e-6 * std::max(1.0, std::fabs(b_val))) {
+                return false;
+            }
+        }
+        return true;
+    };
+    for (size_t i = 0; i < fresh.size(); i++) {
+        const char *key = fresh.get_entry(i);
+        result.groups_checked++;
+        if (!same(table_.find(key, rm_hash(key, key_len_)), states_of(fresh, i))) {
+            result.mismatched_groups++;
+        }
+    }
+    // 维护的结果中还有、文件里却已经没有的分组
+    for (size_t i = 0; i < table_.size(); i++) {
+        const char *key = table_.get_entry(i);
+        if (fresh.find(key, rm_hash(key, key_len_)) == nullptr) {
+            result.groups_checked++;
+            result.mismatched_groups++;
+        }
+    }
+    return result;
+}
+
+void RmMaterializedAgg::on_insert(const Rid &rid, const char *new_buf) {
+    std::scoped_lock lock{latch_};
+    apply(&table_, new_buf, 1);
+}
+
+void RmMaterializedAgg::on_update(const Rid &rid, const char *old_buf, const char *new_buf) {
+    std::scoped_lock lock{latch_};
+    apply(&table_, old_buf, -1);
+    apply(&table_, new_buf, 1);
+}
+
+void RmMaterializedAgg::on_delete(const Rid &rid, const char *old_buf) {
+    std::scoped_lock lock{latch_};
+    apply(&table_, old_buf, -1);
+}
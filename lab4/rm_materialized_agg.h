@@ -0,0 +1,80 @@
+/* Copyright (c) 2023 Renmin University of China
+RMDB is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+        http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#pragma once
+
+#include <mutex>
+#include <shared_mutex>
+#include <vector>
+
+#include "rm_file_handle.h"
+#include "rm_file_hook.h"
+#include "rm_hash_agg.h"
+
+struct RmAggCheckResult {
+    size_t groups_checked = 0;
+    size_t mismatched_groups = 0;   // 计数不同、累加和不同、或只在一边出现的分组
+
+    bool consistent() const { return mismatched_groups == 0; }
+};
+
+/* 记录文件上增量维护的分组聚合（物化聚合），只支持COUNT/SUM/AVG。
+   创建时扫描一遍文件得到初始结果，之后通过RmFileHook在insert/update/delete时把记录加入或移出对应分组，
+   读某个分组的结果只需要一次哈希查找，不用再扫描文件。
+   MIN/MAX在删除时无法增量维护，不支持。分组的记录数减到0时从表中删除，分组数不会随着增删无限增长。
+   创建、rebuild()和check_consistency()都要扫描文件，扫描期间持有table_latch的共享锁，
+   保证没有已经越过回调、还没改完页面的写；table_latch为空时调用方要自己保证文件上没有并发的写操作 */
+class RmMaterializedAgg : public RmFileHook {
+   public:
+    RmMaterializedAgg(RmFileHandle *file_handle, BufferPoolManager *buffer_pool_manager,
+                      std::shared_mutex *table_latch, std::vector<RmColumn> group_cols, std::vector<RmAggSpec> aggs);
+
+    ~RmMaterializedAgg();
+
+    bool get(const char *key, std::vector<double> *values);
+
+    double get(const char *key, int i);
+
+    int64_t get_count(const char *key);
+
+    size_t num_groups();
+
+    int key_len() const { return key_len_; }
+
+    void rebuild();
+
+    RmAggCheckResult check_consistency();
+
+    void on_insert(const Rid &rid, const char *new_buf) override;
+
+    void on_update(const Rid &rid, const char *old_buf, const char *new_buf) override;
+
+    void on_delete(const Rid &rid, const char *old_buf) override;
+
+   private:
+    void build_key(const char *record, char *key) const;
+
+    void apply(RmAggHashTable *table, const char *record, int sign);
+
+    void scan_into(RmAggHashTable *table);
+
+    double agg_result(const RmAggState *states, int i) const;
+
+    RmFileHandle *file_handle_;
+    BufferPoolManager *buffer_pool_manager_;
+    std::shared_mutex *table_latch_;
+    std::vector<RmColumn> group_cols_;
+    std::vector<RmAggSpec> aggs_;
+    int key_len_ = 0;
+
+    std::mutex latch_;          // 在table_latch_之后获取
+    RmAggHashTable table_;      // 只有记录数大于0的分组
+    std::vector<char> key_buf_;
+};
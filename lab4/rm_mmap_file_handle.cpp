@@ -0,0 +1,174 @@
+/* Copyright (c) 2023 Renmin University of China
+RMDB is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+        http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#include "rm_mmap_file_handle.h"
+
+#include <fcntl.h>     // for open
+#include <string.h>    // for memcpy
+#include <sys/file.h>  // for flock
+#include <sys/mman.h>  // for mmap, madvise
+#include <sys/stat.h>  // for fstat
+#include <unistd.h>    // for close
+
+#include <algorithm>
+
+/**
+ * @description: 只读打开并映射表文件，文件正被DiskManager读写打开时抛出InternalError
+ * @param {string&} path 表文件路径
+ * @param {RmMmapAdvice} advice 访问模式提示，扫描为主用SEQUENTIAL，点查为主用RANDOM
+ */
+RmMmapFileHandle::RmMmapFileHandle(const std::string &path, RmMmapAdvice advice) : path_(path), advice_(advice) {
+    fd_ = open(path.c_str(), O_RDONLY);
+    if (fd_ < 0) {
+        throw UnixError();
+    }
+    // 共享锁一直持有到析构关闭fd，期间DiskManager::open_file拿不到排他锁，文件不会被修改
+    if (flock(fd_, LOCK_SH | LOCK_NB) < 0) {
+        close(fd_);
+        throw InternalError("RmMmapFileHandle: file is open for writing " + path_);
+    }
+    try {
+        map_file();
+    } catch (...) {
+        close(fd_);
+        throw;
+    }
+}
+
+RmMmapFileHandle::~RmMmapFileHandle() {
+    unmap_file();
+    if (fd_ >= 0) {
+        close(fd_);
+    }
+}
+
+/**
+ * @description: 修改映射区的访问模式提示
+ * @param {RmMmapAdvice} advice
+ */
+void RmMmapFileHandle::advise(RmMmapAdvice advice) {
+    advice_ = advice;
+    if (base_ == nullptr) {
+        return;
+    }
+    int flag = MADV_NORMAL;
+    if (advice_ == MMAP_ADVICE_SEQUENTIAL) {
+        flag = MADV_SEQUENTIAL;
+    } else if (advice_ == MMAP_ADVICE_RANDOM) {
+        flag = MADV_RANDOM;
+    }
+    // madvise只是提示，失败不影响正确性
+    madvise(base_, map_size_, flag);
+}
+
+void RmMmapFileHandle::map_file() {
+    struct stat st;
+    if (fstat(fd_, &st) < 0) {
+        throw UnixError();
+    }
+    if (st.st_size < (off_t)sizeof(RmFileHdr)) {
+        throw InternalError("RmMmapFileHandle: file too small " + path_);
+    }
+    map_size_ = st.st_size;
+    void *addr = mmap(nullptr, map_size_, PROT_READ, MAP_SHARED, fd_, 0);
+    if (addr == MAP_FAILED) {
+        base_ = nullptr;
+        throw UnixError();
+    }
+    base_ = static_cast<char *>(addr);
+    num_mapped_pages_ = map_size_ / PAGE_SIZE;
+    memcpy(&file_hdr_, base_ + RM_FILE_HDR_PAGE * PAGE_SIZE, sizeof(file_hdr_));
+    advise(advice_);
+}
+
+void RmMmapFileHandle::unmap_file() {
+    if (base_ != nullptr) {
+        munmap(base_, map_size_);
+        base_ = nullptr;
+        map_size_ = 0;
+        num_mapped_pages_ = 0;
+    }
+}
+
+/**
+ * @description: 返回页面在映射区中的首地址
+ * @param {int} page_no 页面号
+ */
+const char *RmMmapFileHandle::get_page(int page_no) const {
+    if (page_no <= RM_FILE_HDR_PAGE || page_no >= std::min(file_hdr_.num_pages, num_mapped_pages_)) {
+        throw PageNotExistError(path_, page_no);
+    }
+    return base_ + (size_t)page_no * PAGE_SIZE;
+}
+
+bool RmMmapFileHandle::is_record(const Rid &rid) const { return get_slot(rid) != nullptr; }
+
+/**
+ * @description: 返回rid对应记录在映射区中的地址
+ * @param {Rid&} rid 记录号
+ * @return {char*} 记录的地址，和RmFileHandle一样，页面不存在、slot越界或为空时返回nullptr
+ */
+const char *RmMmapFileHandle::get_slot(const Rid &rid) const {
+    if (rid.page_no <= RM_FILE_HDR_PAGE || rid.page_no >= std::min(file_hdr_.num_pages, num_mapped_pages_) ||
+        rid.slot_no < 0 || rid.slot_no >= file_hdr_.num_records_per_page) {
+        return nullptr;
+    }
+    const char *bitmap = get_bitmap(rid.page_no);
+    if (!Bitmap::is_set(bitmap, rid.slot_no)) {
+        return nullptr;
+    }
+    return bitmap + file_hdr_.bitmap_size + rid.slot_no * file_hdr_.record_size;
+}
+
+/**
+ * @description: 获取rid对应的记录，从映射区拷贝一份出来
+ * @param {Rid&} rid 记录号
+ * @return {unique_ptr<RmRecord>} rid对应的记录，没有这条记录时返回nullptr
+ */
+std::unique_ptr<RmRecord> RmMmapFileHandle::get_record(const Rid &rid) const {
+    const char *slot = get_slot(rid);
+    if (slot == nullptr) {
+        return nullptr;
+    }
+    auto record = std::make_unique<RmRecord>(file_hdr_.record_size);
+    memcpy(record->data, slot, file_hdr_.record_size);
+    return record;
+}
+
+/**
+ * @brief 初始化扫描，rid指向第一条记录
+ */
+RmMmapScan::RmMmapScan(const RmMmapFileHandle *file_handle) : file_handle_(file_handle) {
+    rid_.page_no = RM_FIRST_RECORD_PAGE;
+    rid_.slot_no = -1;
+    next();
+}
+
+/**
+ * @brief 找到下一条记录，直接在映射区的bitmap上查找
+ */
+void RmMmapScan::next() {
+    const RmFileHdr &hdr = file_handle_->file_hdr_;
+    int end_page = std::min(hdr.num_pages, file_handle_->num_mapped_pages_);
+    while (rid_.page_no < end_page) {
+        const char *bitmap = file_handle_->get_bitmap(rid_.page_no);
+        rid_.slot_no = Bitmap::next_bit(true, bitmap, hdr.num_records_per_page, rid_.slot_no);
+        if (rid_.slot_no < hdr.num_records_per_page) {
+            return;
+        }
+        rid_.page_no++;
+        rid_.slot_no = -1;
+    }
+    rid_.slot_no = -1;
+}
+
+bool RmMmapScan::is_end() const {
+    return rid_.page_no >= std::min(file_handle_->file_hdr_.num_pages, file_handle_->num_mapped_pages_);
+}
@@ -0,0 +1,87 @@
+/* Copyright (c) 2023 Renmin University of China
+RMDB is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+        http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#pragma once
+
+#include <memory>
+#include <string>
+
+#include "bitmap.h"
+#include "rm_defs.h"
+
+/* 对映射区访问模式的提示，对应madvise的参数 */
+enum RmMmapAdvice { MMAP_ADVICE_NORMAL, MMAP_ADVICE_SEQUENTIAL, MMAP_ADVICE_RANDOM };
+
+/* 只读的内存映射表访问方式。
+   适用于cafeteria、shangpu、dish这种装载后只读的参照表：把整个表文件只读映射进地址空间，
+   get_record和扫描直接读映射区，不经过BufferPoolManager的哈希、pin和latch。
+   映射区读的时候不加任何锁，只有文件不会被同时修改才安全，所以映射期间持有文件的共享flock，
+   DiskManager::open_file要加排他flock，两者互斥：文件已经被RmManager打开时不能映射，映射期间也不能打开来写。
+   修改参照表时先析构映射，通过RmManager打开、写入、关闭（关闭时页面和文件头都写回磁盘），再重新映射 */
+class RmMmapFileHandle {
+    friend class RmMmapScan;
+
+   private:
+    std::string path_;
+    int fd_ = -1;           // 只读打开的文件句柄，和DiskManager里读写打开的句柄相互独立
+    char *base_ = nullptr;  // 映射区首地址
+    size_t map_size_ = 0;   // 映射区大小
+    int num_mapped_pages_ = 0;  // 映射区中完整页面的个数
+    RmFileHdr file_hdr_;
+    RmMmapAdvice advice_;
+
+   public:
+    RmMmapFileHandle(const std::string &path, RmMmapAdvice advice = MMAP_ADVICE_NORMAL);
+
+    ~RmMmapFileHandle();
+
+    RmMmapFileHandle(const RmMmapFileHandle &) = delete;
+    RmMmapFileHandle &operator=(const RmMmapFileHandle &) = delete;
+
+    void advise(RmMmapAdvice advice);
+
+    const RmFileHdr &get_file_hdr() const { return file_hdr_; }
+
+    bool is_record(const Rid &rid) const;
+
+    // 直接返回映射区中记录的地址，不拷贝，析构之后失效；没有这条记录时返回nullptr
+    const char *get_slot(const Rid &rid) const;
+
+    std::unique_ptr<RmRecord> get_record(const Rid &rid) const;
+
+   private:
+    void map_file();
+
+    void unmap_file();
+
+    const char *get_page(int page_no) const;
+
+    const char *get_bitmap(int page_no) const {
+        return get_page(page_no) + Page::OFFSET_PAGE_HDR + sizeof(RmPageHdr);
+    }
+};
+
+/* 在映射区上的顺序扫描，行为和RmScan一致 */
+class RmMmapScan : public RecScan {
+    const RmMmapFileHandle *file_handle_;
+    Rid rid_;
+
+   public:
+    RmMmapScan(const RmMmapFileHandle *file_handle);
+
+    void next() override;
+
+    bool is_end() const override;
+
+    Rid rid() const override { return rid_; }
+
+    // 当前记录在映射区中的地址
+    const char *record() const { return file_handle_->get_slot(rid_); }
+};
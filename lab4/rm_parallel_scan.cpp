@@ -0,0 +1,155 @@
+/* Copyright (c) 2023 Renmin University of China
+RMDB is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+        http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#include "rm_parallel_scan.h"
+
+#include <algorithm>
+#include <exception>
+#include <thread>
+
+void RmMorselQueue::push(const RmMorsel &morsel) {
+    std::scoped_lock lock{latch_};
+    morsels_.push_back(morsel);
+}
+
+bool RmMorselQueue::pop_front(RmMorsel *morsel) {
+    std::scoped_lock lock{latch_};
+    if (morsels_.empty()) {
+        return false;
+    }
+    *morsel = morsels_.front();
+    morsels_.pop_front();
+    return true;
+}
+
+bool RmMorselQueue::steal_back(RmMorsel *morsel) {
+    std::scoped_lock lock{latch_};
+    if (morsels_.empty()) {
+        return false;
+    }
+    *morsel = morsels_.back();
+    morsels_.pop_back();
+    return true;
+}
+
+/**
+ * @param num_workers 工作线程数，为0时使用std::thread::hardware_concurrency()
+ * @param morsel_pages 每个morsel包含的页面数
+ */
+RmParallelScan::RmParallelScan(RmFileHandle *file_handle, BufferPoolManager *buffer_pool_manager, int num_workers,
+                               int morsel_pages)
+    : file_handle_(file_handle), buffer_pool_manager_(buffer_pool_manager), morsel_pages_(std::max(morsel_pages, 1)) {
+    if (num_workers <= 0) {
+        num_workers = std::max(1u, std::thread::hardware_concurrency());
+    }
+    num_workers_ = num_workers;
+}
+
+/**
+ * @brief 扫描morsel中的所有页面，对每条记录调用func
+ */
+void RmParallelScan::process_morsel(int worker_id, const RmMorsel &morsel, const RmFileHdr &file_hdr,
+                                    const RecordFunc &func) {
+    int n = file_hdr.num_records_per_page;
+    for (int page_no = morsel.start_page_no; page_no < morsel.end_page_no; page_no++) {
+        RmPageHandle page_handle = file_handle_->fetch_page_handle(page_no);
+        if (page_handle.page_hdr->num_records > 0) {
+            for (int slot_no = Bitmap::first_bit(true, page_handle.bitmap, n); slot_no < n;
+                 slot_no = Bitmap::next_bit(true, page_handle.bitmap, n, slot_no)) {
+                func(worker_id, Rid{page_no, slot_no}, page_handle.get_slot(slot_no));
+            }
+        }
+        buffer_pool_manager_->unpin_page(page_handle.page->get_page_id(), false);
+    }
+}
+
+/**
+ * @brief 并行扫描整个文件，对每条记录调用func，所有线程结束后返回
+ * @note 工作线程中抛出的异常会在所有线程结束后重新抛给调用方
+ */
+void RmParallelScan::run(const RecordFunc &func) {
+    RmFileHdr file_hdr = file_handle_->get_file_hdr();
+
+    std::vector<RmMorsel> morsels;
+    for (int page_no = RM_FIRST_RECORD_PAGE; page_no < file_hdr.num_pages; page_no += morsel_pages_) {
+        morsels.push_back(RmMorsel{page_no, std::min(page_no + morsel_pages_, file_hdr.num_pages)});
+    }
+    if (morsels.empty()) {
+        return;
+    }
+
+    int num_workers = std::min<int>(num_workers_, morsels.size());
+    std::vector<RmMorselQueue> queues(num_workers);
+    size_t per_worker = (morsels.size() + num_workers - 1) / num_workers;
+    for (size_t i = 0; i < morsels.size(); i++) {
+        queues[i / per_worker].push(morsels[i]);
+    }
+
+    std::mutex error_latch;
+    std::exception_ptr error = nullptr;
+    auto worker = [&](int worker_id) {
+        try {
+            RmMorsel morsel;
+            while (true) {
+                if (queues[worker_id].pop_front(&morsel)) {
+                    process_morsel(worker_id, morsel, file_hdr, func);
+                    continue;
+                }
+                // 自己的队列空了，依次去其他线程的队列尾部偷取
+                bool stolen = false;
+                for (int i = 1; i < num_workers && !stolen; i++) {
+                    stolen = queues[(worker_id + i) % num_workers].steal_back(&morsel);
+                }
+                if (!stolen) {
+                    break;
+                }
+                process_morsel(worker_id, morsel, file_hdr, func);
+            }
+        } catch (...) {
+            std::scoped_lock lock{error_latch};
+            if (error == nullptr) {
+                error = std::current_exception();
+            }
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (int i = 1; i < num_workers; i++) {
+        threads.emplace_back(worker, i);
+    }
+    worker(0);  // 调用线程自己也作为0号工作线程
+    for (auto &thread : threads) {
+        thread.join();
+    }
+    if (error != nullptr) {
+        std::rethrow_exception(error);
+    }
+}
+
+/**
+ * @brief 并行统计满足pred的记录数，每个线程在自己的计数器上累加，最后求和
+ */
+size_t RmParallelScan::count_if(const std::function<bool(const char *record)> &pred) {
+    // 计数器按缓存行对齐，避免不同线程的计数器落在同一缓存行上
+    struct alignas(64) Counter {
+        size_t value = 0;
+    };
+    std::vector<Counter> counters(num_workers_);
+    run([&](int worker_id, const Rid &rid, const char *record) {
+        if (pred(record)) {
+            counters[worker_id].value++;
+        }
+    });
+    size_t total = 0;
+    for (const Counter &counter : counters) {
+        total += counter.value;
+    }
+    return total;
+}
@@ -0,0 +1,86 @@
+/* Copyright (c) 2023 Renmin University of China
+RMDB is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+        http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#pragma once
+
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "rm_file_handle.h"
+
+/* 一个morsel：文件中连续的一段页面 [start_page_no, end_page_no) */
+struct RmMorsel {
+    int start_page_no;
+    int end_page_no;
+};
+
+/* 每个工作线程自己的morsel队列。自己从队头取，别的线程从队尾偷，
+   这样自己处理的页面尽量连续，被偷走的是离自己最远的那部分 */
+class RmMorselQueue {
+   public:
+    void push(const RmMorsel &morsel);
+
+    bool pop_front(RmMorsel *morsel);
+
+    bool steal_back(RmMorsel *morsel);
+
+   private:
+    std::mutex latch_;
+    std::deque<RmMorsel> morsels_;
+};
+
+/* 基于morsel的并行表扫描。
+   把文件的记录页切成若干morsel，按页号顺序分成连续的几段，每个工作线程的队列放一段，
+   线程处理完自己的队列后去其他线程的队列尾部偷取。
+   回调在工作线程中执行，参数worker_id可以用来写线程私有的输出缓冲区，扫描结束后再由调用方合并 */
+class RmParallelScan {
+   public:
+    // 回调参数：工作线程编号、记录号、记录在页面中的地址（只在回调期间有效）
+    using RecordFunc = std::function<void(int worker_id, const Rid &rid, const char *record)>;
+
+    RmParallelScan(RmFileHandle *file_handle, BufferPoolManager *buffer_pool_manager, int num_workers = 0,
+                   int morsel_pages = 16);
+
+    void run(const RecordFunc &func);
+
+    size_t count_if(const std::function<bool(const char *record)> &pred);
+
+    template <typename T>
+    std::vector<std::vector<T>> collect(const std::function<bool(const char *record, T *out)> &func);
+
+    int get_num_workers() const { return num_workers_; }
+
+   private:
+    void process_morsel(int worker_id, const RmMorsel &morsel, const RmFileHdr &file_hdr, const RecordFunc &func);
+
+    RmFileHandle *file_handle_;
+    BufferPoolManager *buffer_pool_manager_;
+    int num_workers_;
+    int morsel_pages_;
+};
+
+/**
+ * @brief 并行扫描并把func产生的结果写入各线程私有的输出缓冲区，返回每个线程的缓冲区，由调用方合并
+ * @param func 对每条记录调用，返回true时把*out放进当前线程的缓冲区
+ */
+template <typename T>
+std::vector<std::vector<T>> RmParallelScan::collect(const std::function<bool(const char *record, T *out)> &func) {
+    std::vector<std::vector<T>> outputs(num_workers_);
+    run([&](int worker_id, const Rid &rid, const char *record) {
+        T out;
+        if (func(record, &out)) {
+            outputs[worker_id].push_back(std::move(out));
+        }
+    });
+    return outputs;
+}
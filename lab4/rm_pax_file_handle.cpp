@@ -0,0 +1,306 @@
+/* Copyright (c) 2023 Renmin University of China
+RMDB is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+        http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#include "rm_pax_file_handle.h"
+
+#include <algorithm>
+#include <cstring>
+
+static int pax_align(int offset) { return (offset + RM_PAX_MINIPAGE_ALIGN - 1) / RM_PAX_MINIPAGE_ALIGN * RM_PAX_MINIPAGE_ALIGN; }
+
+/**
+ * @description: 按照给定的列布局计算每页记录数和各minipage的偏移，尝试放下的记录数从上界开始递减，直到所有minipage都能放进一页
+ * @param {RmPaxFileHdr*} hdr 要填写的文件头，num_cols/col_offset/col_len需要已经填好
+ */
+static void pax_layout(RmPaxFileHdr *hdr) {
+    int page_hdr_end = Page::OFFSET_PAGE_HDR + sizeof(RmPageHdr);
+    int n = (PAGE_SIZE - page_hdr_end) * BITMAP_WIDTH / (hdr->record_size * BITMAP_WIDTH + 1);
+    for (; n > 0; n--) {
+        int bitmap_size = (n + BITMAP_WIDTH - 1) / BITMAP_WIDTH;
+        int offset = pax_align(page_hdr_end + bitmap_size);
+        for (int i = 0; i < hdr->num_cols; i++) {
+            hdr->minipage_offset[i] = offset;
+            offset = pax_align(offset + n * hdr->col_len[i]);
+        }
+        if (offset <= PAGE_SIZE) {
+            hdr->num_records_per_page = n;
+            hdr->bitmap_size = bitmap_size;
+            return;
+        }
+    }
+    throw InternalError("RmPaxFileHandle: record too large for PAX layout");
+}
+
+/**
+ * @description: 创建一个PAX记录文件，并把文件头写入第0页
+ * @param {DiskManager*} disk_manager
+ * @param {string&} filename 文件名
+ * @param {int} record_size 行记录长度
+ * @param {vector<RmColumn>&} cols 行记录中的各列，需要覆盖整条记录
+ */
+void RmPaxFileHandle::create_file(DiskManager *disk_manager, const std::string &filename, int record_size,
+                                  const std::vector<RmColumn> &cols) {
+    if (record_size < 1 || record_size > RM_MAX_RECORD_SIZE) {
+        throw InvalidRecordSizeError(record_size);
+    }
+    if (cols.empty() || (int)cols.size() > RM_PAX_MAX_COLS) {
+        throw InternalError("RmPaxFileHandle: invalid column count");
+    }
+    // 各列按偏移排好后必须首尾相接、恰好覆盖整条记录，否则拼回的行记录会有空洞或互相覆盖
+    std::vector<RmColumn> sorted_cols = cols;
+    std::sort(sorted_cols.begin(), sorted_cols.end(),
+              [](const RmColumn &a, const RmColumn &b) { return a.offset < b.offset; });
+    int covered = 0;
+    for (const RmColumn &col : sorted_cols) {
+        if (col.len < 1 || col.offset != covered || col.offset + col.len > record_size) {
+            throw InternalError("RmPaxFileHandle: columns must cover the record exactly without overlap");
+        }
+        covered += col.len;
+    }
+    if (covered != record_size) {
+        throw InternalError("RmPaxFileHandle: columns must cover the record exactly without overlap");
+    }
+
+    RmPaxFileHdr file_hdr;
+    memset(&file_hdr, 0, sizeof(file_hdr));
+    file_hdr.record_size = record_size;
+    file_hdr.num_pages = 1;
+    file_hdr.first_free_page_no = RM_NO_PAGE;
+    file_hdr.num_cols = cols.size();
+    for (int i = 0; i < file_hdr.num_cols; i++) {
+        file_hdr.col_offset[i] = cols[i].offset;
+        file_hdr.col_len[i] = cols[i].len;
+    }
+    pax_layout(&file_hdr);
+
+    disk_manager->create_file(filename);
+    int fd = disk_manager->open_file(filename);
+    disk_manager->write_page(fd, RM_FILE_HDR_PAGE, (char *)&file_hdr, sizeof(file_hdr));
+    disk_manager->close_file(fd);
+}
+
+/**
+ * @description: 把内存中的文件头和缓冲池中本文件的页面写回磁盘，关闭文件前调用
+ */
+void RmPaxFileHandle::flush_file_hdr() {
+    disk_manager_->write_page(fd_, RM_FILE_HDR_PAGE, (char *)&file_hdr_, sizeof(file_hdr_));
+    buffer_pool_manager_->flush_all_pages(fd_);
+}
+
+// rid是否落在记录页面和slot的范围内。第0页是文件头，页号为负或越界的rid都不对应任何记录
+bool RmPaxFileHandle::in_range(const Rid &rid) const {
+    return rid.page_no >= RM_FIRST_RECORD_PAGE && rid.page_no < file_hdr_.num_pages && rid.slot_no >= 0 &&
+           rid.slot_no < file_hdr_.num_records_per_page;
+}
+
+bool RmPaxFileHandle::is_record(const Rid &rid) const {
+    if (!in_range(rid)) {
+        return false;
+    }
+    RmPaxPageHandle page_handle = fetch_page_handle(rid.page_no);
+    bool ret = Bitmap::is_set(page_handle.bitmap, rid.slot_no);
+    unpin_page_handle(page_handle, false);
+    return ret;
+}
+
+/**
+ * @description: 获取rid对应的记录，把各列从minipage中拼回一条行记录
+ * @param {Rid&} rid 记录号
+ * @param {Context*} context
+ * @return {unique_ptr<RmRecord>} rid对应的记录，和RmFileHandle一样，页面不存在、slot越界或为空时返回nullptr
+ */
+std::unique_ptr<RmRecord> RmPaxFileHandle::get_record(const Rid &rid, Context *context) const {
+    if (!in_range(rid)) {
+        return nullptr;
+    }
+    RmPaxPageHandle page_handle = fetch_page_handle(rid.page_no);
+    if (!Bitmap::is_set(page_handle.bitmap, rid.slot_no)) {
+        unpin_page_handle(page_handle, false);
+        return nullptr;
+    }
+    auto record = std::make_unique<RmRecord>(file_hdr_.record_size);
+    for (int i = 0; i < file_hdr_.num_cols; i++) {
+        memcpy(record->data + file_hdr_.col_offset[i], page_handle.get_field(i, rid.slot_no), file_hdr_.col_len[i]);
+    }
+    unpin_page_handle(page_handle, false);
+    return record;
+}
+
+/**
+ * @description: 插入一条记录，把行记录拆成各列写入对应的minipage
+ * @param {char*} buf 行记录
+ * @param {Context*} context
+ * @return {Rid} 插入位置
+ */
+Rid RmPaxFileHandle::insert_record(char *buf, Context *context) {
+    RmPaxPageHandle page_handle = create_page_handle();
+    int slot_no = Bitmap::first_bit(false, page_handle.bitmap, file_hdr_.num_records_per_page);
+
+    for (int i = 0; i < file_hdr_.num_cols; i++) {
+        memcpy(page_handle.get_field(i, slot_no), buf + file_hdr_.col_offset[i], file_hdr_.col_len[i]);
+    }
+    Bitmap::set(page_handle.bitmap, slot_no);
+    page_handle.page_hdr->num_records++;
+    if (page_handle.page_hdr->num_records == file_hdr_.num_records_per_page) {
+        // 页面满了，从空闲链表中摘掉
+        file_hdr_.first_free_page_no = page_handle.page_hdr->next_free_page_no;
+    }
+
+    Rid rid = {.page_no = page_handle.page->get_page_id().page_no, .slot_no = slot_no};
+    unpin_page_handle(page_handle, true);
+    return rid;
+}
+
+/**
+ * @description: 删除rid对应的记录，页面由满变为不满时挂回空闲链表头部
+ * @param {Rid&} rid 记录号
+ * @param {Context*} context
+ */
+void RmPaxFileHandle::delete_record(const Rid &rid, Context *context) {
+    RmPaxPageHandle page_handle = fetch_page_handle(rid.page_no);
+    if (!Bitmap::is_set(page_handle.bitmap, rid.slot_no)) {
+        unpin_page_handle(page_handle, false);
+        throw RecordNotFoundError(rid.page_no, rid.slot_no);
+    }
+    if (page_handle.page_hdr->num_records == file_hdr_.num_records_per_page) {
+        page_handle.page_hdr->next_free_page_no = file_hdr_.first_free_page_no;
+        file_hdr_.first_free_page_no = rid.page_no;
+    }
+    Bitmap::reset(page_handle.bitmap, rid.slot_no);
+    page_handle.page_hdr->num_records--;
+    unpin_page_handle(page_handle, true);
+}
+
+/**
+ * @description: 更新rid对应的记录
+ * @param {Rid&} rid 记录号
+ * @param {char*} buf 新的行记录
+ * @param {Context*} context
+ */
+void RmPaxFileHandle::update_record(const Rid &rid, char *buf, Context *context) {
+    RmPaxPageHandle page_handle = fetch_page_handle(rid.page_no);
+    if (!Bitmap::is_set(page_handle.bitmap, rid.slot_no)) {
+        unpin_page_handle(page_handle, false);
+        throw RecordNotFoundError(rid.page_no, rid.slot_no);
+    }
+    for (int i = 0; i < file_hdr_.num_cols; i++) {
+        memcpy(page_handle.get_field(i, rid.slot_no), buf + file_hdr_.col_offset[i], file_hdr_.col_len[i]);
+    }
+    unpin_page_handle(page_handle, true);
+}
+
+/**
+ * @description: 获取指定页面的页面句柄，页面会被pin住，用完需要调用unpin_page_handle
+ * @param {int} page_no 页面号
+ */
+RmPaxPageHandle RmPaxFileHandle::fetch_page_handle(int page_no) const {
+    if (page_no <= RM_FILE_HDR_PAGE || page_no >= file_hdr_.num_pages) {
+        throw PageNotExistError(disk_manager_->get_file_name(fd_), page_no);
+    }
+    Page *page = buffer_pool_manager_->fetch_page(PageId{fd_, page_no});
+    if (page == nullptr) {
+        throw PageNotExistError(disk_manager_->get_file_name(fd_), page_no);
+    }
+    return RmPaxPageHandle(&file_hdr_, page);
+}
+
+/**
+ * @description: 获取第一个空闲页面的句柄，没有空闲页面时新建一个
+ */
+RmPaxPageHandle RmPaxFileHandle::create_page_handle() {
+    if (file_hdr_.first_free_page_no != RM_NO_PAGE) {
+        return fetch_page_handle(file_hdr_.first_free_page_no);
+    }
+
+    PageId new_page_id = {.fd = fd_, .page_no = INVALID_PAGE_ID};
+    Page *page = buffer_pool_manager_->new_page(&new_page_id);
+    if (page == nullptr) {
+        throw InternalError("RmPaxFileHandle: buffer pool has no free frame");
+    }
+    RmPaxPageHandle page_handle(&file_hdr_, page);
+    page_handle.page_hdr->next_free_page_no = RM_NO_PAGE;
+    page_handle.page_hdr->num_records = 0;
+    Bitmap::init(page_handle.bitmap, file_hdr_.bitmap_size);
+
+    file_hdr_.first_free_page_no = new_page_id.page_no;
+    file_hdr_.num_pages = std::max(file_hdr_.num_pages, new_page_id.page_no + 1);
+    return page_handle;
+}
+
+void RmPaxFileHandle::unpin_page_handle(const RmPaxPageHandle &page_handle, bool is_dirty) const {
+    buffer_pool_manager_->unpin_page(page_handle.page->get_page_id(), is_dirty);
+}
+
+/**
+ * @brief 初始化列扫描，col_ids是要读取的列在文件头中的下标
+ */
+RmPaxScan::RmPaxScan(const RmPaxFileHandle *file_handle, std::vector<int> col_ids)
+    : file_handle_(file_handle), col_ids_(std::move(col_ids)), page_no_(RM_FIRST_RECORD_PAGE) {
+    for (int col_id : col_ids_) {
+        if (col_id < 0 || col_id >= file_handle_->file_hdr_.num_cols) {
+            throw InternalError("RmPaxScan: invalid column id");
+        }
+    }
+}
+
+/**
+ * @brief 读取下一个有记录的页面，把请求的列拷贝成连续数组放进batch
+ * @return 没有更多记录时返回false
+ * @note 满页直接整段拷贝minipage；非满页按bitmap逐个挑出有效slot
+ */
+bool RmPaxScan::next_batch(RmColumnBatch *batch) {
+    const RmPaxFileHdr &hdr = file_handle_->file_hdr_;
+    batch->rids.clear();
+    batch->cols.resize(col_ids_.size());
+
+    while (page_no_ < hdr.num_pages) {
+        RmPaxPageHandle page_handle = file_handle_->fetch_page_handle(page_no_);
+        int num_records = page_handle.page_hdr->num_records;
+        if (num_records == 0) {
+            file_handle_->unpin_page_handle(page_handle, false);
+            page_no_++;
+            continue;
+        }
+
+        batch->rids.reserve(num_records);
+        for (size_t i = 0; i < col_ids_.size(); i++) {
+            batch->cols[i].resize(num_records * hdr.col_len[col_ids_[i]]);
+        }
+
+        if (num_records == hdr.num_records_per_page) {
+            for (int slot_no = 0; slot_no < num_records; slot_no++) {
+                batch->rids.push_back(Rid{page_no_, slot_no});
+            }
+            for (size_t i = 0; i < col_ids_.size(); i++) {
+                memcpy(batch->cols[i].data(), page_handle.get_minipage(col_ids_[i]), batch->cols[i].size());
+            }
+        } else {
+            int n = hdr.num_records_per_page;
+            for (int slot_no = Bitmap::first_bit(true, page_handle.bitmap, n); slot_no < n;
+                 slot_no = Bitmap::next_bit(true, page_handle.bitmap, n, slot_no)) {
+                batch->rids.push_back(Rid{page_no_, slot_no});
+            }
+            for (size_t i = 0; i < col_ids_.size(); i++) {
+                int col_id = col_ids_[i];
+                int len = hdr.col_len[col_id];
+                char *dst = batch->cols[i].data();
+                for (const Rid &rid : batch->rids) {
+                    memcpy(dst, page_handle.get_field(col_id, rid.slot_no), len);
+                    dst += len;
+                }
+            }
+        }
+
+        file_handle_->unpin_page_handle(page_handle, false);
+        page_no_++;
+        return true;
+    }
+    return false;
+}
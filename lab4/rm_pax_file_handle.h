@@ -0,0 +1,137 @@
+/* Copyright (c) 2023 Renmin University of China
+RMDB is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+        http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "bitmap.h"
+#include "common/context.h"
+#include "rm_column.h"
+#include "rm_defs.h"
+
+constexpr int RM_PAX_MAX_COLS = 32;     // PAX文件中一张表最多的列数
+constexpr int RM_PAX_MINIPAGE_ALIGN = 8;  // 每个minipage的起始地址按8字节对齐，方便向量化读取
+
+/* PAX文件的文件头，存放在文件的第0页。
+   前五个字段和RmFileHdr含义一致，后面记录每一列的位置信息 */
+struct RmPaxFileHdr {
+    int record_size;            // 行记录的长度
+    int num_pages;              // 文件中分配的页面个数（包括文件头页）
+    int num_records_per_page;   // 每个页面最多存放的记录数
+    int first_free_page_no;     // 第一个有空闲slot的页面号，没有时为RM_NO_PAGE
+    int bitmap_size;            // 每个页面bitmap的字节数
+
+    int num_cols;                               // 列数
+    int col_offset[RM_PAX_MAX_COLS];            // 第i列在行记录中的偏移
+    int col_len[RM_PAX_MAX_COLS];               // 第i列的长度
+    int minipage_offset[RM_PAX_MAX_COLS];       // 第i列的minipage在页面中的偏移
+};
+
+/* PAX页面句柄。页面布局：| lsn | RmPageHdr | bitmap | minipage 0 | minipage 1 | ... |
+   第i列的minipage连续存放本页所有slot的第i列，slot j的第i列位于 minipage_i + j * col_len[i] */
+struct RmPaxPageHandle {
+    const RmPaxFileHdr *file_hdr;
+    Page *page;
+    RmPageHdr *page_hdr;
+    char *bitmap;
+
+    RmPaxPageHandle(const RmPaxFileHdr *fhdr_, Page *page_) : file_hdr(fhdr_), page(page_) {
+        page_hdr = reinterpret_cast<RmPageHdr *>(page->get_data() + page->OFFSET_PAGE_HDR);
+        bitmap = page->get_data() + sizeof(RmPageHdr) + page->OFFSET_PAGE_HDR;
+    }
+
+    // 返回第col_id列的minipage首地址
+    char *get_minipage(int col_id) const { return page->get_data() + file_hdr->minipage_offset[col_id]; }
+
+    // 返回slot_no这一条记录第col_id列的首地址
+    char *get_field(int col_id, int slot_no) const {
+        return get_minipage(col_id) + slot_no * file_hdr->col_len[col_id];
+    }
+};
+
+/* 按列组织（PAX）的记录文件。对外接口和RmFileHandle保持一致，记录仍然用Rid定位，
+   区别在于一个页面内的记录按列拆开存放，分析型扫描只需要读取用到的列 */
+class RmPaxFileHandle {
+    friend class RmPaxScan;
+
+   private:
+    DiskManager *disk_manager_;
+    BufferPoolManager *buffer_pool_manager_;
+    int fd_;
+    RmPaxFileHdr file_hdr_;
+
+   public:
+    RmPaxFileHandle(DiskManager *disk_manager, BufferPoolManager *buffer_pool_manager, int fd)
+        : disk_manager_(disk_manager), buffer_pool_manager_(buffer_pool_manager), fd_(fd) {
+        disk_manager_->read_page(fd, RM_FILE_HDR_PAGE, (char *)&file_hdr_, sizeof(file_hdr_));
+        // 和RmFileHandle一样只调大，不覆盖open_file从分配表恢复的页面数
+        if (disk_manager_->get_fd2pageno(fd) < file_hdr_.num_pages) {
+            disk_manager_->set_fd2pageno(fd, file_hdr_.num_pages);
+        }
+    }
+
+    static void create_file(DiskManager *disk_manager, const std::string &filename, int record_size,
+                            const std::vector<RmColumn> &cols);
+
+    void flush_file_hdr();
+
+    const RmPaxFileHdr &get_file_hdr() const { return file_hdr_; }
+    int GetFd() { return fd_; }
+
+    bool is_record(const Rid &rid) const;
+
+    std::unique_ptr<RmRecord> get_record(const Rid &rid, Context *context) const;
+
+    Rid insert_record(char *buf, Context *context);
+
+    void delete_record(const Rid &rid, Context *context);
+
+    void update_record(const Rid &rid, char *buf, Context *context);
+
+    RmPaxPageHandle fetch_page_handle(int page_no) const;
+
+   private:
+    bool in_range(const Rid &rid) const;
+
+    RmPaxPageHandle create_page_handle();
+
+    void unpin_page_handle(const RmPaxPageHandle &page_handle, bool is_dirty) const;
+};
+
+/* 列批：一个页面中所有有效记录的指定列。cols[i]是第i个请求列的连续数组，
+   元素个数为rids.size()，可以直接交给向量化的聚合循环处理 */
+struct RmColumnBatch {
+    std::vector<Rid> rids;
+    std::vector<std::vector<char>> cols;
+
+    int num_rows() const { return static_cast<int>(rids.size()); }
+
+    template <typename T>
+    const T *column(int i) const {
+        return reinterpret_cast<const T *>(cols[i].data());
+    }
+};
+
+/* PAX文件的列扫描，每次next_batch返回一个页面的列批，只拷贝col_ids指定的列 */
+class RmPaxScan {
+    const RmPaxFileHandle *file_handle_;
+    std::vector<int> col_ids_;
+    int page_no_;
+
+   public:
+    RmPaxScan(const RmPaxFileHandle *file_handle, std::vector<int> col_ids);
+
+    bool next_batch(RmColumnBatch *batch);
+
+    bool is_end() const { return page_no_ >= file_handle_->file_hdr_.num_pages; }
+};
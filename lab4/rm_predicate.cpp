@@ -0,0 +1,65 @@
+/* Copyright (c) 2023 Renmin University of China
+RMDB is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+        http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#include "rm_predicate.h"
+
+/**
+ * @description: 检查每个条件的常量长度，并为每个条件选好比较函数
+ * @param {vector<RmCondition>} conds 合取的各个条件
+ */
+RmPredicate::RmPredicate(std::vector<RmCondition> conds) : conds_(std::move(conds)) {
+    for (const RmCondition &cond : conds_) {
+        if ((int)cond.value.size() != cond.col.len) {
+            throw InvalidValueCountError();
+        }
+        if ((cond.col.type == TYPE_INT && cond.col.len != sizeof(int)) ||
+            (cond.col.type == TYPE_FLOAT && cond.col.len != sizeof(float))) {
+            throw IncompatibleTypeError(coltype2str(cond.col.type), std::to_string(cond.col.len) + " bytes");
+        }
+        compiled_.push_back(Compiled{select(cond.col.type, cond.op), cond.col.offset, cond.col.len, cond.value.data()});
+    }
+}
+
+// 在(类型, 运算符)的组合上展开模板，得到对应的特化比较函数
+RmPredicate::CompareFunc RmPredicate::select(ColType type, CompOp op) {
+    switch (type) {
+        case TYPE_INT:
+            switch (op) {
+                case OP_EQ: return rm_cmp_num<int, OP_EQ>;
+                case OP_NE: return rm_cmp_num<int, OP_NE>;
+                case OP_LT: return rm_cmp_num<int, OP_LT>;
+                case OP_GT: return rm_cmp_num<int, OP_GT>;
+                case OP_LE: return rm_cmp_num<int, OP_LE>;
+                case OP_GE: return rm_cmp_num<int, OP_GE>;
+            }
+            break;
+        case TYPE_FLOAT:
+            switch (op) {
+                case OP_EQ: return rm_cmp_num<float, OP_EQ>;
+                case OP_NE: return rm_cmp_num<float, OP_NE>;
+                case OP_LT: return rm_cmp_num<float, OP_LT>;
+                case OP_GT: return rm_cmp_num<float, OP_GT>;
+                case OP_LE: return rm_cmp_num<float, OP_LE>;
+                case OP_GE: return rm_cmp_num<float, OP_GE>;
+            }
+            break;
+        case TYPE_STRING:
+            switch (op) {
+                case OP_EQ: return rm_cmp_str<OP_EQ>;
+                case OP_NE: return rm_cmp_str<OP_NE>;
+                case OP_LT: return rm_cmp_str<OP_LT>;
+                case OP_GT: return rm_cmp_str<OP_GT>;
+                case OP_LE: return rm_cmp_str<OP_LE>;
+                case OP_GE: return rm_cmp_str<OP_GE>;
+            }
+            break;
+    }
+    throw InternalError("Unexpected data type or comparison operator");
+}
@@ -0,0 +1,104 @@
+/* Copyright (c) 2023 Renmin University of China
+RMDB is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+        http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#pragma once
+
+#include <cstring>
+#include <vector>
+
+#include "common/common.h"
+#include "rm_column.h"
+
+/* 一个比较条件：列 op 常量，value是常量按列的存储格式编码后的字节，长度为col.len */
+struct RmCondition {
+    RmColumn col;
+    CompOp op;
+    std::vector<char> value;
+};
+
+template <CompOp op>
+inline bool rm_cmp_result(int cmp) {
+    if constexpr (op == OP_EQ) return cmp == 0;
+    if constexpr (op == OP_NE) return cmp != 0;
+    if constexpr (op == OP_LT) return cmp < 0;
+    if constexpr (op == OP_GT) return cmp > 0;
+    if constexpr (op == OP_LE) return cmp <= 0;
+    if constexpr (op == OP_GE) return cmp >= 0;
+    return false;
+}
+
+/* 数值列的比较器，类型和比较运算符都是模板参数，编译期展开成一次取值和一次比较 */
+template <typename T, CompOp op>
+inline bool rm_cmp_num(const char *field, const char *value, int len) {
+    T a, b;
+    memcpy(&a, field, sizeof(T));
+    memcpy(&b, value, sizeof(T));
+    if constexpr (op == OP_EQ) return a == b;
+    if constexpr (op == OP_NE) return a != b;
+    if constexpr (op == OP_LT) return a < b;
+    if constexpr (op == OP_GT) return a > b;
+    if constexpr (op == OP_LE) return a <= b;
+    if constexpr (op == OP_GE) return a >= b;
+    return false;
+}
+
+/* 定长字符串列的比较器 */
+template <CompOp op>
+inline bool rm_cmp_str(const char *field, const char *value, int len) {
+    return rm_cmp_result<op>(memcmp(field, value, len));
+}
+
+/* 若干比较条件的合取。构造时为每个条件按(类型, 运算符)选好特化的比较函数，
+   求值时直接在slot字节上调用，不需要把记录拷贝出来，也不需要在运行时判断类型 */
+class RmPredicate {
+   public:
+    RmPredicate() = default;
+
+    explicit RmPredicate(std::vector<RmCondition> conds);
+
+    // compiled_中保存的是指向conds_中常量的指针，拷贝时需要重新选择比较函数
+    RmPredicate(const RmPredicate &other) : RmPredicate(other.conds_) {}
+
+    RmPredicate &operator=(const RmPredicate &other) {
+        if (this != &other) {
+            *this = RmPredicate(other.conds_);
+        }
+        return *this;
+    }
+
+    RmPredicate(RmPredicate &&other) = default;
+    RmPredicate &operator=(RmPredicate &&other) = default;
+
+    bool eval(const char *record) const {
+        for (const Compiled &c : compiled_) {
+            if (!c.fn(record + c.offset, c.value, c.len)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    const std::vector<RmCondition> &get_conds() const { return conds_; }
+
+   private:
+    using CompareFunc = bool (*)(const char *field, const char *value, int len);
+
+    struct Compiled {
+        CompareFunc fn;
+        int offset;
+        int len;
+        const char *value;
+    };
+
+    static CompareFunc select(ColType type, CompOp op);
+
+    std::vector<RmCondition> conds_;
+    std::vector<Compiled> compiled_;
+};
@@ -0,0 +1,67 @@
+/* Copyright (c) 2023 Renmin University of China
+RMDB is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+        http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#include "rm_predicate_scan.h"
+
+/**
+ * @brief 初始化扫描并定位到第一条满足条件的记录
+ */
+RmPredicateScan::RmPredicateScan(RmFileHandle *file_handle, BufferPoolManager *buffer_pool_manager, RmPredicate pred,
+                                 RmZoneMap *zone_map)
+    : file_handle_(file_handle), buffer_pool_manager_(buffer_pool_manager), pred_(std::move(pred)), zone_map_(zone_map) {
+    file_hdr_ = file_handle_->get_file_hdr();
+    page_no_ = RM_FIRST_RECORD_PAGE;
+    load_page();
+}
+
+void RmPredicateScan::next() {
+    pos_++;
+    if (pos_ >= page_rids_.size()) {
+        page_no_++;
+        load_page();
+    }
+}
+
+/**
+ * @brief 从page_no_开始找到第一个有满足条件记录的页面
+ */
+void RmPredicateScan::load_page() {
+    int n = file_hdr_.num_records_per_page;
+    int record_size = file_hdr_.record_size;
+    for (; page_no_ < file_hdr_.num_pages; page_no_++) {
+        page_rids_.clear();
+        page_records_.clear();
+        pos_ = 0;
+
+        if (zone_map_ != nullptr && !zone_map_->may_match(page_no_, pred_)) {
+            stats_.pages_skipped++;
+            continue;
+        }
+        RmPageHandle page_handle = file_handle_->fetch_page_handle(page_no_);
+        stats_.pages_scanned++;
+        if (page_handle.page_hdr->num_records > 0) {
+            for (int slot_no = Bitmap::first_bit(true, page_handle.bitmap, n); slot_no < n;
+                 slot_no = Bitmap::next_bit(true, page_handle.bitmap, n, slot_no)) {
+                const char *slot = page_handle.get_slot(slot_no);
+                stats_.rows_examined++;
+                if (pred_.eval(slot)) {
+                    page_rids_.push_back(Rid{page_no_, slot_no});
+                    page_records_.insert(page_records_.end(), slot, slot + record_size);
+                }
+            }
+        }
+        buffer_pool_manager_->unpin_page(page_handle.page->get_page_id(), false);
+
+        if (!page_rids_.empty()) {
+            stats_.rows_matched += page_rids_.size();
+            return;
+        }
+    }
+}
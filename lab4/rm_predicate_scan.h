@@ -0,0 +1,57 @@
+/* Copyright (c) 2023 Renmin University of China
+RMDB is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+        http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#pragma once
+
+#include <vector>
+
+#include "rm_file_handle.h"
+#include "rm_predicate.h"
+#include "rm_zone_map.h"
+
+struct RmPredicateScanStats {
+    size_t pages_scanned = 0;
+    size_t pages_skipped = 0;   // 根据区域映射跳过、没有读进缓冲池的页面数
+    size_t rows_examined = 0;
+    size_t rows_matched = 0;
+};
+
+/* 带谓词下推的表扫描。每次pin住一个页面，在slot字节上直接对谓词求值，
+   只把满足条件的记录拷贝到页内缓冲区后释放页面，rid()/record()只会返回满足条件的记录。
+   给了zone_map时，先用区域映射判断，不可能有满足条件记录的页面不去fetch */
+class RmPredicateScan : public RecScan {
+    RmFileHandle *file_handle_;
+    BufferPoolManager *buffer_pool_manager_;
+    RmPredicate pred_;
+    RmZoneMap *zone_map_;
+    RmFileHdr file_hdr_;
+    int page_no_;
+    std::vector<Rid> page_rids_;        // 当前页面中满足条件的记录
+    std::vector<char> page_records_;
+    size_t pos_ = 0;
+    RmPredicateScanStats stats_;
+
+   public:
+    RmPredicateScan(RmFileHandle *file_handle, BufferPoolManager *buffer_pool_manager, RmPredicate pred,
+                    RmZoneMap *zone_map = nullptr);
+
+    void next() override;
+
+    bool is_end() const override { return page_no_ >= file_hdr_.num_pages; }
+
+    Rid rid() const override { return page_rids_[pos_]; }
+
+    const char *record() const { return page_records_.data() + pos_ * file_hdr_.record_size; }
+
+    const RmPredicateScanStats &get_stats() const { return stats_; }
+
+   private:
+    void load_page();
+};
@@ -0,0 +1,45 @@
+/* Copyright (c) 2023 Renmin University of China
+RMDB is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+        http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#pragma once
+
+#include <algorithm>
+#include <functional>
+
+#include "rm_parallel_scan.h"
+
+/* 记录层算子之间传递数据的方式：上游算子是一个RmRecordSource，调用时把每一条定长记录推给sink。
+   记录地址只在sink调用期间有效，需要保留的话由下游自己拷贝 */
+using RmRecordSink = std::function<void(const char *record)>;
+using RmRecordSource = std::function<void(const RmRecordSink &sink)>;
+
+/* 算子的一个输入：数据来源、记录长度和估计的记录数（用于分区数、过滤器大小等，估不出来时填0） */
+struct RmOperatorInput {
+    RmRecordSource source;
+    int record_size;
+    size_t estimated_rows;
+};
+
+/**
+ * @description: 把一个记录文件包装成算子输入，按页号顺序扫描，扫描过程中会释放页面的pin
+ * @param {RmFileHandle*} file_handle 记录文件
+ * @param {BufferPoolManager*} buffer_pool_manager
+ */
+inline RmOperatorInput rm_file_input(RmFileHandle *file_handle, BufferPoolManager *buffer_pool_manager) {
+    RmFileHdr file_hdr = file_handle->get_file_hdr();
+    RmOperatorInput input;
+    input.source = [file_handle, buffer_pool_manager](const RmRecordSink &sink) {
+        RmParallelScan scan(file_handle, buffer_pool_manager, 1);
+        scan.run([&sink](int worker_id, const Rid &rid, const char *record) { sink(record); });
+    };
+    input.record_size = file_hdr.record_size;
+    input.estimated_rows = (size_t)std::max(file_hdr.num_pages - 1, 0) * file_hdr.num_records_per_page;
+    return input;
+}
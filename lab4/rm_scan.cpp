@@ -37,6 +37,7 @@ void RmScan::next() {
     
     RmPageHandle page_handle = file_handle_->fetch_page_handle(rid_.page_no);
     int next_in_this_page = Bitmap::next_bit(true, page_handle.bitmap, file_handle_->file_hdr_.num_records_per_page, rid_.slot_no);
+    file_handle_->buffer_pool_manager_->unpin_page(page_handle.page->get_page_id(), false);  // 只读bitmap，用完就unpin
     if (next_in_this_page == file_handle_->file_hdr_.num_records_per_page) {
         // 说明这一页里面，没有了没有记录了
         // 得通过循环，在后面页里找
@@ -50,6 +51,7 @@ void RmScan::next() {
             RmPageHandle page_handle = file_handle_->fetch_page_handle(i);
       
             int first_after_this = Bitmap::first_bit(true, page_handle.bitmap, file_handle_->file_hdr_.num_records_per_page);
+            file_handle_->buffer_pool_manager_->unpin_page(page_handle.page->get_page_id(), false);
             if(first_after_this == file_handle_->file_hdr_.num_records_per_page) {
                 // 循环下去
                 // 如果最后一页还没找到，直接放文件末尾
@@ -0,0 +1,131 @@
+/* Copyright (c) 2023 Renmin University of China
+RMDB is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+        http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#include "rm_spill_file.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cassert>
+#include <cerrno>
+#include <cstring>
+
+/**
+ * @description: 创建并打开一个溢出文件。临时文件直接用open创建，不在DiskManager中登记，
+ *               也不建页面分配表、不按extent预留空间，读写只借用DiskManager的read_page/write_page
+ * @param {DiskManager*} disk_manager
+ * @param {string&} path 临时文件路径，不能已经存在
+ * @param {int} record_size 记录长度
+ * @param {int} io_pages 每次读写的页面数
+ */
+RmSpillFile::RmSpillFile(DiskManager *disk_manager, const std::string &path, int record_size, int io_pages)
+    : disk_manager_(disk_manager), path_(path), record_size_(record_size), io_pages_(std::max(io_pages, 1)) {
+    int block_size = io_pages_ * PAGE_SIZE;
+    if (record_size_ <= 0 || record_size_ > block_size) {
+        throw InvalidRecordSizeError(record_size_);
+    }
+    records_per_block_ = block_size / record_size_;
+    buf_.resize(block_size);
+    fd_ = open(path_.c_str(), O_CREAT | O_EXCL | O_RDWR, S_IRUSR | S_IWUSR);
+    if (fd_ < 0) {
+        if (errno == EEXIST) {
+            throw FileExistsError(path_);
+        }
+        throw UnixError();
+    }
+}
+
+RmSpillFile::~RmSpillFile() {
+    close(fd_);
+    unlink(path_.c_str());
+}
+
+void RmSpillFile::append(const char *record) {
+    assert(!finished_);
+    memcpy(buf_.data() + buf_records_ * record_size_, record, record_size_);
+    buf_records_++;
+    num_records_++;
+    if (buf_records_ == records_per_block_) {
+        write_block();
+    }
+}
+
+/**
+ * @description: 写出最后一个不满的块，之后只能读不能再追加
+ */
+void RmSpillFile::finish() {
+    if (finished_) {
+        return;
+    }
+    if (buf_records_ > 0) {
+        write_block();
+    }
+    finished_ = true;
+    buf_.clear();
+    buf_.shrink_to_fit();
+}
+
+void RmSpillFile::write_block() {
+    disk_manager_->write_page(fd_, num_blocks_ * io_pages_, buf_.data(), buf_records_ * record_size_);
+    num_blocks_++;
+    buf_records_ = 0;
+}
+
+RmSpillReader::RmSpillReader(const RmSpillFile *file, bool prefetch) : file_(file), prefetch_(prefetch) {
+    assert(file_->finished_);
+    buf_.resize(file_->records_per_block_ * file_->record_size_);
+    if (prefetch_) {
+        next_buf_.resize(buf_.size());
+    }
+}
+
+RmSpillReader::~RmSpillReader() {
+    if (pending_.valid()) {
+        pending_.wait();
+    }
+}
+
+/**
+ * @description: 读取下一条记录
+ * @param {char**} record 记录地址，下一次调用next之前有效
+ * @return {bool} 读完时返回false
+ */
+bool RmSpillReader::next(const char **record) {
+    if (pos_ == buf_records_) {
+        if (block_no_ == file_->num_blocks_) {
+            return false;
+        }
+        if (pending_.valid()) {
+            pending_.get();
+            buf_.swap(next_buf_);
+            buf_records_ = next_records_;
+        } else {
+            read_block(block_no_, &buf_, &buf_records_);
+        }
+        block_no_++;
+        pos_ = 0;
+        if (prefetch_ && block_no_ < file_->num_blocks_) {
+            int block_no = block_no_;
+            pending_ = std::async(std::launch::async,
+                                  [this, block_no] { read_block(block_no, &next_buf_, &next_records_); });
+        }
+    }
+    *record = buf_.data() + pos_ * file_->record_size_;
+    pos_++;
+    return true;
+}
+
+void RmSpillReader::read_block(int block_no, std::vector<char> *buf, int *num_records) const {
+    size_t before = (size_t)block_no * file_->records_per_block_;
+    *num_records = std::min<size_t>(file_->records_per_block_, file_->num_records_ - before);
+    file_->disk_manager_->read_page(file_->fd_, block_no * file_->io_pages_, buf->data(),
+                                    *num_records * file_->record_size_);
+}
@@ -0,0 +1,80 @@
+/* Copyright (c) 2023 Renmin University of China
+RMDB is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+        http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#pragma once
+
+#include <future>
+#include <string>
+#include <vector>
+
+#include "storage/disk_manager.h"
+
+/* 算子溢出到磁盘用的临时文件，只追加定长记录，写完后顺序读。
+   读写都以io_pages个页面为一块，通过DiskManager一次读写一整块；
+   一块中放下整数条记录，剩余部分空着，这样记录不会跨块。
+   文件不经过缓冲池，也不在DiskManager中登记，析构时关闭并删除 */
+class RmSpillFile {
+    friend class RmSpillReader;
+
+   public:
+    RmSpillFile(DiskManager *disk_manager, const std::string &path, int record_size, int io_pages = 16);
+
+    ~RmSpillFile();
+
+    RmSpillFile(const RmSpillFile &) = delete;
+    RmSpillFile &operator=(const RmSpillFile &) = delete;
+
+    void append(const char *record);
+
+    void finish();
+
+    size_t num_records() const { return num_records_; }
+
+    int get_record_size() const { return record_size_; }
+
+   private:
+    void write_block();
+
+    DiskManager *disk_manager_;
+    std::string path_;
+    int fd_;
+    int record_size_;
+    int io_pages_;
+    int records_per_block_;
+    std::vector<char> buf_;     // 正在写的块
+    int buf_records_ = 0;       // 当前块中已有的记录数
+    int num_blocks_ = 0;        // 已经写到磁盘上的块数
+    size_t num_records_ = 0;
+    bool finished_ = false;
+};
+
+/* 顺序读取一个已经finish的溢出文件。
+   prefetch为true时，在处理当前块的同时由后台线程读取下一块 */
+class RmSpillReader {
+   public:
+    explicit RmSpillReader(const RmSpillFile *file, bool prefetch = false);
+
+    ~RmSpillReader();
+
+    bool next(const char **record);
+
+   private:
+    void read_block(int block_no, std::vector<char> *buf, int *num_records) const;
+
+    const RmSpillFile *file_;
+    bool prefetch_;
+    std::vector<char> buf_;
+    int block_no_ = 0;      // 下一个要交给next的块号
+    int buf_records_ = 0;
+    int pos_ = 0;
+    std::vector<char> next_buf_;    // 预读的下一块
+    int next_records_ = 0;
+    std::future<void> pending_;
+};
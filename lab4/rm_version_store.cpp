@@ -0,0 +1,252 @@
+/* Copyright (c) 2023 Renmin University of China
+RMDB is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+        http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#include "rm_version_store.h"
+
+#include <algorithm>
+#include <cstring>
+
+/**
+ * @description: 创建版本存储，并登记为file_handle对应文件的写回调
+ * @param {RmFileHandle*} file_handle 要做多版本的记录文件
+ * @param {BufferPoolManager*} buffer_pool_manager 用于释放读当前版本时pin住的页面
+ */
+RmVersionStore::RmVersionStore(RmFileHandle *file_handle, BufferPoolManager *buffer_pool_manager)
+    : file_handle_(file_handle), buffer_pool_manager_(buffer_pool_manager) {
+    record_size_ = file_handle_->get_file_hdr().record_size;
+    RmFileHookRegistry::add_hook(file_handle_->GetFd(), this);
+}
+
+RmVersionStore::~RmVersionStore() { RmFileHookRegistry::remove_hook(file_handle_->GetFd(), this); }
+
+/**
+ * @description: 开始一个快照，返回快照时间戳，用完必须调用end_snapshot
+ */
+timestamp_t RmVersionStore::begin_snapshot() {
+    // 快照期间不持有表锁，拿到的页面数和rid都必须一直有效，所以快照结束前不允许截断文件
+    file_handle_->hold_truncate();
+    std::scoped_lock lock{latch_};
+    active_snapshots_.insert(visible_ts_);
+    return visible_ts_;
+}
+
+void RmVersionStore::end_snapshot(timestamp_t snapshot_ts) {
+    std::scoped_lock lock{latch_};
+    auto it = active_snapshots_.find(snapshot_ts);
+    if (it != active_snapshots_.end()) {
+        active_snapshots_.erase(it);
+        file_handle_->release_truncate();
+    }
+}
+
+// 版本链从新到旧排列，返回最老的一个write_ts > snapshot_ts的旧版本，没有时返回nullptr（即当前版本可见）
+const RmVersion *RmVersionStore::find_visible(const std::deque<RmVersion> &chain, timestamp_t snapshot_ts) const {
+    const RmVersion *ret = nullptr;
+    for (const RmVersion &version : chain) {
+        if (version.write_ts <= snapshot_ts) {
+            break;
+        }
+        ret = &version;
+    }
+    return ret;
+}
+
+/**
+ * @description: 读取rid在快照snapshot_ts下的内容
+ * @return {unique_ptr<RmRecord>} 快照中的记录，快照中该位置没有记录时返回nullptr
+ * @note 先不加锁拷贝数据页中的当前版本，再加锁查版本链。拷贝期间如果有并发的写，
+ *       这次写一定已经把write_ts > snapshot_ts的旧版本放进了版本链，拷贝出的数据会被丢弃，不会读到写了一半的记录
+ */
+std::unique_ptr<RmRecord> RmVersionStore::read(const Rid &rid, timestamp_t snapshot_ts) {
+    auto current = std::make_unique<RmRecord>(record_size_);
+    RmPageHandle page_handle = file_handle_->fetch_page_handle(rid.page_no);
+    bool current_exists = Bitmap::is_set(page_handle.bitmap, rid.slot_no);
+    if (current_exists) {
+        memcpy(current->data, page_handle.get_slot(rid.slot_no), record_size_);
+    }
+    buffer_pool_manager_->unpin_page(page_handle.page->get_page_id(), false);
+
+    std::scoped_lock lock{latch_};
+    auto it = chains_.find({rid.page_no, rid.slot_no});
+    if (it != chains_.end()) {
+        const RmVersion *version = find_visible(it->second, snapshot_ts);
+        if (version != nullptr) {
+            if (!version->existed) {
+                return nullptr;
+            }
+            auto record = std::make_unique<RmRecord>(record_size_);
+            memcpy(record->data, version->image.data(), record_size_);
+            return record;
+        }
+    }
+    return current_exists ? std::move(current) : nullptr;
+}
+
+/**
+ * @description: 返回页面page_no中有旧版本的slot，快照扫描用它找到已经被删除但对快照仍然可见的记录
+ */
+void RmVersionStore::get_versioned_slots(int page_no, std::vector<int> *slots) {
+    std::scoped_lock lock{latch_};
+    for (auto it = chains_.lower_bound({page_no, 0}); it != chains_.end() && it->first.first == page_no; ++it) {
+        slots->push_back(it->first.second);
+    }
+}
+
+/**
+ * @description: 回收所有快照都不再需要的旧版本
+ * @return {size_t} 回收的版本数
+ * @note 快照S只会用到write_ts > S的旧版本，所以write_ts <= 最老活跃快照的版本都可以回收；
+ *       没有活跃快照时以visible_ts_为界，正在进行的写的时间戳一定大于它
+ */
+size_t RmVersionStore::gc() {
+    std::scoped_lock lock{latch_};
+    timestamp_t horizon = active_snapshots_.empty() ? visible_ts_ : *active_snapshots_.begin();
+    size_t removed = 0;
+    for (auto it = chains_.begin(); it != chains_.end();) {
+        std::deque<RmVersion> &chain = it->second;
+        while (!chain.empty() && chain.back().write_ts <= horizon) {
+            chain.pop_back();
+            removed++;
+        }
+        if (chain.empty()) {
+            it = chains_.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    num_versions_ -= removed;
+    return removed;
+}
+
+size_t RmVersionStore::num_versions() {
+    std::scoped_lock lock{latch_};
+    return num_versions_;
+}
+
+void RmVersionStore::push_version(const Rid &rid, const char *old_buf) {
+    std::scoped_lock lock{latch_};
+    RmVersion version;
+    version.write_ts = next_ts_++;
+    in_flight_.insert(version.write_ts);
+    pending_[{rid.page_no, rid.slot_no}] = version.write_ts;
+    version.existed = old_buf != nullptr;
+    if (old_buf != nullptr) {
+        version.image.assign(old_buf, old_buf + record_size_);
+    }
+    chains_[{rid.page_no, rid.slot_no}].push_front(std::move(version));
+    num_versions_++;
+}
+
+void RmVersionStore::on_insert(const Rid &rid, const char *new_buf) { push_version(rid, nullptr); }
+
+void RmVersionStore::on_update(const Rid &rid, const char *old_buf, const char *new_buf) { push_version(rid, old_buf); }
+
+// slot上没有记录时不是真正的删除，不能把slot里的旧字节当成删除前的版本
+void RmVersionStore::on_delete(const Rid &rid, const char *old_buf) {
+    RmPageHandle page_handle = file_handle_->fetch_page_handle(rid.page_no);
+    bool existed = Bitmap::is_set(page_handle.bitmap, rid.slot_no);
+    buffer_pool_manager_->unpin_page(page_handle.page->get_page_id(), false);
+    if (existed) {
+        push_version(rid, old_buf);
+    }
+}
+
+/**
+ * @description: 写操作完成，发布时间戳：visible_ts_推进到最小的未完成时间戳之前。
+ *               没有活跃快照、并且比它早的写都已完成时顺便回收这条记录的旧版本，
+ *               这样没有读者的时候版本链不会增长；否则留给gc()
+ */
+void RmVersionStore::on_write_done(const Rid &rid) {
+    std::scoped_lock lock{latch_};
+    auto pending = pending_.find({rid.page_no, rid.slot_no});
+    if (pending == pending_.end()) {
+        return;
+    }
+    timestamp_t write_ts = pending->second;
+    pending_.erase(pending);
+    in_flight_.erase(write_ts);
+    visible_ts_ = in_flight_.empty() ? next_ts_ - 1 : *in_flight_.begin() - 1;
+    // 还有更早的写没完成时，之后开始的快照时间戳小于write_ts，仍然需要这条记录的旧版本
+    if (active_snapshots_.empty() && write_ts <= visible_ts_) {
+        auto it = chains_.find({rid.page_no, rid.slot_no});
+        num_versions_ -= it->second.size();
+        chains_.erase(it);
+    }
+}
+
+/**
+ * @brief 开始快照并定位到第一条对快照可见的记录
+ */
+RmSnapshotScan::RmSnapshotScan(RmFileHandle *file_handle, RmVersionStore *version_store,
+                               BufferPoolManager *buffer_pool_manager)
+    : file_handle_(file_handle), version_store_(version_store), buffer_pool_manager_(buffer_pool_manager), pos_(0) {
+    snapshot_ts_ = version_store_->begin_snapshot();
+    // 构造函数抛异常时析构函数不会执行，由guard结束快照，否则快照和它持有的截断许可都会泄漏
+    struct SnapshotGuard {
+        RmVersionStore *version_store;
+        timestamp_t snapshot_ts;
+        bool released = false;
+        ~SnapshotGuard() {
+            if (!released) {
+                version_store->end_snapshot(snapshot_ts);
+            }
+        }
+    } guard{version_store_, snapshot_ts_};
+    num_pages_ = file_handle_->get_file_hdr().num_pages;
+    page_no_ = RM_FIRST_RECORD_PAGE;
+    load_page();
+    guard.released = true;
+}
+
+RmSnapshotScan::~RmSnapshotScan() { version_store_->end_snapshot(snapshot_ts_); }
+
+void RmSnapshotScan::next() {
+    pos_++;
+    if (pos_ >= page_rids_.size()) {
+        page_no_++;
+        load_page();
+    }
+}
+
+/**
+ * @brief 从page_no_开始找到第一个有可见记录的页面，把该页对快照可见的记录全部读出来。
+ *        候选slot是当前bitmap中的记录加上版本链中的记录（快照之后被删除的）
+ */
+void RmSnapshotScan::load_page() {
+    int num_records_per_page = file_handle_->get_file_hdr().num_records_per_page;
+    for (; page_no_ < num_pages_; page_no_++) {
+        std::vector<int> slots;
+        RmPageHandle page_handle = file_handle_->fetch_page_handle(page_no_);
+        for (int slot_no = Bitmap::first_bit(true, page_handle.bitmap, num_records_per_page);
+             slot_no < num_records_per_page;
+             slot_no = Bitmap::next_bit(true, page_handle.bitmap, num_records_per_page, slot_no)) {
+            slots.push_back(slot_no);
+        }
+        buffer_pool_manager_->unpin_page(page_handle.page->get_page_id(), false);
+        version_store_->get_versioned_slots(page_no_, &slots);
+        std::sort(slots.begin(), slots.end());
+        slots.erase(std::unique(slots.begin(), slots.end()), slots.end());
+
+        page_rids_.clear();
+        page_records_.clear();
+        pos_ = 0;
+        for (int slot_no : slots) {
+            Rid rid{page_no_, slot_no};
+            auto record = version_store_->read(rid, snapshot_ts_);
+            if (record != nullptr) {
+                page_rids_.push_back(rid);
+                page_records_.push_back(std::move(record));
+            }
+        }
+        if (!page_rids_.empty()) {
+            return;
+        }
+    }
+}
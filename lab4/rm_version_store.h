@@ -0,0 +1,112 @@
+/* Copyright (c) 2023 Renmin University of China
+RMDB is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+        http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#pragma once
+
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <utility>
+#include <vector>
+
+#include "rm_file_handle.h"
+#include "rm_file_hook.h"
+
+/* 一个旧版本：write_ts这次写操作覆盖掉的记录内容。
+   existed为false表示写之前这个位置没有记录（对应插入） */
+struct RmVersion {
+    timestamp_t write_ts;
+    bool existed;
+    std::vector<char> image;
+};
+
+/* 基于undo的版本存储。
+   数据页里始终是最新版本，update/delete/insert之前通过RmFileHook把旧版本放进版本链，
+   版本链从新到旧排列。快照时间戳为S的读者看到的是：所有write_ts <= S的写都已生效、
+   write_ts > S的写都没有发生的状态，即沿版本链找到最老的一个write_ts > S的旧版本，没有就读数据页。
+   时间戳由本对象分配。不同记录上的写可以并发，完成的顺序不一定和时间戳顺序相同，
+   新快照只能取到最小的未完成时间戳之前，否则快照会看到之后才完成的、时间戳更小的写 */
+class RmVersionStore : public RmFileHook {
+   public:
+    RmVersionStore(RmFileHandle *file_handle, BufferPoolManager *buffer_pool_manager);
+
+    ~RmVersionStore();
+
+    timestamp_t begin_snapshot();
+
+    void end_snapshot(timestamp_t snapshot_ts);
+
+    std::unique_ptr<RmRecord> read(const Rid &rid, timestamp_t snapshot_ts);
+
+    void get_versioned_slots(int page_no, std::vector<int> *slots);
+
+    size_t gc();
+
+    size_t num_versions();
+
+    void on_insert(const Rid &rid, const char *new_buf) override;
+
+    void on_update(const Rid &rid, const char *old_buf, const char *new_buf) override;
+
+    void on_delete(const Rid &rid, const char *old_buf) override;
+
+    void on_write_done(const Rid &rid) override;
+
+   private:
+    void push_version(const Rid &rid, const char *old_buf);
+
+    const RmVersion *find_visible(const std::deque<RmVersion> &chain, timestamp_t snapshot_ts) const;
+
+    RmFileHandle *file_handle_;
+    BufferPoolManager *buffer_pool_manager_;
+    int record_size_;
+
+    std::mutex latch_;
+    timestamp_t next_ts_ = 1;       // 下一次写操作使用的时间戳
+    timestamp_t visible_ts_ = 0;    // 最小的未完成时间戳减1，小于等于它的写都已完成，新快照从这里开始
+    std::set<timestamp_t> in_flight_;   // 已经分配时间戳、还没调用on_write_done的写
+    std::map<std::pair<int, int>, timestamp_t> pending_;    // (page_no, slot_no) -> 正在进行的写的时间戳
+    std::multiset<timestamp_t> active_snapshots_;
+    std::map<std::pair<int, int>, std::deque<RmVersion>> chains_;   // (page_no, slot_no) -> 版本链
+    size_t num_versions_ = 0;
+};
+
+/* 快照扫描：在begin_snapshot得到的时间戳上扫描整个文件，
+   期间其他线程对文件的插入、更新、删除都不会影响扫描结果 */
+class RmSnapshotScan : public RecScan {
+    RmFileHandle *file_handle_;
+    RmVersionStore *version_store_;
+    BufferPoolManager *buffer_pool_manager_;
+    timestamp_t snapshot_ts_;
+    int num_pages_;             // 开始快照时文件的页面数，之后新分配的页面对快照不可见
+    int page_no_;
+    std::vector<Rid> page_rids_;    // 当前页面中对快照可见的记录
+    std::vector<std::unique_ptr<RmRecord>> page_records_;
+    size_t pos_;
+
+   public:
+    RmSnapshotScan(RmFileHandle *file_handle, RmVersionStore *version_store, BufferPoolManager *buffer_pool_manager);
+
+    ~RmSnapshotScan();
+
+    void next() override;
+
+    bool is_end() const override { return page_no_ >= num_pages_; }
+
+    Rid rid() const override { return page_rids_[pos_]; }
+
+    // 当前记录在快照中的内容
+    const RmRecord *record() const { return page_records_[pos_].get(); }
+
+   private:
+    void load_page();
+};
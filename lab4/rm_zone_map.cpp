@@ -0,0 +1,195 @@
+/* Copyright (c) 2023 Renmin University of China
+RMDB is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+        http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#include "rm_zone_map.h"
+
+#include <algorithm>
+
+/**
+ * @description: 创建区域映射，扫描一遍文件得到精确的初始区间，并登记为文件的写回调
+ * @param {RmFileHandle*} file_handle 记录文件
+ * @param {BufferPoolManager*} buffer_pool_manager
+ * @param {vector<RmColumn>} cols 需要维护最小/最大值的列
+ * @param {int} pages_per_zone 每个区包含的页面数
+ */
+RmZoneMap::RmZoneMap(RmFileHandle *file_handle, BufferPoolManager *buffer_pool_manager, std::vector<RmColumn> cols,
+                     int pages_per_zone)
+    : file_handle_(file_handle),
+      buffer_pool_manager_(buffer_pool_manager),
+      cols_(std::move(cols)),
+      pages_per_zone_(std::max(pages_per_zone, 1)) {
+    for (const RmColumn &col : cols_) {
+        col_pos_.push_back(values_len_);
+        values_len_ += col.len;
+    }
+    rebuild();
+    RmFileHookRegistry::add_hook(file_handle_->GetFd(), this);
+}
+
+RmZoneMap::~RmZoneMap() { RmFileHookRegistry::remove_hook(file_handle_->GetFd(), this); }
+
+RmZoneMap::Zone &RmZoneMap::get_zone(int zone_id) {
+    if (zone_id >= (int)zones_.size()) {
+        zones_.resize(zone_id + 1);
+    }
+    return zones_[zone_id];
+}
+
+// 用一条记录放宽区间
+void RmZoneMap::widen(Zone *zone, const char *record) {
+    if (!zone->has_value) {
+        zone->mins.resize(values_len_);
+        zone->maxs.resize(values_len_);
+        for (size_t i = 0; i < cols_.size(); i++) {
+            memcpy(zone->mins.data() + col_pos_[i], cols_[i].get(record), cols_[i].len);
+            memcpy(zone->maxs.data() + col_pos_[i], cols_[i].get(record), cols_[i].len);
+        }
+        zone->has_value = true;
+        return;
+    }
+    for (size_t i = 0; i < cols_.size(); i++) {
+        const RmColumn &col = cols_[i];
+        char *min = zone->mins.data() + col_pos_[i];
+        char *max = zone->maxs.data() + col_pos_[i];
+        if (rm_compare(col.get(record), min, col.type, col.len) < 0) {
+            memcpy(min, col.get(record), col.len);
+        }
+        if (rm_compare(col.get(record), max, col.type, col.len) > 0) {
+            memcpy(max, col.get(record), col.len);
+        }
+    }
+}
+
+// 读取区内所有页面，精确计算区间
+void RmZoneMap::compute_zone(int zone_id, Zone *zone) {
+    RmFileHdr file_hdr = file_handle_->get_file_hdr();
+    int n = file_hdr.num_records_per_page;
+    *zone = Zone();
+    int start = RM_FIRST_RECORD_PAGE + zone_id * pages_per_zone_;
+    int end = std::min(start + pages_per_zone_, file_hdr.num_pages);
+    for (int page_no = start; page_no < end; page_no++) {
+        RmPageHandle page_handle = file_handle_->fetch_page_handle(page_no);
+        for (int slot_no = Bitmap::first_bit(true, page_handle.bitmap, n); slot_no < n;
+             slot_no = Bitmap::next_bit(true, page_handle.bitmap, n, slot_no)) {
+            widen(zone, page_handle.get_slot(slot_no));
+        }
+        buffer_pool_manager_->unpin_page(page_handle.page->get_page_id(), false);
+    }
+    // 已经通过回调、还没写进页面的记录，页面里读不到，要单独算进来
+    for (auto it = pending_.lower_bound({start, 0});
+         it != pending_.end() && it->first.first < start + pages_per_zone_; ++it) {
+        widen(zone, it->second.data());
+    }
+}
+
+/**
+ * @description: 扫描整个文件，重新计算所有区的精确区间
+ */
+void RmZoneMap::rebuild() {
+    std::scoped_lock lock{latch_};
+    int num_pages = file_handle_->get_file_hdr().num_pages;
+    int num_zones = num_pages > RM_FIRST_RECORD_PAGE ? zone_of(num_pages - 1) + 1 : 0;
+    zones_.assign(num_zones, Zone());
+    for (int i = 0; i < num_zones; i++) {
+        compute_zone(i, &zones_[i]);
+    }
+}
+
+/**
+ * @description: 重新计算删除过记录的区，使区间重新变紧
+ * @return {size_t} 重新计算的区数
+ * @note 可以和写操作并发：正在写的记录还不在页面里，但在pending_里，不会被漏掉；
+ *       正在删除的记录可能还被算进区间，只会让区间偏宽
+ */
+size_t RmZoneMap::refresh_stale_zones() {
+    std::scoped_lock lock{latch_};
+    size_t refreshed = 0;
+    for (int i = 0; i < (int)zones_.size(); i++) {
+        if (zones_[i].stale) {
+            compute_zone(i, &zones_[i]);
+            refreshed++;
+        }
+    }
+    return refreshed;
+}
+
+/**
+ * @description: 判断页面page_no所在的区中是否可能有满足pred的记录，返回false时可以跳过这个页面
+ */
+bool RmZoneMap::may_match(int page_no, const RmPredicate &pred) {
+    std::scoped_lock lock{latch_};
+    int zone_id = zone_of(page_no);
+    if (zone_id >= (int)zones_.size()) {
+        return true;
+    }
+    return zone_may_match(zones_[zone_id], pred);
+}
+
+bool RmZoneMap::zone_may_match(const Zone &zone, const RmPredicate &pred) const {
+    if (!zone.has_value) {
+        return false;
+    }
+    for (const RmCondition &cond : pred.get_conds()) {
+        size_t i = 0;
+        while (i < cols_.size() && !(cols_[i].offset == cond.col.offset && cols_[i].type == cond.col.type &&
+                                     cols_[i].len == cond.col.len)) {
+            i++;
+        }
+        if (i == cols_.size()) {
+            continue;   // 这一列没有维护区间，无法判断
+        }
+        const RmColumn &col = cols_[i];
+        const char *v = cond.value.data();
+        int min_cmp = rm_compare(zone.mins.data() + col_pos_[i], v, col.type, col.len);  // min 与 v 比较
+        int max_cmp = rm_compare(zone.maxs.data() + col_pos_[i], v, col.type, col.len);  // max 与 v 比较
+        bool ok = true;
+        switch (cond.op) {
+            case OP_EQ: ok = min_cmp <= 0 && max_cmp >= 0; break;
+            case OP_NE: ok = !(min_cmp == 0 && max_cmp == 0); break;
+            case OP_LT: ok = min_cmp < 0; break;
+            case OP_LE: ok = min_cmp <= 0; break;
+            case OP_GT: ok = max_cmp > 0; break;
+            case OP_GE: ok = max_cmp >= 0; break;
+        }
+        if (!ok) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// 记下还没写进页面的新记录，直到on_write_done
+void RmZoneMap::add_pending(const Rid &rid, const char *new_buf) {
+    pending_[{rid.page_no, rid.slot_no}].assign(new_buf, new_buf + file_handle_->get_file_hdr().record_size);
+}
+
+void RmZoneMap::on_insert(const Rid &rid, const char *new_buf) {
+    std::scoped_lock lock{latch_};
+    widen(&get_zone(zone_of(rid.page_no)), new_buf);
+    add_pending(rid, new_buf);
+}
+
+void RmZoneMap::on_update(const Rid &rid, const char *old_buf, const char *new_buf) {
+    std::scoped_lock lock{latch_};
+    Zone &zone = get_zone(zone_of(rid.page_no));
+    widen(&zone, new_buf);
+    zone.stale = true;  // 旧值可能是区间的端点
+    add_pending(rid, new_buf);
+}
+
+void RmZoneMap::on_delete(const Rid &rid, const char *old_buf) {
+    std::scoped_lock lock{latch_};
+    get_zone(zone_of(rid.page_no)).stale = true;
+}
+
+void RmZoneMap::on_write_done(const Rid &rid) {
+    std::scoped_lock lock{latch_};
+    pending_.erase({rid.page_no, rid.slot_no});
+}
@@ -0,0 +1,80 @@
+/* Copyright (c) 2023 Renmin University of China
+RMDB is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+        http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#pragma once
+
+#include <map>
+#include <mutex>
+#include <vector>
+
+#include "rm_file_handle.h"
+#include "rm_file_hook.h"
+#include "rm_predicate.h"
+
+/* 记录文件的区域映射（zone map）：每pages_per_zone个页面为一个区，记录区内若干列的最小值和最大值。
+   放在文件之外的内存结构里，通过RmFileHook在insert/update时放宽区间；delete不会缩小区间，
+   只把区标记为过期，区间仍然是正确的上界，refresh_stale_zones()可以重新精确计算。
+   回调在记录真正写进页面之前执行，从on_insert/on_update到on_write_done之间的新值记在pending_里，
+   重新计算区间时一并算进去，所以重新计算不必和写操作互斥。
+   带范围谓词的扫描先用may_match判断，不可能有满足条件记录的页面直接跳过，不需要读进缓冲池 */
+class RmZoneMap : public RmFileHook {
+   public:
+    RmZoneMap(RmFileHandle *file_handle, BufferPoolManager *buffer_pool_manager, std::vector<RmColumn> cols,
+              int pages_per_zone = 1);
+
+    ~RmZoneMap();
+
+    void rebuild();
+
+    size_t refresh_stale_zones();
+
+    bool may_match(int page_no, const RmPredicate &pred);
+
+    int get_pages_per_zone() const { return pages_per_zone_; }
+
+    void on_insert(const Rid &rid, const char *new_buf) override;
+
+    void on_update(const Rid &rid, const char *old_buf, const char *new_buf) override;
+
+    void on_delete(const Rid &rid, const char *old_buf) override;
+
+    void on_write_done(const Rid &rid) override;
+
+   private:
+    struct Zone {
+        bool has_value = false;     // 区内是否出现过记录
+        bool stale = false;         // 删除过记录，区间可能比实际宽
+        std::vector<char> mins;     // 各列的最小值，按cols_顺序拼接
+        std::vector<char> maxs;
+    };
+
+    int zone_of(int page_no) const { return (page_no - RM_FIRST_RECORD_PAGE) / pages_per_zone_; }
+
+    Zone &get_zone(int zone_id);
+
+    void widen(Zone *zone, const char *record);
+
+    void compute_zone(int zone_id, Zone *zone);
+
+    void add_pending(const Rid &rid, const char *new_buf);
+
+    bool zone_may_match(const Zone &zone, const RmPredicate &pred) const;
+
+    RmFileHandle *file_handle_;
+    BufferPoolManager *buffer_pool_manager_;
+    std::vector<RmColumn> cols_;
+    std::vector<int> col_pos_;      // 第i列的值在mins/maxs中的偏移
+    int values_len_ = 0;
+    int pages_per_zone_;
+
+    std::mutex latch_;
+    std::vector<Zone> zones_;
+    std::map<std::pair<int, int>, std::vector<char>> pending_;    // (page_no, slot_no) -> 还没写进页面的新记录
+};
@@ -0,0 +1,212 @@
+/* Copyright (c) 2023 Renmin University of China
+RMDB is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+        http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+/* 外部排序的基准测试。
+   输入是按lab3/campustakeaway.sql的orders表随机生成的记录，不经过记录文件，测的只是排序本身，执行
+     select * from orders order by price desc, order_id
+   数据量分别取--memory的1倍、10倍、100倍（--ratios），有序段数和归并趟数随之增加；
+   最后在最大的数据量上加 limit --limit 测top-N快速路径。
+   输出每秒排序的行数、生成的有序段数和归并趟数，ok表示输出确实有序且行数正确。
+
+   用法: sort_bench [--memory=1048576] [--ratios=1,10,100] [--limit=100] [--io-pages=16] [--dir=sort_bench_db]
+                    [--format=text|json] */
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "rm_column.h"
+#include "rm_external_sort.h"
+#include "storage/disk_manager.h"
+
+namespace {
+
+using bench_clock = std::chrono::steady_clock;
+
+// orders表：order_id, user_id, shangpu_id, price, create_time datetime
+const std::vector<RmColumn> ORDERS_COLS = {
+    {TYPE_INT, 0, 4}, {TYPE_INT, 4, 4}, {TYPE_INT, 8, 4}, {TYPE_FLOAT, 12, 4}, {TYPE_STRING, 16, 19}};
+constexpr int ORDERS_RECORD_SIZE = 35;
+constexpr int PRICE_COL = 3;
+
+struct SortBenchConfig {
+    size_t memory = 1 << 20;
+    std::vector<int> ratios = {1, 10, 100};
+    size_t limit = 100;
+    int io_pages = 16;
+    std::string dir = "sort_bench_db";
+    bool json = false;
+};
+
+struct SortBenchResult {
+    int ratio;
+    size_t limit;
+    size_t rows = 0;
+    size_t output_rows = 0;
+    double sec = 0;
+    RmSortStats stats;
+    bool ok = true;
+};
+
+int get_int(const char *rec, const RmColumn &col) {
+    int v;
+    memcpy(&v, rec + col.offset, sizeof(int));
+    return v;
+}
+
+float get_float(const char *rec, const RmColumn &col) {
+    float v;
+    memcpy(&v, rec + col.offset, sizeof(float));
+    return v;
+}
+
+// 生成rows条orders记录的输入，每次调用source都从同一个种子重新生成，结果相同
+RmOperatorInput make_orders_input(size_t rows) {
+    RmOperatorInput input;
+    input.source = [rows](const RmRecordSink &sink) {
+        std::mt19937_64 rng(42);
+        char rec[ORDERS_RECORD_SIZE];
+        for (size_t i = 0; i < rows; i++) {
+            memset(rec, 0, ORDERS_RECORD_SIZE);
+            int order_id = i + 1;
+            int user_id = rng() % 10000 + 1;
+            int shangpu_id = rng() % 500 + 1;
+            float price = (float)(rng() % 5000) / 100;
+            memcpy(rec + ORDERS_COLS[0].offset, &order_id, sizeof(int));
+            memcpy(rec + ORDERS_COLS[1].offset, &user_id, sizeof(int));
+            memcpy(rec + ORDERS_COLS[2].offset, &shangpu_id, sizeof(int));
+            memcpy(rec + ORDERS_COLS[PRICE_COL].offset, &price, sizeof(float));
+            snprintf(rec + ORDERS_COLS[4].offset, ORDERS_COLS[4].len, "2024-10-%02d 12:00:00", order_id % 28 + 1);
+            sink(rec);
+        }
+    };
+    input.record_size = ORDERS_RECORD_SIZE;
+    input.estimated_rows = rows;
+    return input;
+}
+
+SortBenchResult run_sort(const SortBenchConfig &config, DiskManager *disk_manager, int ratio, size_t limit) {
+    SortBenchResult result;
+    result.ratio = ratio;
+    result.limit = limit;
+    result.rows = config.memory * ratio / ORDERS_RECORD_SIZE;
+    const RmColumn &price_col = ORDERS_COLS[PRICE_COL];
+    const RmColumn &id_col = ORDERS_COLS[0];
+    RmExternalSort sort(disk_manager, make_orders_input(result.rows), {{price_col, true}, {id_col, false}},
+                        config.memory, config.dir + "/sort_", limit, config.io_pages);
+
+    // 检查输出按(price desc, order_id asc)有序
+    float last_price = 0;
+    int last_id = 0;
+    auto start = bench_clock::now();
+    sort.run([&](const char *record) {
+        float price = get_float(record, price_col);
+        int id = get_int(record, id_col);
+        if (result.output_rows > 0 && (price > last_price || (price == last_price && id <= last_id))) {
+            result.ok = false;
+        }
+        last_price = price;
+        last_id = id;
+        result.output_rows++;
+    });
+    result.sec = std::chrono::duration<double>(bench_clock::now() - start).count();
+    result.stats = sort.get_stats();
+    size_t expected = limit == 0 ? result.rows : std::min(limit, result.rows);
+    if (result.output_rows != expected) {
+        result.ok = false;
+    }
+    return result;
+}
+
+bool parse_args(int argc, char **argv, SortBenchConfig *config) {
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        size_t eq = arg.find('=');
+        std::string key = arg.substr(0, eq);
+        std::string value = eq == std::string::npos ? "" : arg.substr(eq + 1);
+        if (key == "--memory") {
+            config->memory = std::max<size_t>(PAGE_SIZE, std::strtoull(value.c_str(), nullptr, 10));
+        } else if (key == "--ratios") {
+            config->ratios.clear();
+            std::stringstream ss(value);
+            std::string item;
+            while (std::getline(ss, item, ',')) {
+                config->ratios.push_back(std::max(1, std::atoi(item.c_str())));
+            }
+            if (config->ratios.empty()) {
+                return false;
+            }
+        } else if (key == "--limit") {
+            config->limit = std::strtoull(value.c_str(), nullptr, 10);
+        } else if (key == "--io-pages") {
+            config->io_pages = std::max(1, std::atoi(value.c_str()));
+        } else if (key == "--dir") {
+            config->dir = value;
+        } else if (key == "--format") {
+            config->json = value == "json";
+        } else {
+            return false;
+        }
+    }
+    return true;
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+    SortBenchConfig config;
+    if (!parse_args(argc, argv, &config)) {
+        fprintf(stderr,
+                "usage: %s [--memory=BYTES] [--ratios=R1,R2,...] [--limit=N] [--io-pages=N] [--dir=PATH] "
+                "[--format=text|json]\n",
+                argv[0]);
+        return 1;
+    }
+
+    DiskManager disk_manager;
+    if (!disk_manager.is_dir(config.dir)) {
+        disk_manager.create_dir(config.dir);
+    }
+    std::vector<SortBenchResult> results;
+    for (int ratio : config.ratios) {
+        results.push_back(run_sort(config, &disk_manager, ratio, 0));
+    }
+    if (config.limit > 0) {
+        results.push_back(run_sort(config, &disk_manager, *std::max_element(config.ratios.begin(), config.ratios.end()),
+                                   config.limit));
+    }
+
+    if (config.json) {
+        printf("{\"memory\":%zu,\"record_size\":%d,\"results\":[", config.memory, ORDERS_RECORD_SIZE);
+        for (size_t i = 0; i < results.size(); i++) {
+            const SortBenchResult &r = results[i];
+            printf("%s{\"ratio\":%d,\"limit\":%zu,\"rows\":%zu,\"sec\":%.4f,\"rows_per_sec\":%.1f,\"runs\":%zu,"
+                   "\"merge_passes\":%d,\"top_n\":%s,\"ok\":%s}",
+                   i == 0 ? "" : ",", r.ratio, r.limit, r.rows, r.sec, r.rows / r.sec, r.stats.num_runs,
+                   r.stats.merge_passes, r.stats.top_n ? "true" : "false", r.ok ? "true" : "false");
+        }
+        printf("]}\n");
+    } else {
+        printf("memory=%zu record_size=%d\n", config.memory, ORDERS_RECORD_SIZE);
+        printf("%6s %6s %10s %10s %14s %6s %7s %6s %4s\n", "ratio", "limit", "rows", "sec", "rows/s", "runs",
+               "passes", "top_n", "ok");
+        for (const SortBenchResult &r : results) {
+            printf("%6d %6zu %10zu %10.4f %14.1f %6zu %7d %6s %4s\n", r.ratio, r.limit, r.rows, r.sec, r.rows / r.sec,
+                   r.stats.num_runs, r.stats.merge_passes, r.stats.top_n ? "yes" : "no", r.ok ? "yes" : "no");
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,269 @@
+/* Copyright (c) 2023 Renmin University of China
+RMDB is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+        http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+/* 二级页面缓存（SsdPageCache）的命中率和延迟基准测试。
+   --slow-dir下放数据文件（慢速存储），--fast-dir下放缓存文件（快速存储），本机测试时两个目录可以在同一块盘上，
+   每隔--drop-every次访问用POSIX_FADV_DONTNEED丢掉数据文件和缓存文件在操作系统中的缓存，
+   让未命中真正去读慢速存储、二级缓存命中真正去读快速存储。
+   按zipf分布随机访问页面（fetch_page + unpin_page），分别在不使用和使用二级缓存时运行，
+   输出吞吐、缓冲池命中率、二级缓存命中率和p50/p99/p999延迟。
+
+   用法: ssd_cache_bench [--slow-dir=slow_tier] [--fast-dir=fast_tier] [--pages=50000] [--pool=1024]
+                         [--cache-pages=16384] [--ops=200000] [--warmup=50000] [--zipf=0.9]
+                         [--admit-all] [--drop-every=1000] [--seed=42] [--format=text|json] */
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <numeric>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "ssd_page_cache.h"
+#include "storage/buffer_pool_manager.h"
+#include "storage/disk_manager.h"
+
+namespace {
+
+using bench_clock = std::chrono::steady_clock;
+
+struct SsdBenchConfig {
+    std::string slow_dir = "slow_tier";
+    std::string fast_dir = "fast_tier";
+    int pages = 50000;              // 数据文件的页面数
+    size_t pool_size = 1024;
+    size_t cache_pages = 16384;
+    size_t ops = 200000;
+    size_t warmup = 50000;          // 预热的访问次数，不计入结果
+    double zipf = 0.9;
+    bool admit_all = false;
+    size_t drop_every = 1000;
+    uint64_t seed = 42;
+    bool json = false;
+};
+
+struct SsdBenchResult {
+    const char *mode;
+    double run_sec = 0;
+    BufferPoolStats pool_stats;
+    SsdPageCacheStats cache_stats;
+    double p50_us = 0, p99_us = 0, p999_us = 0;
+};
+
+/* 按zipf分布抽取页号：先按排名算累积分布，再用一个随机排列把排名映射到页号，热点页面分散在文件各处 */
+class ZipfPages {
+   public:
+    ZipfPages(int n, double s, std::mt19937_64 &rng) : cdf_(n), pages_(n) {
+        double sum = 0;
+        for (int i = 0; i < n; i++) {
+            sum += 1.0 / std::pow(i + 1, s);
+            cdf_[i] = sum;
+        }
+        for (double &c : cdf_) {
+            c /= sum;
+        }
+        std::iota(pages_.begin(), pages_.end(), 0);
+        std::shuffle(pages_.begin(), pages_.end(), rng);
+    }
+
+    int next(std::mt19937_64 &rng) {
+        double u = std::uniform_real_distribution<double>(0, 1)(rng);
+        size_t rank = std::lower_bound(cdf_.begin(), cdf_.end(), u) - cdf_.begin();
+        return pages_[std::min(rank, pages_.size() - 1)];
+    }
+
+   private:
+    std::vector<double> cdf_;
+    std::vector<int> pages_;
+};
+
+SsdBenchResult run_mode(const SsdBenchConfig &config, DiskManager *disk_manager, int fd, bool use_cache) {
+    SsdBenchResult result;
+    result.mode = use_cache ? "ssd" : "none";
+    BufferPoolManager buffer_pool_manager(config.pool_size, disk_manager);
+    std::unique_ptr<SsdPageCache> cache;
+    if (use_cache) {
+        cache = std::make_unique<SsdPageCache>(config.fast_dir + "/ssd_cache", config.cache_pages, config.admit_all);
+        buffer_pool_manager.set_ssd_cache(cache.get());
+    }
+    std::mt19937_64 rng(config.seed);
+    ZipfPages zipf(config.pages, config.zipf, rng);
+    std::vector<uint64_t> latencies;
+    latencies.reserve(config.ops);
+    posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+    if (cache != nullptr) {
+        cache->drop_os_cache();
+    }
+
+    BufferPoolStats pool_before;
+    SsdPageCacheStats cache_before;
+    bench_clock::time_point run_start;
+    for (size_t i = 0; i < config.warmup + config.ops; i++) {
+        if (i == config.warmup) {
+            pool_before = buffer_pool_manager.get_stats();
+            cache_before = cache != nullptr ? cache->get_stats() : SsdPageCacheStats();
+            run_start = bench_clock::now();
+        }
+        if (config.drop_every > 0 && i % config.drop_every == 0) {
+            posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+            if (cache != nullptr) {
+                cache->drop_os_cache();
+            }
+        }
+        PageId page_id{fd, zipf.next(rng)};
+        auto start = bench_clock::now();
+        Page *page = buffer_pool_manager.fetch_page(page_id);
+        if (page == nullptr) {
+            throw InternalError("ssd_cache_bench: buffer pool exhausted");
+        }
+        int stamp;
+        memcpy(&stamp, page->get_data(), sizeof(int));
+        buffer_pool_manager.unpin_page(page_id, false);
+        if (stamp != page_id.page_no) {
+            throw InternalError("ssd_cache_bench: page " + std::to_string(page_id.page_no) + " has wrong content");
+        }
+        if (i >= config.warmup) {
+            latencies.push_back(
+                std::chrono::duration_cast<std::chrono::nanoseconds>(bench_clock::now() - start).count());
+        }
+    }
+    result.run_sec = std::chrono::duration<double>(bench_clock::now() - run_start).count();
+    result.pool_stats = buffer_pool_manager.get_stats() - pool_before;
+    if (cache != nullptr) {
+        SsdPageCacheStats after = cache->get_stats();
+        result.cache_stats.lookups = after.lookups - cache_before.lookups;
+        result.cache_stats.hits = after.hits - cache_before.hits;
+        result.cache_stats.admissions = after.admissions - cache_before.admissions;
+        result.cache_stats.rejections = after.rejections - cache_before.rejections;
+        result.cache_stats.evictions = after.evictions - cache_before.evictions;
+        result.cache_stats.invalidations = after.invalidations - cache_before.invalidations;
+    }
+    std::sort(latencies.begin(), latencies.end());
+    auto pct = [&](double q) {
+        return latencies.empty() ? 0 : latencies[std::min(latencies.size() - 1, (size_t)(q * latencies.size()))] / 1000.0;
+    };
+    result.p50_us = pct(0.50);
+    result.p99_us = pct(0.99);
+    result.p999_us = pct(0.999);
+    return result;
+}
+
+bool parse_args(int argc, char **argv, SsdBenchConfig *config) {
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        size_t eq = arg.find('=');
+        std::string key = arg.substr(0, eq);
+        std::string value = eq == std::string::npos ? "" : arg.substr(eq + 1);
+        if (key == "--slow-dir") {
+            config->slow_dir = value;
+        } else if (key == "--fast-dir") {
+            config->fast_dir = value;
+        } else if (key == "--pages") {
+            config->pages = std::max(1, std::atoi(value.c_str()));
+        } else if (key == "--pool") {
+            config->pool_size = std::max(16ULL, std::strtoull(value.c_str(), nullptr, 10));
+        } else if (key == "--cache-pages") {
+            config->cache_pages = std::strtoull(value.c_str(), nullptr, 10);
+        } else if (key == "--ops") {
+            config->ops = std::strtoull(value.c_str(), nullptr, 10);
+        } else if (key == "--warmup") {
+            config->warmup = std::strtoull(value.c_str(), nullptr, 10);
+        } else if (key == "--zipf") {
+            config->zipf = std::atof(value.c_str());
+        } else if (key == "--admit-all") {
+            config->admit_all = true;
+        } else if (key == "--drop-every") {
+            config->drop_every = std::strtoull(value.c_str(), nullptr, 10);
+        } else if (key == "--seed") {
+            config->seed = std::strtoull(value.c_str(), nullptr, 10);
+        } else if (key == "--format") {
+            config->json = value == "json";
+        } else {
+            return false;
+        }
+    }
+    return true;
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+    SsdBenchConfig config;
+    if (!parse_args(argc, argv, &config)) {
+        fprintf(stderr,
+                "usage: %s [--slow-dir=PATH] [--fast-dir=PATH] [--pages=N] [--pool=FRAMES] [--cache-pages=N]\n"
+                "          [--ops=N] [--warmup=N] [--zipf=S] [--admit-all] [--drop-every=N] [--seed=N]\n"
+                "          [--format=text|json]\n",
+                argv[0]);
+        return 1;
+    }
+
+    DiskManager disk_manager;
+    for (const std::string &dir : {config.slow_dir, config.fast_dir}) {
+        if (!disk_manager.is_dir(dir)) {
+            disk_manager.create_dir(dir);
+        }
+    }
+    // 数据文件：每个页面开头写上自己的页号，用来检查读到的内容
+    std::string data_path = config.slow_dir + "/ssd_bench_data";
+    if (disk_manager.is_file(data_path)) {
+        disk_manager.destroy_file(data_path);
+    }
+    disk_manager.create_file(data_path);
+    int fd = disk_manager.open_file(data_path);
+    const int batch_pages = 256;
+    std::vector<char> buf((size_t)batch_pages * PAGE_SIZE, 0);
+    for (int start = 0; start < config.pages; start += batch_pages) {
+        int n = std::min(batch_pages, config.pages - start);
+        for (int i = 0; i < n; i++) {
+            int page_no = start + i;
+            memcpy(buf.data() + (size_t)i * PAGE_SIZE, &page_no, sizeof(int));
+        }
+        disk_manager.write_page(fd, start, buf.data(), n * PAGE_SIZE);
+    }
+    fdatasync(fd);
+    disk_manager.set_fd2pageno(fd, config.pages);
+
+    SsdBenchResult results[] = {run_mode(config, &disk_manager, fd, false), run_mode(config, &disk_manager, fd, true)};
+    disk_manager.close_file(fd);
+    disk_manager.destroy_file(data_path);
+
+    if (config.json) {
+        printf("{\"pages\":%d,\"pool_frames\":%zu,\"cache_pages\":%zu,\"zipf\":%.2f,\"admit_all\":%s,\"modes\":{",
+               config.pages, config.pool_size, config.cache_pages, config.zipf, config.admit_all ? "true" : "false");
+        for (size_t i = 0; i < 2; i++) {
+            const SsdBenchResult &r = results[i];
+            printf("%s\"%s\":{\"ops_per_sec\":%.1f,\"pool_hit_rate\":%.4f,\"ssd_hit_rate\":%.4f,\"ssd_admissions\":%llu,"
+                   "\"ssd_rejections\":%llu,\"latency_us\":{\"p50\":%.2f,\"p99\":%.2f,\"p999\":%.2f}}",
+                   i == 0 ? "" : ",", r.mode, config.ops / r.run_sec, r.pool_stats.hit_rate(), r.cache_stats.hit_rate(),
+                   (unsigned long long)r.cache_stats.admissions, (unsigned long long)r.cache_stats.rejections,
+                   r.p50_us, r.p99_us, r.p999_us);
+        }
+        printf("}}\n");
+    } else {
+        printf("pages=%d pool=%zu frames cache=%zu pages zipf=%.2f%s\n", config.pages, config.pool_size,
+               config.cache_pages, config.zipf, config.admit_all ? " admit-all" : "");
+        printf("%-6s %12s %10s %10s %10s %10s %10s\n", "mode", "ops/s", "pool hit", "ssd hit", "p50(us)", "p99(us)",
+               "p999(us)");
+        for (const SsdBenchResult &r : results) {
+            printf("%-6s %12.1f %9.2f%% %9.2f%% %10.2f %10.2f %10.2f\n", r.mode, config.ops / r.run_sec,
+                   r.pool_stats.hit_rate() * 100, r.cache_stats.hit_rate() * 100, r.p50_us, r.p99_us, r.p999_us);
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,188 @@
+/* Copyright (c) 2023 Renmin University of China
+RMDB is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+        http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#include "ssd_page_cache.h"
+
+#include <fcntl.h>      // for open
+#include <sys/stat.h>   // for S_IRUSR
+#include <unistd.h>     // for pread, pwrite
+
+#include <algorithm>
+
+#include "errors.h"
+
+/**
+ * @description: 创建缓存文件
+ * @param {string} &path 缓存文件路径，应放在比数据文件更快的存储上
+ * @param {size_t} capacity_pages 缓存的页面数
+ * @param {bool} admit_on_first_eviction 为true时关闭准入控制，每个被淘汰的干净页面都写入缓存
+ */
+SsdPageCache::SsdPageCache(const std::string &path, size_t capacity_pages, bool admit_on_first_eviction)
+    : path_(path), capacity_(capacity_pages), admit_on_first_eviction_(admit_on_first_eviction) {
+    fd_ = open(path_.c_str(), O_RDWR | O_CREAT | O_TRUNC, S_IRUSR | S_IWUSR);
+    if (fd_ < 0) {
+        throw UnixError();
+    }
+    if (ftruncate(fd_, (off_t)capacity_ * PAGE_SIZE) < 0) {
+        close(fd_);
+        throw UnixError();
+    }
+    slot_keys_.assign(capacity_, INVALID_KEY);
+    referenced_.assign(capacity_, 0);
+    free_slots_.reserve(capacity_);
+    for (size_t i = capacity_; i > 0; i--) {
+        free_slots_.push_back(i - 1);
+    }
+    ghost_.assign(std::max<size_t>(capacity_, 1), INVALID_KEY);
+    index_.reserve(capacity_);
+}
+
+SsdPageCache::~SsdPageCache() {
+    close(fd_);
+    unlink(path_.c_str());
+}
+
+/**
+ * @description: 在缓存中查找页面，找到时把页面内容读到data
+ * @return {bool} 是否命中
+ */
+bool SsdPageCache::lookup(PageId page_id, char *data) {
+    std::scoped_lock lock{latch_};
+    stats_.lookups++;
+    auto it = index_.find(key_of(page_id));
+    if (it == index_.end()) {
+        return false;
+    }
+    if (pread(fd_, data, PAGE_SIZE, (off_t)it->second * PAGE_SIZE) != PAGE_SIZE) {
+        throw UnixError();
+    }
+    referenced_[it->second] = 1;
+    stats_.hits++;
+    return true;
+}
+
+// 缓存满了以后，页面第二次被淘汰时才准入
+bool SsdPageCache::should_admit(uint64_t key) {
+    if (admit_on_first_eviction_ || !free_slots_.empty()) {
+        return true;
+    }
+    uint64_t &ghost = ghost_[(key * 0x9e3779b97f4a7c15ULL >> 32) % ghost_.size()];
+    if (ghost == key) {
+        ghost = INVALID_KEY;
+        return true;
+    }
+    ghost = key;
+    return false;
+}
+
+// CLOCK：跳过访问位为1的槽并清零，返回第一个访问位为0的槽
+size_t SsdPageCache::find_victim() {
+    while (referenced_[hand_]) {
+        referenced_[hand_] = 0;
+        hand_ = (hand_ + 1) % capacity_;
+    }
+    size_t victim = hand_;
+    hand_ = (hand_ + 1) % capacity_;
+    return victim;
+}
+
+/**
+ * @description: 缓冲池淘汰一个干净页面时调用，按准入控制决定是否写入缓存
+ * @param {PageId} page_id 被淘汰的页面
+ * @param {char*} data 页面内容，和主存储上的内容一致
+ */
+void SsdPageCache::admit(PageId page_id, const char *data) {
+    if (capacity_ == 0) {
+        return;
+    }
+    uint64_t key = key_of(page_id);
+    std::scoped_lock lock{latch_};
+    auto it = index_.find(key);
+    if (it != index_.end()) {
+        referenced_[it->second] = 1;    // 页面是从缓存读上去的，没有被修改过，缓存中的副本仍然有效
+        return;
+    }
+    if (!should_admit(key)) {
+        stats_.rejections++;
+        return;
+    }
+    size_t slot;
+    if (!free_slots_.empty()) {
+        slot = free_slots_.back();
+        free_slots_.pop_back();
+    } else {
+        slot = find_victim();
+        index_.erase(slot_keys_[slot]);
+        stats_.evictions++;
+    }
+    if (pwrite(fd_, data, PAGE_SIZE, (off_t)slot * PAGE_SIZE) != PAGE_SIZE) {
+        slot_keys_[slot] = INVALID_KEY;
+        free_slots_.push_back(slot);
+        throw UnixError();
+    }
+    slot_keys_[slot] = key;
+    referenced_[slot] = 0;
+    index_[key] = slot;
+    stats_.admissions++;
+}
+
+/**
+ * @description: 作废页面在缓存中的副本，页面被写回主存储或被删除时调用
+ */
+void SsdPageCache::invalidate(PageId page_id) {
+    std::scoped_lock lock{latch_};
+    auto it = index_.find(key_of(page_id));
+    if (it == index_.end()) {
+        return;
+    }
+    slot_keys_[it->second] = INVALID_KEY;
+    referenced_[it->second] = 0;
+    free_slots_.push_back(it->second);
+    index_.erase(it);
+    stats_.invalidations++;
+}
+
+/**
+ * @description: 作废一个文件的所有缓存页面，文件关闭或删除后它的文件句柄可能被别的文件复用
+ */
+void SsdPageCache::invalidate_file(int fd) {
+    std::scoped_lock lock{latch_};
+    for (auto it = index_.begin(); it != index_.end();) {
+        if ((int)(it->first >> 32) == fd) {
+            slot_keys_[it->second] = INVALID_KEY;
+            referenced_[it->second] = 0;
+            free_slots_.push_back(it->second);
+            it = index_.erase(it);
+            stats_.invalidations++;
+        } else {
+            ++it;
+        }
+    }
+}
+
+/**
+ * @description: 把缓存文件写回设备并丢掉它在操作系统页缓存中的副本，之后的命中真正读快速存储。
+ *               缓存文件用普通的pread/pwrite访问，不丢的话命中基本都是内存拷贝，测不出快速存储的延迟
+ */
+void SsdPageCache::drop_os_cache() {
+    std::scoped_lock lock{latch_};
+    if (fdatasync(fd_) < 0) {
+        throw UnixError();
+    }
+    posix_fadvise(fd_, 0, 0, POSIX_FADV_DONTNEED);
+}
+
+/**
+ * @description: 获取缓存统计的一份拷贝
+ */
+SsdPageCacheStats SsdPageCache::get_stats() {
+    std::scoped_lock lock{latch_};
+    return stats_;
+}
@@ -0,0 +1,81 @@
+/* Copyright (c) 2023 Renmin University of China
+RMDB is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+        http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#pragma once
+
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "storage/page.h"
+
+struct SsdPageCacheStats {
+    uint64_t lookups = 0;
+    uint64_t hits = 0;
+    uint64_t admissions = 0;    // 写进缓存的页面数
+    uint64_t rejections = 0;    // 被准入控制拒绝的页面数
+    uint64_t evictions = 0;     // 为了腾出位置替换掉的页面数
+    uint64_t invalidations = 0; // 页面被写回主存储后作废的缓存副本数
+
+    double hit_rate() const { return lookups == 0 ? 0.0 : (double)hits / lookups; }
+};
+
+/* 缓冲池后面的第二级页面缓存，放在一个本地（快速存储上的）大文件里，按页面大小分成capacity_pages个槽。
+   BufferPoolManager淘汰干净页面时交给admit()，fetch_page未命中时先lookup()，找不到再读主存储上的数据文件。
+   内存中只保存 页面->槽号 的索引和每个槽的页面键、访问位，槽满后用CLOCK选择替换的槽。
+   准入控制：缓存有空槽时直接写入；满了以后一个页面要在最近被淘汰过（记录在按哈希直接映射的ghost表里）
+   才会写入，只被扫描一次的页面不会把缓存里的热页挤出去。
+   页面被写回主存储时缓存里的副本就过期了，由缓冲池调用invalidate()；关闭或删除文件前
+   BufferPoolManager::delete_all_pages调用invalidate_file()，避免句柄复用后读到旧文件的页面。缓存内容不跨进程保留 */
+class SsdPageCache {
+   public:
+    SsdPageCache(const std::string &path, size_t capacity_pages, bool admit_on_first_eviction = false);
+
+    ~SsdPageCache();
+
+    bool lookup(PageId page_id, char *data);
+
+    void admit(PageId page_id, const char *data);
+
+    void invalidate(PageId page_id);
+
+    void invalidate_file(int fd);
+
+    void drop_os_cache();
+
+    SsdPageCacheStats get_stats();
+
+    size_t get_capacity() const { return capacity_; }
+
+   private:
+    static constexpr uint64_t INVALID_KEY = UINT64_MAX;
+
+    static uint64_t key_of(PageId page_id) { return (uint64_t)(uint32_t)page_id.fd << 32 | (uint32_t)page_id.page_no; }
+
+    bool should_admit(uint64_t key);
+
+    size_t find_victim();
+
+    std::string path_;
+    int fd_;
+    size_t capacity_;
+    bool admit_on_first_eviction_;
+
+    std::mutex latch_;
+    std::unordered_map<uint64_t, uint32_t> index_;     // 页面键 -> 槽号
+    std::vector<uint64_t> slot_keys_;                   // 每个槽中的页面键，INVALID_KEY表示空槽
+    std::vector<uint8_t> referenced_;                   // CLOCK的访问位
+    std::vector<uint32_t> free_slots_;
+    size_t hand_ = 0;
+    std::vector<uint64_t> ghost_;                       // 最近被淘汰但没有准入的页面键
+    SsdPageCacheStats stats_;
+};
@@ -0,0 +1,987 @@
+/* Copyright (c) 2023 Renmin University of China
+RMDB is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+        http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+/* 校园外卖（lab3/campustakeaway.sql）负载的存储层基准测试。
+   按sql中的表结构建立定长记录文件，按--scale生成数据，然后用N个线程按给定比例执行
+   下单、修改订单状态、读菜单、报表扫描、登录五种操作（登录默认比例为0），输出吞吐、各操作的p50/p99/p999延迟和缓冲池命中率。
+   --format=json时输出一行json，便于回归比较。
+   --vacuum=F时在加载后随机删除比例F的订单和评论，用RmCompactor整理这两张表，比较整理前后扫描orders的时间；
+   加上--vacuum-online时整理在后台线程中和负载同时进行，--vacuum-rate限制每秒搬动的记录数。
+   --matagg时在负载开始前登记物化聚合（每个菜品的销量、每个商家的订单数、每个商铺的菜品平均评分），
+   读菜单时直接读聚合结果，负载结束后做一致性检查；不加--matagg时读菜单用菜品记录现算评分、扫描orders_dish统计销量。
+   比较两者可以看出读菜单省下的扫描和写路径上维护聚合的开销。
+   --pools时把缓冲池分成子池：user、user_role、cafeteria放进不被抢占的池并整个读入，orders、orders_dish、comment
+   放进最多占1/4帧的扫描池，输出各子池的统计。例如--mix=login:80,report:20加上和不加--pools，
+   比较报表扫描同时进行时登录（小表点读）的尾延迟。
+
+   用法: takeaway_bench [--scale=1] [--threads=4] [--duration=10] [--ops=0] [--pool=1024]
+                        [--mix=place:40,status:30,menu:25,report:5] [--scan=rmscan|predicate|parallel]
+                        [--vacuum=0] [--vacuum-rate=0] [--vacuum-online] [--matagg] [--pools]
+                        [--dir=takeaway_bench_db] [--seed=42] [--format=text|json] [--keep] */
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <shared_mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "rm_column.h"
+#include "rm_compactor.h"
+#include "rm_manager.h"
+#include "rm_materialized_agg.h"
+#include "rm_parallel_scan.h"
+#include "rm_predicate_scan.h"
+#include "rm_scan.h"
+#include "storage/buffer_pool_manager.h"
+#include "storage/disk_manager.h"
+
+namespace {
+
+using bench_clock = std::chrono::steady_clock;
+
+/* sql类型到定长列的对应：int -> INT，varchar(n) -> n字节STRING，text -> 128字节STRING，
+   datetime -> INT(秒)，numeric/decimal -> FLOAT */
+constexpr int TEXT_LEN = 128;
+
+struct BenchColumn {
+    const char *name;
+    ColType type;
+    int len;
+};
+
+/* 一张表：记录文件和列布局。RmFileHandle本身不是线程安全的，写操作持有latch的独占锁，读操作和扫描持有共享锁。
+   rids保存已有记录的位置，供随机点读/更新挑选 */
+struct BenchTable {
+    std::string name;
+    std::vector<RmColumn> cols;
+    std::vector<const char *> col_names;
+    int record_size = 0;
+    std::unique_ptr<RmFileHandle> file_handle;
+    std::shared_mutex latch;
+    std::mutex rids_latch;
+    std::vector<Rid> rids;
+
+    BenchTable(std::string table_name, const std::vector<BenchColumn> &columns) : name(std::move(table_name)) {
+        for (const BenchColumn &c : columns) {
+            cols.push_back(RmColumn{c.type, record_size, c.len});
+            col_names.push_back(c.name);
+            record_size += c.len;
+        }
+    }
+
+    const RmColumn &col(const char *col_name) const {
+        for (size_t i = 0; i < cols.size(); i++) {
+            if (strcmp(col_names[i], col_name) == 0) {
+                return cols[i];
+            }
+        }
+        throw ColumnNotFoundError(name + "." + col_name);
+    }
+
+    void add_rid(const Rid &rid) {
+        std::scoped_lock lock{rids_latch};
+        rids.push_back(rid);
+    }
+
+    Rid random_rid(std::mt19937_64 &rng) {
+        std::scoped_lock lock{rids_latch};
+        return rids[rng() % rids.size()];
+    }
+};
+
+void set_int(char *rec, const RmColumn &col, int v) { memcpy(rec + col.offset, &v, sizeof(int)); }
+
+void set_float(char *rec, const RmColumn &col, float v) { memcpy(rec + col.offset, &v, sizeof(float)); }
+
+void set_str(char *rec, const RmColumn &col, const std::string &v) {
+    memset(rec + col.offset, 0, col.len);
+    memcpy(rec + col.offset, v.data(), std::min((int)v.size(), col.len));
+}
+
+int get_int(const char *rec, const RmColumn &col) {
+    int v;
+    memcpy(&v, rec + col.offset, sizeof(int));
+    return v;
+}
+
+float get_float(const char *rec, const RmColumn &col) {
+    float v;
+    memcpy(&v, rec + col.offset, sizeof(float));
+    return v;
+}
+
+std::vector<char> int_value(int v) {
+    std::vector<char> value(sizeof(int));
+    memcpy(value.data(), &v, sizeof(int));
+    return value;
+}
+
+std::vector<char> str_value(const RmColumn &col, const std::string &v) {
+    std::vector<char> value(col.len, 0);
+    memcpy(value.data(), v.data(), std::min((int)v.size(), col.len));
+    return value;
+}
+
+// 订单状态按顺序推进
+const char *const ORDER_STATUS[] = {"placed", "accepted", "delivering", "delivered"};
+constexpr int NUM_ORDER_STATUS = 4;
+
+enum BenchOp { OP_PLACE_ORDER = 0, OP_UPDATE_STATUS, OP_READ_MENU, OP_REPORT_SCAN, OP_LOGIN, NUM_BENCH_OPS };
+const char *const BENCH_OP_NAMES[NUM_BENCH_OPS] = {"place", "status", "menu", "report", "login"};
+
+enum ScanMode { SCAN_RMSCAN, SCAN_PREDICATE, SCAN_PARALLEL };
+
+struct BenchConfig {
+    int scale = 1;
+    int threads = 4;
+    double duration = 10;           // 秒，ops为0时按时间运行
+    size_t ops = 0;                 // 每个线程执行的操作数
+    size_t pool_size = 1024;        // 缓冲池帧数
+    int mix[NUM_BENCH_OPS] = {40, 30, 25, 5, 0};
+    ScanMode scan = SCAN_RMSCAN;
+    double vacuum = 0;              // 加载后删除的订单、评论比例
+    double vacuum_rate = 0;         // 整理时每秒最多搬动的记录数
+    bool vacuum_online = false;
+    bool matagg = false;            // 登记物化聚合
+    bool pools = false;             // 划分缓冲池子池
+    std::string dir = "takeaway_bench_db";
+    uint64_t seed = 42;
+    bool json = false;
+    bool keep = false;
+};
+
+/* 建表、生成数据、执行各种操作 */
+class TakeawayDb {
+   public:
+    TakeawayDb(const BenchConfig &config, DiskManager *disk_manager, BufferPoolManager *buffer_pool_manager)
+        : config_(config),
+          disk_manager_(disk_manager),
+          buffer_pool_manager_(buffer_pool_manager),
+          rm_manager_(disk_manager, buffer_pool_manager),
+          user_role_("user_role", {{"role_id", TYPE_INT, 4}, {"role_name", TYPE_STRING, 20}}),
+          user_("user", {{"user_id", TYPE_INT, 4}, {"role_id", TYPE_INT, 4}, {"password", TYPE_STRING, 50}}),
+          cafe_admin_("cafe_admin",
+                      {{"cafeadmin_id", TYPE_INT, 4}, {"user_id", TYPE_INT, 4}, {"cafeadmin_name", TYPE_STRING, 50}}),
+          cafeteria_("cafeteria", {{"cafeteria_id", TYPE_INT, 4},
+                                   {"cafeadmin_id", TYPE_INT, 4},
+                                   {"cafeteria_name", TYPE_STRING, 50}}),
+          merchant_("merchant", {{"merchant_id", TYPE_INT, 4},
+                                 {"user_id", TYPE_INT, 4},
+                                 {"merchant_name", TYPE_STRING, 50},
+                                 {"merchant_text", TYPE_STRING, TEXT_LEN}}),
+          normal_user_("normal_user", {{"normal_user_id", TYPE_INT, 4},
+                                       {"user_id", TYPE_INT, 4},
+                                       {"normal_user_name", TYPE_STRING, 50},
+                                       {"history_orders", TYPE_INT, 4},
+                                       {"vip_level", TYPE_INT, 4}}),
+          shangpu_("shangpu", {{"shangpu_id", TYPE_INT, 4},
+                               {"merchant_id", TYPE_INT, 4},
+                               {"cafeteria_id", TYPE_INT, 4},
+                               {"shangpu_name", TYPE_STRING, 50},
+                               {"shangpu_text", TYPE_STRING, TEXT_LEN},
+                               {"shangpu_score", TYPE_FLOAT, 4}}),
+          dish_("dish", {{"dish_id", TYPE_INT, 4},
+                         {"shangpu_id", TYPE_INT, 4},
+                         {"price", TYPE_FLOAT, 4},
+                         {"dish_text", TYPE_STRING, TEXT_LEN},
+                         {"dish_name", TYPE_STRING, 100},
+                         {"dish_score", TYPE_FLOAT, 4}}),
+          orders_("orders", {{"order_id", TYPE_INT, 4},
+                             {"normal_user_id", TYPE_INT, 4},
+                             {"merchant_id", TYPE_INT, 4},
+                             {"order_status", TYPE_STRING, 20},
+                             {"address", TYPE_STRING, 100},
+                             {"create_time", TYPE_INT, 4}}),
+          orders_dish_("orders_dish", {{"order_id", TYPE_INT, 4}, {"dish_id", TYPE_INT, 4}}),
+          comment_("comment", {{"comment_id", TYPE_INT, 4},
+                               {"order_id", TYPE_INT, 4},
+                               {"comment_text", TYPE_STRING, TEXT_LEN},
+                               {"comment_create_time", TYPE_INT, 4}}) {
+        tables_ = {&user_role_, &user_,     &cafe_admin_, &cafeteria_, &merchant_, &normal_user_,
+                   &shangpu_,   &dish_,     &orders_,     &orders_dish_, &comment_};
+        num_merchants_ = 100 * config_.scale;
+        num_normal_users_ = 1800 * config_.scale;
+        num_shangpu_ = 200 * config_.scale;
+        num_orders_ = 20000 * config_.scale;
+    }
+
+    ~TakeawayDb() {
+        dish_sales_.reset();
+        merchant_orders_.reset();
+        shangpu_scores_.reset();
+        for (BenchTable *table : tables_) {
+            if (table->file_handle != nullptr) {
+                rm_manager_.close_file(table->file_handle.get());
+                table->file_handle.reset();
+            }
+            if (!config_.keep && disk_manager_->is_file(path_of(*table))) {
+                rm_manager_.destroy_file(path_of(*table));
+            }
+        }
+    }
+
+    void create_tables() {
+        if (!disk_manager_->is_dir(config_.dir)) {
+            disk_manager_->create_dir(config_.dir);
+        }
+        for (BenchTable *table : tables_) {
+            std::string path = path_of(*table);
+            if (disk_manager_->is_file(path)) {
+                rm_manager_.destroy_file(path);     // 上次用--keep留下的文件
+            }
+            rm_manager_.create_file(path, table->record_size);
+            table->file_handle = rm_manager_.open_file(path);
+        }
+    }
+
+    /* 按scale生成数据，ID都是从1开始的连续整数，外键均匀分布 */
+    void load(std::mt19937_64 &rng) {
+        int scale = config_.scale;
+        int num_admins = 4 * scale;
+        int num_users = num_admins + num_merchants_ + num_normal_users_;
+        const char *const role_names[] = {"cafe_admin", "merchant", "normal_user"};
+        for (int i = 0; i < 3; i++) {
+            std::vector<char> rec(user_role_.record_size, 0);
+            set_int(rec.data(), user_role_.col("role_id"), i + 1);
+            set_str(rec.data(), user_role_.col("role_name"), role_names[i]);
+            insert(user_role_, rec.data());
+        }
+        for (int i = 1; i <= num_users; i++) {
+            std::vector<char> rec(user_.record_size, 0);
+            set_int(rec.data(), user_.col("user_id"), i);
+            set_int(rec.data(), user_.col("role_id"), i <= num_admins ? 1 : (i <= num_admins + num_merchants_ ? 2 : 3));
+            set_str(rec.data(), user_.col("password"), "pw" + std::to_string(rng() % 1000000));
+            insert(user_, rec.data());
+        }
+        for (int i = 1; i <= num_admins; i++) {
+            std::vector<char> rec(cafe_admin_.record_size, 0);
+            set_int(rec.data(), cafe_admin_.col("cafeadmin_id"), i);
+            set_int(rec.data(), cafe_admin_.col("user_id"), i);
+            set_str(rec.data(), cafe_admin_.col("cafeadmin_name"), "admin_" + std::to_string(i));
+            insert(cafe_admin_, rec.data());
+
+            std::vector<char> cafe(cafeteria_.record_size, 0);
+            set_int(cafe.data(), cafeteria_.col("cafeteria_id"), i);
+            set_int(cafe.data(), cafeteria_.col("cafeadmin_id"), i);
+            set_str(cafe.data(), cafeteria_.col("cafeteria_name"), "cafeteria_" + std::to_string(i));
+            insert(cafeteria_, cafe.data());
+        }
+        for (int i = 1; i <= num_merchants_; i++) {
+            std::vector<char> rec(merchant_.record_size, 0);
+            set_int(rec.data(), merchant_.col("merchant_id"), i);
+            set_int(rec.data(), merchant_.col("user_id"), num_admins + i);
+            set_str(rec.data(), merchant_.col("merchant_name"), "merchant_" + std::to_string(i));
+            set_str(rec.data(), merchant_.col("merchant_text"), "merchant description " + std::to_string(rng()));
+            insert(merchant_, rec.data());
+        }
+        for (int i = 1; i <= num_normal_users_; i++) {
+            std::vector<char> rec(normal_user_.record_size, 0);
+            set_int(rec.data(), normal_user_.col("normal_user_id"), i);
+            set_int(rec.data(), normal_user_.col("user_id"), num_admins + num_merchants_ + i);
+            set_str(rec.data(), normal_user_.col("normal_user_name"), "student_" + std::to_string(i));
+            set_int(rec.data(), normal_user_.col("history_orders"), 0);
+            set_int(rec.data(), normal_user_.col("vip_level"), (int)(rng() % 5));
+            insert(normal_user_, rec.data());
+        }
+        for (int i = 1; i <= num_shangpu_; i++) {
+            std::vector<char> rec(shangpu_.record_size, 0);
+            set_int(rec.data(), shangpu_.col("shangpu_id"), i);
+            set_int(rec.data(), shangpu_.col("merchant_id"), (i - 1) % num_merchants_ + 1);
+            set_int(rec.data(), shangpu_.col("cafeteria_id"), (i - 1) % num_admins + 1);
+            set_str(rec.data(), shangpu_.col("shangpu_name"), "shangpu_" + std::to_string(i));
+            set_str(rec.data(), shangpu_.col("shangpu_text"), "window " + std::to_string(i) + " on floor " +
+                                                                  std::to_string(rng() % 3 + 1));
+            set_float(rec.data(), shangpu_.col("shangpu_score"), (float)(rng() % 50) / 10);
+            insert(shangpu_, rec.data());
+        }
+        // 菜品按商铺连续生成，第k个商铺的菜品是dish_.rids中[k*DISHES_PER_SHANGPU, (k+1)*DISHES_PER_SHANGPU)
+        int dish_id = 0;
+        for (int i = 1; i <= num_shangpu_; i++) {
+            for (int j = 0; j < DISHES_PER_SHANGPU; j++) {
+                std::vector<char> rec(dish_.record_size, 0);
+                set_int(rec.data(), dish_.col("dish_id"), ++dish_id);
+                set_int(rec.data(), dish_.col("shangpu_id"), i);
+                set_float(rec.data(), dish_.col("price"), (float)(rng() % 30 + 5));
+                set_str(rec.data(), dish_.col("dish_text"), "dish description " + std::to_string(rng()));
+                set_str(rec.data(), dish_.col("dish_name"), "dish_" + std::to_string(dish_id));
+                set_float(rec.data(), dish_.col("dish_score"), (float)(rng() % 50) / 10);
+                insert(dish_, rec.data());
+            }
+        }
+        for (int i = 0; i < num_orders_; i++) {
+            place_order(rng, (int)(rng() % NUM_ORDER_STATUS));
+        }
+        int num_comments = num_orders_ * 2 / 5;
+        for (int i = 1; i <= num_comments; i++) {
+            std::vector<char> rec(comment_.record_size, 0);
+            set_int(rec.data(), comment_.col("comment_id"), i);
+            set_int(rec.data(), comment_.col("order_id"), (int)(rng() % num_orders_) + 1);
+            set_str(rec.data(), comment_.col("comment_text"), "comment " + std::to_string(rng()));
+            set_int(rec.data(), comment_.col("comment_create_time"), BASE_TIME + (int)(rng() % (86400 * 30)));
+            insert(comment_, rec.data());
+        }
+    }
+
+    size_t num_pages() {
+        size_t pages = 0;
+        for (BenchTable *table : tables_) {
+            pages += table->file_handle->get_file_hdr().num_pages;
+        }
+        return pages;
+    }
+
+    /* 下单：插入一条订单、1~3条订单菜品，并更新用户的历史订单数 */
+    void place_order(std::mt19937_64 &rng, int status = 0) {
+        int order_id = next_order_id_.fetch_add(1) + 1;
+        int normal_user_id = (int)(rng() % num_normal_users_) + 1;
+        int shangpu_idx = (int)(rng() % num_shangpu_);
+
+        std::vector<char> rec(orders_.record_size, 0);
+        set_int(rec.data(), orders_.col("order_id"), order_id);
+        set_int(rec.data(), orders_.col("normal_user_id"), normal_user_id);
+        set_int(rec.data(), orders_.col("merchant_id"), shangpu_idx % num_merchants_ + 1);
+        set_str(rec.data(), orders_.col("order_status"), ORDER_STATUS[status]);
+        set_str(rec.data(), orders_.col("address"), "dorm " + std::to_string(rng() % 20 + 1) + " room " +
+                                                        std::to_string(rng() % 600 + 100));
+        set_int(rec.data(), orders_.col("create_time"), BASE_TIME + order_id);
+        insert(orders_, rec.data());
+
+        int num_dishes = (int)(rng() % 3) + 1;
+        for (int i = 0; i < num_dishes; i++) {
+            std::vector<char> item(orders_dish_.record_size, 0);
+            set_int(item.data(), orders_dish_.col("order_id"), order_id);
+            set_int(item.data(), orders_dish_.col("dish_id"),
+                    shangpu_idx * DISHES_PER_SHANGPU + (int)(rng() % DISHES_PER_SHANGPU) + 1);
+            insert(orders_dish_, item.data());
+        }
+
+        // 普通用户按normal_user_id顺序生成，第i个用户就是rids[i-1]
+        Rid user_rid = normal_user_.rids[normal_user_id - 1];
+        std::unique_lock lock{normal_user_.latch};
+        auto user = normal_user_.file_handle->get_record(user_rid, nullptr);
+        const RmColumn &history = normal_user_.col("history_orders");
+        set_int(user->data, history, get_int(user->data, history) + 1);
+        normal_user_.file_handle->update_record(user_rid, user->data, nullptr);
+    }
+
+    /* 修改订单状态：随机选一个订单，把状态推进到下一个 */
+    void update_status(std::mt19937_64 &rng) {
+        Rid rid = orders_.random_rid(rng);
+        const RmColumn &status_col = orders_.col("order_status");
+        std::unique_lock lock{orders_.latch};
+        auto order = orders_.file_handle->get_record(rid, nullptr);
+        if (order == nullptr) {
+            return;     // 选中之后被整理搬走了，或者所在页面已经被截掉
+        }
+        int status = 0;
+        while (status < NUM_ORDER_STATUS - 1 &&
+               strncmp(order->data + status_col.offset, ORDER_STATUS[status], status_col.len) != 0) {
+            status++;
+        }
+        set_str(order->data, status_col, ORDER_STATUS[(status + 1) % NUM_ORDER_STATUS]);
+        orders_.file_handle->update_record(rid, order->data, nullptr);
+    }
+
+    /* 读菜单：读一个商铺和它的全部菜品，以及商铺评分和各菜品的销量 */
+    size_t read_menu(std::mt19937_64 &rng) {
+        int shangpu_idx = (int)(rng() % num_shangpu_);
+        int first_dish_id = shangpu_idx * DISHES_PER_SHANGPU + 1;
+        size_t bytes = 0;
+        {
+            std::shared_lock lock{shangpu_.latch};
+            bytes += shangpu_.file_handle->get_record(shangpu_.rids[shangpu_idx], nullptr)->size;
+        }
+        float score_sum = 0;
+        {
+            std::shared_lock lock{dish_.latch};
+            for (int i = 0; i < DISHES_PER_SHANGPU; i++) {
+                auto dish = dish_.file_handle->get_record(dish_.rids[shangpu_idx * DISHES_PER_SHANGPU + i], nullptr);
+                bytes += dish->size;
+                score_sum += get_float(dish->data, dish_.col("dish_score"));
+            }
+        }
+        if (dish_sales_ != nullptr) {
+            // 商铺评分和各菜品销量直接读物化聚合，不扫描orders_dish
+            int shangpu_id = shangpu_idx + 1;
+            bytes += shangpu_scores_->get((const char *)&shangpu_id, 0) > 0;
+            for (int i = 0; i < DISHES_PER_SHANGPU; i++) {
+                int dish_id = first_dish_id + i;
+                bytes += dish_sales_->get_count((const char *)&dish_id) > 0;
+            }
+            return bytes;
+        }
+        // 没有物化聚合：评分用刚读到的菜品现算，销量要扫描orders_dish，统计这几个菜品出现的次数
+        bytes += score_sum / DISHES_PER_SHANGPU > 0;
+        const RmColumn &dish_col = orders_dish_.col("dish_id");
+        RmPredicate pred({RmCondition{dish_col, OP_GE, int_value(first_dish_id)},
+                          RmCondition{dish_col, OP_LT, int_value(first_dish_id + DISHES_PER_SHANGPU)}});
+        size_t sales[DISHES_PER_SHANGPU] = {};
+        std::shared_lock lock{orders_dish_.latch};
+        for (RmPredicateScan scan(orders_dish_.file_handle.get(), buffer_pool_manager_, pred); !scan.is_end();
+             scan.next()) {
+            sales[get_int(scan.record(), dish_col) - first_dish_id]++;
+        }
+        for (size_t count : sales) {
+            bytes += count > 0;
+        }
+        return bytes;
+    }
+
+    /* 登录：随机点读一个用户、它的角色和一个食堂，都是经常访问的小表 */
+    size_t login(std::mt19937_64 &rng) {
+        size_t bytes = 0;
+        int role_id;
+        {
+            std::shared_lock lock{user_.latch};
+            auto user = user_.file_handle->get_record(user_.random_rid(rng), nullptr);
+            role_id = get_int(user->data, user_.col("role_id"));
+            bytes += user->size;
+        }
+        {
+            std::shared_lock lock{user_role_.latch};
+            bytes += user_role_.file_handle->get_record(user_role_.rids[role_id - 1], nullptr)->size;
+        }
+        std::shared_lock lock{cafeteria_.latch};
+        bytes += cafeteria_.file_handle->get_record(cafeteria_.random_rid(rng), nullptr)->size;
+        return bytes;
+    }
+
+    /* 划分缓冲池子池：小表放进不被抢占的池并整个读入，大表的扫描限制在扫描池中 */
+    void setup_pools() {
+        std::vector<BenchTable *> small_tables = {&user_, &user_role_, &cafeteria_};
+        std::vector<BenchTable *> scan_tables = {&orders_, &orders_dish_, &comment_};
+        size_t small_pages = 0;
+        for (BenchTable *table : small_tables) {
+            small_pages += table->file_handle->get_file_hdr().num_pages - RM_FIRST_RECORD_PAGE;  // 文件头页不进缓冲池
+        }
+        BufferSubPoolOptions small_options;
+        small_options.min_frames = std::min(small_pages, config_.pool_size / 2);
+        small_options.no_steal = true;
+        BufferSubPoolOptions scan_options;
+        scan_options.max_frames = std::max<size_t>(16, config_.pool_size / 4);
+        int small_pool = buffer_pool_manager_->create_sub_pool("small", small_options);
+        int scan_pool = buffer_pool_manager_->create_sub_pool("scan", scan_options);
+        for (BenchTable *table : small_tables) {
+            int fd = disk_manager_->get_file_fd(path_of(*table));
+            buffer_pool_manager_->assign_file(fd, small_pool);
+            buffer_pool_manager_->preload_file(fd, RM_FIRST_RECORD_PAGE);
+        }
+        for (BenchTable *table : scan_tables) {
+            buffer_pool_manager_->assign_file(disk_manager_->get_file_fd(path_of(*table)), scan_pool);
+        }
+    }
+
+    /* 登记物化聚合，返回用时（秒） */
+    double enable_materialized_aggs() {
+        auto start = bench_clock::now();
+        dish_sales_ = std::make_unique<RmMaterializedAgg>(
+            orders_dish_.file_handle.get(), buffer_pool_manager_, &orders_dish_.latch,
+            std::vector<RmColumn>{orders_dish_.col("dish_id")},
+            std::vector<RmAggSpec>{RmAggSpec{AGG_COUNT, orders_dish_.col("dish_id")}});
+        merchant_orders_ = std::make_unique<RmMaterializedAgg>(
+            orders_.file_handle.get(), buffer_pool_manager_, &orders_.latch,
+            std::vector<RmColumn>{orders_.col("merchant_id")},
+            std::vector<RmAggSpec>{RmAggSpec{AGG_COUNT, orders_.col("merchant_id")}});
+        shangpu_scores_ = std::make_unique<RmMaterializedAgg>(
+            dish_.file_handle.get(), buffer_pool_manager_, &dish_.latch, std::vector<RmColumn>{dish_.col("shangpu_id")},
+            std::vector<RmAggSpec>{RmAggSpec{AGG_AVG, dish_.col("dish_score")},
+                                   RmAggSpec{AGG_COUNT, dish_.col("dish_score")}});
+        return std::chrono::duration<double>(bench_clock::now() - start).count();
+    }
+
+    /* 对所有物化聚合做一致性检查，检查期间阻塞对应表的写 */
+    RmAggCheckResult check_materialized_aggs() {
+        RmAggCheckResult total;
+        for (RmMaterializedAgg *agg : {dish_sales_.get(), merchant_orders_.get(), shangpu_scores_.get()}) {
+            RmAggCheckResult result = agg->check_consistency();
+            total.groups_checked += result.groups_checked;
+            total.mismatched_groups += result.mismatched_groups;
+        }
+        return total;
+    }
+
+    /* 报表扫描：统计已送达的订单数，扫描期间阻塞对orders的写 */
+    size_t report_scan() {
+        const RmColumn &status_col = orders_.col("order_status");
+        std::vector<char> delivered = str_value(status_col, ORDER_STATUS[NUM_ORDER_STATUS - 1]);
+        std::shared_lock lock{orders_.latch};
+        RmFileHandle *file_handle = orders_.file_handle.get();
+        size_t count = 0;
+        switch (config_.scan) {
+            case SCAN_RMSCAN:
+                for (RmScan scan(file_handle); !scan.is_end(); scan.next()) {
+                    auto rec = file_handle->get_record(scan.rid(), nullptr);
+                    if (memcmp(rec->data + status_col.offset, delivered.data(), status_col.len) == 0) {
+                        count++;
+                    }
+                }
+                break;
+            case SCAN_PREDICATE: {
+                RmPredicate pred({RmCondition{status_col, OP_EQ, delivered}});
+                for (RmPredicateScan scan(file_handle, buffer_pool_manager_, pred); !scan.is_end(); scan.next()) {
+                    count++;
+                }
+                break;
+            }
+            case SCAN_PARALLEL: {
+                RmParallelScan scan(file_handle, buffer_pool_manager_);
+                count = scan.count_if([&](const char *record) {
+                    return memcmp(record + status_col.offset, delivered.data(), status_col.len) == 0;
+                });
+                break;
+            }
+        }
+        return count;
+    }
+
+    /* 模拟取消订单和清理评论：随机删除fraction比例的orders和comment记录 */
+    size_t purge(double fraction, std::mt19937_64 &rng) {
+        return purge_table(orders_, fraction, rng) + purge_table(comment_, fraction, rng);
+    }
+
+    /* 用RmScan完整扫一遍orders，返回用时（秒） */
+    double scan_orders_sec() {
+        auto start = bench_clock::now();
+        std::shared_lock lock{orders_.latch};
+        size_t count = 0;
+        for (RmScan scan(orders_.file_handle.get()); !scan.is_end(); scan.next()) {
+            count += orders_.file_handle->get_record(scan.rid(), nullptr) != nullptr;
+        }
+        return std::chrono::duration<double>(bench_clock::now() - start).count();
+    }
+
+    /* 整理orders和comment，返回两张表合计的统计 */
+    RmCompactStats vacuum() {
+        RmCompactStats total;
+        for (BenchTable *table : {&orders_, &comment_}) {
+            RmCompactStats stats = compact_table(*table);
+            total.records_moved += stats.records_moved;
+            total.batches += stats.batches;
+            total.pages_before += stats.pages_before;
+            total.pages_after += stats.pages_after;
+            total.elapsed_sec += stats.elapsed_sec;
+        }
+        return total;
+    }
+
+   private:
+    static constexpr int DISHES_PER_SHANGPU = 20;
+    static constexpr int BASE_TIME = 1727712000;     // 2024-10-01
+
+    std::string path_of(const BenchTable &table) const { return config_.dir + "/" + table.name; }
+
+    void insert(BenchTable &table, char *buf) {
+        Rid rid;
+        {
+            std::unique_lock lock{table.latch};
+            rid = table.file_handle->insert_record(buf, nullptr);
+        }
+        table.add_rid(rid);
+    }
+
+    size_t purge_table(BenchTable &table, double fraction, std::mt19937_64 &rng) {
+        std::unique_lock lock{table.latch};
+        std::scoped_lock rids_lock{table.rids_latch};
+        std::shuffle(table.rids.begin(), table.rids.end(), rng);
+        size_t num_deleted = (size_t)(table.rids.size() * std::min(fraction, 1.0));
+        for (size_t i = 0; i < num_deleted; i++) {
+            table.file_handle->delete_record(table.rids[i], nullptr);
+        }
+        table.rids.erase(table.rids.begin(), table.rids.begin() + num_deleted);
+        return num_deleted;
+    }
+
+    /* 整理一张表，通过搬动回调把rids中记录的位置改成新的rid，相当于维护一个索引 */
+    RmCompactStats compact_table(BenchTable &table) {
+        std::map<std::pair<int, int>, size_t> pos;
+        {
+            std::scoped_lock rids_lock{table.rids_latch};
+            for (size_t i = 0; i < table.rids.size(); i++) {
+                pos[{table.rids[i].page_no, table.rids[i].slot_no}] = i;
+            }
+        }
+        RmCompactOptions options;
+        options.max_records_per_sec = config_.vacuum_rate;
+        RmCompactor compactor(table.file_handle.get(), buffer_pool_manager_, &table.latch, options);
+        compactor.set_move_callback([&](const Rid &old_rid, const Rid &new_rid, const char *record) {
+            std::scoped_lock rids_lock{table.rids_latch};
+            auto it = pos.find({old_rid.page_no, old_rid.slot_no});
+            size_t i = 0;
+            if (it != pos.end()) {
+                i = it->second;
+                pos.erase(it);
+            } else {
+                // 整理开始后前台新插入的记录
+                while (i < table.rids.size() && !(table.rids[i].page_no == old_rid.page_no &&
+                                                   table.rids[i].slot_no == old_rid.slot_no)) {
+                    i++;
+                }
+                if (i == table.rids.size()) {
+                    return;
+                }
+            }
+            table.rids[i] = new_rid;
+            pos[{new_rid.page_no, new_rid.slot_no}] = i;
+        });
+        return compactor.run();
+    }
+
+    const BenchConfig &config_;
+    DiskManager *disk_manager_;
+    BufferPoolManager *buffer_pool_manager_;
+    RmManager rm_manager_;
+
+    BenchTable user_role_, user_, cafe_admin_, cafeteria_, merchant_, normal_user_;
+    BenchTable shangpu_, dish_, orders_, orders_dish_, comment_;
+    std::vector<BenchTable *> tables_;
+
+    std::unique_ptr<RmMaterializedAgg> dish_sales_;         // orders_dish按dish_id计数
+    std::unique_ptr<RmMaterializedAgg> merchant_orders_;    // orders按merchant_id计数
+    std::unique_ptr<RmMaterializedAgg> shangpu_scores_;     // dish按shangpu_id求dish_score的平均值
+
+    int num_merchants_;
+    int num_normal_users_;
+    int num_shangpu_;
+    int num_orders_;
+    std::atomic<int> next_order_id_{0};
+};
+
+struct LatencySummary {
+    size_t count = 0;
+    double mean_us = 0;
+    double p50_us = 0;
+    double p99_us = 0;
+    double p999_us = 0;
+    double max_us = 0;
+};
+
+LatencySummary summarize(std::vector<uint64_t> &ns) {
+    LatencySummary s;
+    s.count = ns.size();
+    if (ns.empty()) {
+        return s;
+    }
+    std::sort(ns.begin(), ns.end());
+    auto pct = [&](double q) { return ns[std::min(ns.size() - 1, (size_t)(q * ns.size()))] / 1000.0; };
+    double total = 0;
+    for (uint64_t v : ns) {
+        total += v;
+    }
+    s.mean_us = total / ns.size() / 1000.0;
+    s.p50_us = pct(0.50);
+    s.p99_us = pct(0.99);
+    s.p999_us = pct(0.999);
+    s.max_us = ns.back() / 1000.0;
+    return s;
+}
+
+bool parse_mix(const std::string &spec, int *mix) {
+    std::fill(mix, mix + NUM_BENCH_OPS, 0);
+    size_t pos = 0;
+    while (pos < spec.size()) {
+        size_t end = spec.find(',', pos);
+        std::string item = spec.substr(pos, end == std::string::npos ? std::string::npos : end - pos);
+        size_t colon = item.find(':');
+        if (colon == std::string::npos) {
+            return false;
+        }
+        std::string name = item.substr(0, colon);
+        int op = 0;
+        while (op < NUM_BENCH_OPS && name != BENCH_OP_NAMES[op]) {
+            op++;
+        }
+        if (op == NUM_BENCH_OPS) {
+            return false;
+        }
+        mix[op] = std::atoi(item.c_str() + colon + 1);
+        pos = end == std::string::npos ? spec.size() : end + 1;
+    }
+    int total = 0;
+    for (int i = 0; i < NUM_BENCH_OPS; i++) {
+        total += mix[i];
+    }
+    return total > 0;
+}
+
+bool parse_args(int argc, char **argv, BenchConfig *config) {
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        size_t eq = arg.find('=');
+        std::string key = arg.substr(0, eq);
+        std::string value = eq == std::string::npos ? "" : arg.substr(eq + 1);
+        if (key == "--scale") {
+            config->scale = std::max(1, std::atoi(value.c_str()));
+        } else if (key == "--threads") {
+            config->threads = std::max(1, std::atoi(value.c_str()));
+        } else if (key == "--duration") {
+            config->duration = std::atof(value.c_str());
+        } else if (key == "--ops") {
+            config->ops = std::strtoull(value.c_str(), nullptr, 10);
+        } else if (key == "--pool") {
+            config->pool_size = std::max(16ULL, std::strtoull(value.c_str(), nullptr, 10));
+        } else if (key == "--mix") {
+            if (!parse_mix(value, config->mix)) {
+                return false;
+            }
+        } else if (key == "--scan") {
+            if (value == "rmscan") {
+                config->scan = SCAN_RMSCAN;
+            } else if (value == "predicate") {
+                config->scan = SCAN_PREDICATE;
+            } else if (value == "parallel") {
+                config->scan = SCAN_PARALLEL;
+            } else {
+                return false;
+            }
+        } else if (key == "--vacuum") {
+            config->vacuum = std::atof(value.c_str());
+        } else if (key == "--vacuum-rate") {
+            config->vacuum_rate = std::atof(value.c_str());
+        } else if (key == "--vacuum-online") {
+            config->vacuum_online = true;
+        } else if (key == "--matagg") {
+            config->matagg = true;
+        } else if (key == "--pools") {
+            config->pools = true;
+        } else if (key == "--dir") {
+            config->dir = value;
+        } else if (key == "--seed") {
+            config->seed = std::strtoull(value.c_str(), nullptr, 10);
+        } else if (key == "--format") {
+            config->json = value == "json";
+        } else if (key == "--keep") {
+            config->keep = true;
+        } else {
+            return false;
+        }
+    }
+    return true;
+}
+
+const char *scan_name(ScanMode scan) {
+    switch (scan) {
+        case SCAN_RMSCAN: return "rmscan";
+        case SCAN_PREDICATE: return "predicate";
+        case SCAN_PARALLEL: return "parallel";
+    }
+    return "";
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+    BenchConfig config;
+    if (!parse_args(argc, argv, &config)) {
+        fprintf(stderr,
+                "usage: %s [--scale=N] [--threads=N] [--duration=SEC] [--ops=N] [--pool=FRAMES]\n"
+                "          [--mix=place:40,status:30,menu:25,report:5] [--scan=rmscan|predicate|parallel]\n"
+                "          [--vacuum=FRACTION] [--vacuum-rate=RECORDS_PER_SEC] [--vacuum-online] [--matagg] [--pools]\n"
+                "          [--dir=PATH] [--seed=N] [--format=text|json] [--keep]\n",
+                argv[0]);
+        return 1;
+    }
+
+    auto disk_manager = std::make_unique<DiskManager>();
+    auto buffer_pool_manager = std::make_unique<BufferPoolManager>(config.pool_size, disk_manager.get());
+    TakeawayDb db(config, disk_manager.get(), buffer_pool_manager.get());
+
+    auto load_start = bench_clock::now();
+    db.create_tables();
+    std::mt19937_64 load_rng(config.seed);
+    db.load(load_rng);
+    double load_sec = std::chrono::duration<double>(bench_clock::now() - load_start).count();
+    size_t data_pages = db.num_pages();
+
+    // 删除一部分订单和评论，离线整理时在负载开始前完成
+    size_t vacuum_deleted = 0;
+    double scan_sec_before = 0, scan_sec_after = 0;
+    RmCompactStats vacuum_stats;
+    if (config.vacuum > 0) {
+        vacuum_deleted = db.purge(config.vacuum, load_rng);
+        scan_sec_before = db.scan_orders_sec();
+        if (!config.vacuum_online) {
+            vacuum_stats = db.vacuum();
+            scan_sec_after = db.scan_orders_sec();
+        }
+    }
+    double matagg_build_sec = 0, matagg_check_sec = 0;
+    RmAggCheckResult matagg_check;
+    if (config.matagg) {
+        matagg_build_sec = db.enable_materialized_aggs();
+    }
+    if (config.pools) {
+        db.setup_pools();
+    }
+
+    int mix_total = 0;
+    for (int i = 0; i < NUM_BENCH_OPS; i++) {
+        mix_total += config.mix[i];
+    }
+
+    // latencies[t][op]，每个线程只写自己的一份，结束后合并
+    std::vector<std::vector<std::vector<uint64_t>>> latencies(
+        config.threads, std::vector<std::vector<uint64_t>>(NUM_BENCH_OPS));
+    std::atomic<bool> stop{false};
+    BufferPoolStats stats_before = buffer_pool_manager->get_stats();
+    std::vector<BufferSubPoolStats> pool_stats_before = buffer_pool_manager->get_sub_pool_stats();
+    auto run_start = bench_clock::now();
+
+    auto worker = [&](int t) {
+        std::mt19937_64 rng(config.seed * 1000003 + t + 1);
+        for (size_t n = 0; config.ops > 0 ? n < config.ops : !stop.load(std::memory_order_relaxed); n++) {
+            int pick = (int)(rng() % mix_total);
+            int op = 0;
+            while (pick >= config.mix[op]) {
+                pick -= config.mix[op];
+                op++;
+            }
+            auto start = bench_clock::now();
+            switch (op) {
+                case OP_PLACE_ORDER: db.place_order(rng); break;
+                case OP_UPDATE_STATUS: db.update_status(rng); break;
+                case OP_READ_MENU: db.read_menu(rng); break;
+                case OP_REPORT_SCAN: db.report_scan(); break;
+                case OP_LOGIN: db.login(rng); break;
+            }
+            latencies[t][op].push_back(
+                std::chrono::duration_cast<std::chrono::nanoseconds>(bench_clock::now() - start).count());
+        }
+    };
+    std::vector<std::thread> threads;
+    for (int t = 0; t < config.threads; t++) {
+        threads.emplace_back(worker, t);
+    }
+    std::thread vacuum_thread;
+    if (config.vacuum > 0 && config.vacuum_online) {
+        vacuum_thread = std::thread([&]() { vacuum_stats = db.vacuum(); });
+    }
+    if (config.ops == 0) {
+        std::this_thread::sleep_for(std::chrono::duration<double>(config.duration));
+        stop = true;
+    }
+    for (std::thread &thread : threads) {
+        thread.join();
+    }
+    double run_sec = std::chrono::duration<double>(bench_clock::now() - run_start).count();
+    BufferPoolStats stats = buffer_pool_manager->get_stats() - stats_before;
+    std::vector<BufferSubPoolStats> pool_stats = buffer_pool_manager->get_sub_pool_stats();
+    for (size_t i = 0; i < pool_stats.size(); i++) {
+        pool_stats[i].stats = pool_stats[i].stats - pool_stats_before[i].stats;
+        pool_stats[i].steals -= pool_stats_before[i].steals;
+    }
+    if (vacuum_thread.joinable()) {
+        vacuum_thread.join();
+        scan_sec_after = db.scan_orders_sec();
+    }
+    if (config.matagg) {
+        auto check_start = bench_clock::now();
+        matagg_check = db.check_materialized_aggs();
+        matagg_check_sec = std::chrono::duration<double>(bench_clock::now() - check_start).count();
+    }
+
+    LatencySummary summaries[NUM_BENCH_OPS];
+    size_t total_ops = 0;
+    for (int op = 0; op < NUM_BENCH_OPS; op++) {
+        std::vector<uint64_t> merged;
+        for (int t = 0; t < config.threads; t++) {
+            merged.insert(merged.end(), latencies[t][op].begin(), latencies[t][op].end());
+        }
+        summaries[op] = summarize(merged);
+        total_ops += summaries[op].count;
+    }
+
+    if (config.json) {
+        printf("{\"scale\":%d,\"threads\":%d,\"pool_frames\":%zu,\"scan\":\"%s\",\"mix\":{", config.scale,
+               config.threads, config.pool_size, scan_name(config.scan));
+        for (int op = 0; op < NUM_BENCH_OPS; op++) {
+            printf("%s\"%s\":%d", op == 0 ? "" : ",", BENCH_OP_NAMES[op], config.mix[op]);
+        }
+        printf("},\"data_pages\":%zu,\"load_sec\":%.3f,\"run_sec\":%.3f,\"ops\":%zu,\"ops_per_sec\":%.1f,", data_pages,
+               load_sec, run_sec, total_ops, total_ops / run_sec);
+        printf("\"buffer_pool\":{\"hits\":%llu,\"misses\":%llu,\"evictions\":%llu,\"writebacks\":%llu,\"hit_rate\":%.4f},",
+               (unsigned long long)stats.hits, (unsigned long long)stats.misses, (unsigned long long)stats.evictions,
+               (unsigned long long)stats.writebacks, stats.hit_rate());
+        if (!pool_stats.empty()) {
+            printf("\"sub_pools\":{");
+            for (size_t i = 0; i < pool_stats.size(); i++) {
+                const BufferSubPoolStats &p = pool_stats[i];
+                printf("%s\"%s\":{\"frames\":%zu,\"min_frames\":%zu,\"max_frames\":%zu,\"no_steal\":%s,\"hits\":%llu,"
+                       "\"misses\":%llu,\"evictions\":%llu,\"steals\":%llu,\"hit_rate\":%.4f}",
+                       i == 0 ? "" : ",", p.name.c_str(), p.frames, p.options.min_frames, p.options.max_frames,
+                       p.options.no_steal ? "true" : "false", (unsigned long long)p.stats.hits,
+                       (unsigned long long)p.stats.misses, (unsigned long long)p.stats.evictions,
+                       (unsigned long long)p.steals, p.stats.hit_rate());
+            }
+            printf("},");
+        }
+        if (config.vacuum > 0) {
+            printf("\"vacuum\":{\"online\":%s,\"deleted\":%zu,\"records_moved\":%zu,\"pages_before\":%d,"
+                   "\"pages_after\":%d,\"compact_sec\":%.3f,\"scan_ms_before\":%.3f,\"scan_ms_after\":%.3f},",
+                   config.vacuum_online ? "true" : "false", vacuum_deleted, vacuum_stats.records_moved,
+                   vacuum_stats.pages_before, vacuum_stats.pages_after, vacuum_stats.elapsed_sec,
+                   scan_sec_before * 1000, scan_sec_after * 1000);
+        }
+        if (config.matagg) {
+            printf("\"matagg\":{\"build_ms\":%.3f,\"check_ms\":%.3f,\"groups_checked\":%zu,\"mismatched_groups\":%zu},",
+                   matagg_build_sec * 1000, matagg_check_sec * 1000, matagg_check.groups_checked,
+                   matagg_check.mismatched_groups);
+        }
+        printf("\"latency_us\":{");
+        for (int op = 0; op < NUM_BENCH_OPS; op++) {
+            const LatencySummary &s = summaries[op];
+            printf("%s\"%s\":{\"count\":%zu,\"mean\":%.2f,\"p50\":%.2f,\"p99\":%.2f,\"p999\":%.2f,\"max\":%.2f}",
+                   op == 0 ? "" : ",", BENCH_OP_NAMES[op], s.count, s.mean_us, s.p50_us, s.p99_us, s.p999_us,
+                   s.max_us);
+        }
+        printf("}}\n");
+    } else {
+        printf("scale=%d threads=%d pool=%zu frames scan=%s data=%zu pages load=%.3fs\n", config.scale,
+               config.threads, config.pool_size, scan_name(config.scan), data_pages, load_sec);
+        printf("ops=%zu in %.3fs, %.1f ops/s\n", total_ops, run_sec, total_ops / run_sec);
+        printf("buffer pool: hit rate %.2f%% (hits=%llu misses=%llu evictions=%llu writebacks=%llu)\n",
+               stats.hit_rate() * 100, (unsigned long long)stats.hits, (unsigned long long)stats.misses,
+               (unsigned long long)stats.evictions, (unsigned long long)stats.writebacks);
+        for (const BufferSubPoolStats &p : pool_stats) {
+            printf("  pool %-8s frames=%zu (min=%zu max=%zu%s) hit rate %.2f%% (hits=%llu misses=%llu evictions=%llu "
+                   "steals=%llu)\n",
+                   p.name.c_str(), p.frames, p.options.min_frames, p.options.max_frames,
+                   p.options.no_steal ? " no-steal" : "", p.stats.hit_rate() * 100, (unsigned long long)p.stats.hits,
+                   (unsigned long long)p.stats.misses, (unsigned long long)p.stats.evictions,
+                   (unsigned long long)p.steals);
+        }
+        if (config.vacuum > 0) {
+            printf("vacuum%s: deleted=%zu moved=%zu pages %d -> %d in %.3fs, orders scan %.3fms -> %.3fms\n",
+                   config.vacuum_online ? " (online)" : "", vacuum_deleted, vacuum_stats.records_moved,
+                   vacuum_stats.pages_before, vacuum_stats.pages_after, vacuum_stats.elapsed_sec,
+                   scan_sec_before * 1000, scan_sec_after * 1000);
+        }
+        if (config.matagg) {
+            printf("matagg: build %.3fms, check %.3fms, %zu groups, %zu mismatched\n", matagg_build_sec * 1000,
+                   matagg_check_sec * 1000, matagg_check.groups_checked, matagg_check.mismatched_groups);
+        }
+        printf("%-8s %10s %10s %10s %10s %10s %10s\n", "op", "count", "mean(us)", "p50(us)", "p99(us)", "p999(us)",
+               "max(us)");
+        for (int op = 0; op < NUM_BENCH_OPS; op++) {
+            const LatencySummary &s = summaries[op];
+            printf("%-8s %10zu %10.2f %10.2f %10.2f %10.2f %10.2f\n", BENCH_OP_NAMES[op], s.count, s.mean_us,
+                   s.p50_us, s.p99_us, s.p999_us, s.max_us);
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,289 @@
+/* Copyright (c) 2023 Renmin University of China
+RMDB is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+        http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+/* 缓冲池预热（BufferPoolWarmer）的基准测试：重启后多久回到稳定命中率。
+   先用一个缓冲池按zipf分布读页面，跑够--windows个窗口，取最后几个窗口的平均命中率作为稳定命中率，
+   停止时转储热页面列表。然后模拟两次重启（新建缓冲池，用POSIX_FADV_DONTNEED丢掉数据文件在操作系统中的缓存）：
+     cold  不预热，负载直接开始
+     warm  start_restore()在后台读入转储的页面，负载同时开始
+   每--window次访问统计一次命中率，命中率第一次达到稳定命中率的--target倍的时间就是回到稳定状态的时间。
+   输出两种方式的回到稳定状态的时间、第一个窗口的命中率、p99/p999延迟，以及预热读入的页面数和用时。
+
+   用法: warmup_bench [--dir=warmup_bench_db] [--pages=50000] [--pool=4096] [--zipf=0.9] [--window=5000]
+                      [--windows=60] [--target=0.95] [--batch-pages=32] [--seed=42] [--format=text|json] */
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <numeric>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "buffer_pool_warmer.h"
+#include "storage/buffer_pool_manager.h"
+#include "storage/disk_manager.h"
+
+namespace {
+
+using bench_clock = std::chrono::steady_clock;
+
+struct WarmupBenchConfig {
+    std::string dir = "warmup_bench_db";
+    int pages = 50000;              // 数据文件的页面数
+    size_t pool_size = 4096;
+    double zipf = 0.9;
+    size_t window = 5000;           // 每个窗口的访问次数
+    size_t windows = 60;
+    double target = 0.95;           // 达到稳定命中率的这个比例就算回到稳定状态
+    int batch_pages = 32;
+    uint64_t seed = 42;
+    bool json = false;
+};
+
+struct WarmupRunResult {
+    const char *mode;
+    std::vector<double> curve;      // 每个窗口的命中率
+    double steady_ms = -1;          // 回到稳定状态的时间，-1表示没有达到
+    size_t steady_ops = 0;
+    double p99_us = 0, p999_us = 0;
+    BufferPoolWarmerStats warmer_stats;
+    uint64_t prefetches = 0;
+};
+
+/* 按zipf分布抽取页号，热点页面用一个随机排列分散在文件各处 */
+class ZipfPages {
+   public:
+    ZipfPages(int n, double s, std::mt19937_64 &rng) : cdf_(n), pages_(n) {
+        double sum = 0;
+        for (int i = 0; i < n; i++) {
+            sum += 1.0 / std::pow(i + 1, s);
+            cdf_[i] = sum;
+        }
+        for (double &c : cdf_) {
+            c /= sum;
+        }
+        std::iota(pages_.begin(), pages_.end(), 0);
+        std::shuffle(pages_.begin(), pages_.end(), rng);
+    }
+
+    int next(std::mt19937_64 &rng) {
+        double u = std::uniform_real_distribution<double>(0, 1)(rng);
+        size_t rank = std::lower_bound(cdf_.begin(), cdf_.end(), u) - cdf_.begin();
+        return pages_[std::min(rank, pages_.size() - 1)];
+    }
+
+   private:
+    std::vector<double> cdf_;
+    std::vector<int> pages_;
+};
+
+/* 跑windows个窗口，返回每个窗口的命中率；latencies非空时记录每次访问的延迟（纳秒） */
+std::vector<double> run_windows(const WarmupBenchConfig &config, BufferPoolManager *buffer_pool_manager, int fd,
+                                uint64_t seed, std::vector<uint64_t> *latencies, std::vector<double> *window_end_ms) {
+    std::mt19937_64 rng(config.seed);
+    ZipfPages zipf(config.pages, config.zipf, rng);     // 同一个排列，各次运行的热点相同
+    rng.seed(seed);
+    std::vector<double> curve;
+    auto start = bench_clock::now();
+    for (size_t w = 0; w < config.windows; w++) {
+        BufferPoolStats before = buffer_pool_manager->get_stats();
+        for (size_t i = 0; i < config.window; i++) {
+            PageId page_id{fd, zipf.next(rng)};
+            auto op_start = bench_clock::now();
+            Page *page = buffer_pool_manager->fetch_page(page_id);
+            if (page == nullptr) {
+                throw InternalError("warmup_bench: buffer pool exhausted");
+            }
+            int stamp;
+            memcpy(&stamp, page->get_data(), sizeof(int));
+            buffer_pool_manager->unpin_page(page_id, false);
+            if (stamp != page_id.page_no) {
+                throw InternalError("warmup_bench: page " + std::to_string(page_id.page_no) + " has wrong content");
+            }
+            if (latencies != nullptr) {
+                latencies->push_back(
+                    std::chrono::duration_cast<std::chrono::nanoseconds>(bench_clock::now() - op_start).count());
+            }
+        }
+        curve.push_back((buffer_pool_manager->get_stats() - before).hit_rate());
+        if (window_end_ms != nullptr) {
+            window_end_ms->push_back(std::chrono::duration<double, std::milli>(bench_clock::now() - start).count());
+        }
+    }
+    return curve;
+}
+
+/* 模拟一次重启后的运行，warm为true时先启动后台预热 */
+WarmupRunResult run_restart(const WarmupBenchConfig &config, DiskManager *disk_manager, int fd,
+                            const std::string &dump_path, double steady_hit_rate, bool warm) {
+    WarmupRunResult result;
+    result.mode = warm ? "warm" : "cold";
+    posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+    BufferPoolManager buffer_pool_manager(config.pool_size, disk_manager);
+    std::unique_ptr<BufferPoolWarmer> warmer;
+    if (warm) {
+        BufferPoolWarmerOptions options;
+        options.batch_pages = config.batch_pages;
+        // 只用来恢复，析构时不转储，不覆盖稳定状态下的转储文件
+        options.dump_on_stop = false;
+        warmer = std::make_unique<BufferPoolWarmer>(&buffer_pool_manager, disk_manager, dump_path, options);
+        warmer->start_restore();
+    }
+    std::vector<uint64_t> latencies;
+    std::vector<double> window_end_ms;
+    // 和转储前用不同的随机序列，不是简单重放
+    result.curve = run_windows(config, &buffer_pool_manager, fd, config.seed + 1, &latencies, &window_end_ms);
+    for (size_t w = 0; w < result.curve.size(); w++) {
+        if (result.curve[w] >= steady_hit_rate * config.target) {
+            result.steady_ms = window_end_ms[w];
+            result.steady_ops = (w + 1) * config.window;
+            break;
+        }
+    }
+    if (warmer != nullptr) {
+        warmer->wait_restore();
+        result.warmer_stats = warmer->get_stats();
+    }
+    result.prefetches = buffer_pool_manager.get_stats().prefetches;
+    std::sort(latencies.begin(), latencies.end());
+    auto pct = [&](double q) {
+        return latencies.empty() ? 0 : latencies[std::min(latencies.size() - 1, (size_t)(q * latencies.size()))] / 1000.0;
+    };
+    result.p99_us = pct(0.99);
+    result.p999_us = pct(0.999);
+    return result;
+}
+
+bool parse_args(int argc, char **argv, WarmupBenchConfig *config) {
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        size_t eq = arg.find('=');
+        std::string key = arg.substr(0, eq);
+        std::string value = eq == std::string::npos ? "" : arg.substr(eq + 1);
+        if (key == "--dir") {
+            config->dir = value;
+        } else if (key == "--pages") {
+            config->pages = std::max(1, std::atoi(value.c_str()));
+        } else if (key == "--pool") {
+            config->pool_size = std::max(16ULL, std::strtoull(value.c_str(), nullptr, 10));
+        } else if (key == "--zipf") {
+            config->zipf = std::atof(value.c_str());
+        } else if (key == "--window") {
+            config->window = std::max(1ULL, std::strtoull(value.c_str(), nullptr, 10));
+        } else if (key == "--windows") {
+            config->windows = std::max(5ULL, std::strtoull(value.c_str(), nullptr, 10));
+        } else if (key == "--target") {
+            config->target = std::atof(value.c_str());
+        } else if (key == "--batch-pages") {
+            config->batch_pages = std::max(1, std::atoi(value.c_str()));
+        } else if (key == "--seed") {
+            config->seed = std::strtoull(value.c_str(), nullptr, 10);
+        } else if (key == "--format") {
+            config->json = value == "json";
+        } else {
+            return false;
+        }
+    }
+    return true;
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+    WarmupBenchConfig config;
+    if (!parse_args(argc, argv, &config)) {
+        fprintf(stderr,
+                "usage: %s [--dir=PATH] [--pages=N] [--pool=FRAMES] [--zipf=S] [--window=OPS] [--windows=N]\n"
+                "          [--target=FRACTION] [--batch-pages=N] [--seed=N] [--format=text|json]\n",
+                argv[0]);
+        return 1;
+    }
+
+    DiskManager disk_manager;
+    if (!disk_manager.is_dir(config.dir)) {
+        disk_manager.create_dir(config.dir);
+    }
+    // 数据文件：每个页面开头写上自己的页号，用来检查读到的内容
+    std::string data_path = config.dir + "/warmup_data";
+    std::string dump_path = config.dir + "/buffer_pool.warm";
+    if (disk_manager.is_file(data_path)) {
+        disk_manager.destroy_file(data_path);
+    }
+    disk_manager.create_file(data_path);
+    int fd = disk_manager.open_file(data_path);
+    const int batch_pages = 256;
+    std::vector<char> buf((size_t)batch_pages * PAGE_SIZE, 0);
+    for (int start = 0; start < config.pages; start += batch_pages) {
+        int n = std::min(batch_pages, config.pages - start);
+        for (int i = 0; i < n; i++) {
+            int page_no = start + i;
+            memcpy(buf.data() + (size_t)i * PAGE_SIZE, &page_no, sizeof(int));
+        }
+        disk_manager.write_page(fd, start, buf.data(), n * PAGE_SIZE);
+    }
+    fdatasync(fd);
+    disk_manager.set_fd2pageno(fd, config.pages);
+
+    // 转储前：跑到稳定状态，取最后5个窗口的平均命中率，停止时转储
+    double steady_hit_rate = 0;
+    size_t dumped_pages = 0;
+    {
+        BufferPoolManager buffer_pool_manager(config.pool_size, &disk_manager);
+        BufferPoolWarmer warmer(&buffer_pool_manager, &disk_manager, dump_path);
+        std::vector<double> curve = run_windows(config, &buffer_pool_manager, fd, config.seed, nullptr, nullptr);
+        steady_hit_rate = std::accumulate(curve.end() - 5, curve.end(), 0.0) / 5;
+        warmer.stop();
+        dumped_pages = warmer.get_stats().pages_dumped;
+    }
+
+    WarmupRunResult results[] = {run_restart(config, &disk_manager, fd, dump_path, steady_hit_rate, false),
+                                 run_restart(config, &disk_manager, fd, dump_path, steady_hit_rate, true)};
+    disk_manager.close_file(fd);
+    disk_manager.destroy_file(data_path);
+    unlink(dump_path.c_str());
+
+    if (config.json) {
+        printf("{\"pages\":%d,\"pool_frames\":%zu,\"zipf\":%.2f,\"window\":%zu,\"steady_hit_rate\":%.4f,"
+               "\"dumped_pages\":%zu,\"modes\":{",
+               config.pages, config.pool_size, config.zipf, config.window, steady_hit_rate, dumped_pages);
+        for (size_t i = 0; i < 2; i++) {
+            const WarmupRunResult &r = results[i];
+            printf("%s\"%s\":{\"steady_ms\":%.3f,\"steady_ops\":%zu,\"first_window_hit_rate\":%.4f,"
+                   "\"p99_us\":%.2f,\"p999_us\":%.2f,\"prefetched\":%llu,\"restore_batches\":%zu,\"restore_ms\":%.3f,"
+                   "\"curve\":[",
+                   i == 0 ? "" : ",", r.mode, r.steady_ms, r.steady_ops, r.curve.front(), r.p99_us, r.p999_us,
+                   (unsigned long long)r.prefetches, r.warmer_stats.batches, r.warmer_stats.restore_sec * 1000);
+            for (size_t w = 0; w < r.curve.size(); w++) {
+                printf("%s%.4f", w == 0 ? "" : ",", r.curve[w]);
+            }
+            printf("]}");
+        }
+        printf("}}\n");
+    } else {
+        printf("pages=%d pool=%zu frames zipf=%.2f window=%zu ops steady hit rate %.2f%% (%zu pages dumped)\n",
+               config.pages, config.pool_size, config.zipf, config.window, steady_hit_rate * 100, dumped_pages);
+        printf("%-6s %12s %12s %12s %10s %10s %12s %12s\n", "mode", "steady(ms)", "steady ops", "first hit",
+               "p99(us)", "p999(us)", "prefetched", "restore(ms)");
+        for (const WarmupRunResult &r : results) {
+            printf("%-6s %12.3f %12zu %11.2f%% %10.2f %10.2f %12llu %12.3f\n", r.mode, r.steady_ms, r.steady_ops,
+                   r.curve.front() * 100, r.p99_us, r.p999_us, (unsigned long long)r.prefetches,
+                   r.warmer_stats.restore_sec * 1000);
+        }
+    }
+    return 0;
+}
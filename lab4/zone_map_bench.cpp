@@ -0,0 +1,235 @@
+/* Copyright (c) 2023 Renmin University of China
+RMDB is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+        http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+/* 区域映射的基准测试。
+   按lab3/campustakeaway.sql的orders表生成--rows条记录，create_time（datetime按秒存成int）随订单号递增，
+   和真实的下单过程一样按时间顺序追加，对每个时间窗口占比w（--ranges，默认0.1%、1%、10%）随机执行--queries次
+     select count(*) from orders where create_time >= t and create_time < t + w * 总时长
+   比较RmPredicateScan不带区域映射（plain）和带RmZoneMap（zone-map，每--zone-pages个页面一个区）两种扫描，
+   输出每秒查询数、平均每次查询扫描和跳过的页面数，两种扫描的matched应当相同。
+
+   用法: zone_map_bench [--rows=1000000] [--ranges=0.001,0.01,0.1] [--queries=20] [--zone-pages=1] [--pool=0]
+                        [--dir=zone_map_bench_db] [--format=text|json] */
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "rm_column.h"
+#include "rm_manager.h"
+#include "rm_predicate.h"
+#include "rm_predicate_scan.h"
+#include "rm_zone_map.h"
+#include "storage/buffer_pool_manager.h"
+#include "storage/disk_manager.h"
+
+namespace {
+
+using bench_clock = std::chrono::steady_clock;
+
+// orders：order_id, user_id, shangpu_id, price, create_time
+const std::vector<RmColumn> ORDERS_COLS = {
+    {TYPE_INT, 0, 4}, {TYPE_INT, 4, 4}, {TYPE_INT, 8, 4}, {TYPE_FLOAT, 12, 4}, {TYPE_INT, 16, 4}};
+constexpr int ORDERS_RECORD_SIZE = 20;
+constexpr int CREATE_TIME_COL = 4;
+constexpr int BASE_TIME = 1727712000;       // 2024-10-01
+constexpr int SECONDS_PER_ORDER = 3;
+
+struct ZoneMapBenchConfig {
+    int rows = 1000000;
+    std::vector<double> ranges = {0.001, 0.01, 0.1};
+    int queries = 20;
+    int zone_pages = 1;
+    size_t pool_size = 0;       // 0表示按文件大小自动设置
+    std::string dir = "zone_map_bench_db";
+    bool json = false;
+};
+
+struct ZoneMapBenchResult {
+    double range;
+    const char *mode;
+    double sec = 0;
+    size_t matched = 0;
+    RmPredicateScanStats stats;     // 所有查询累加
+};
+
+std::vector<char> int_value(int v) {
+    std::vector<char> value(sizeof(int));
+    memcpy(value.data(), &v, sizeof(int));
+    return value;
+}
+
+// 生成一条orders记录，create_time按订单号递增，同一秒内可能有多个订单
+void make_order(char *rec, int order_id, std::mt19937_64 &rng) {
+    memset(rec, 0, ORDERS_RECORD_SIZE);
+    int user_id = rng() % 10000 + 1;
+    int shangpu_id = rng() % 500 + 1;
+    float price = (float)(rng() % 5000) / 100;
+    int create_time = BASE_TIME + order_id * SECONDS_PER_ORDER + rng() % SECONDS_PER_ORDER;
+    memcpy(rec + ORDERS_COLS[0].offset, &order_id, sizeof(int));
+    memcpy(rec + ORDERS_COLS[1].offset, &user_id, sizeof(int));
+    memcpy(rec + ORDERS_COLS[2].offset, &shangpu_id, sizeof(int));
+    memcpy(rec + ORDERS_COLS[3].offset, &price, sizeof(float));
+    memcpy(rec + ORDERS_COLS[CREATE_TIME_COL].offset, &create_time, sizeof(int));
+}
+
+// 对一组查询窗口执行范围扫描，zone_map为空时不跳过页面
+ZoneMapBenchResult run_queries(double range, const char *mode, const std::vector<int> &starts, int window,
+                               RmFileHandle *file_handle, BufferPoolManager *buffer_pool_manager,
+                               RmZoneMap *zone_map) {
+    ZoneMapBenchResult result;
+    result.range = range;
+    result.mode = mode;
+    const RmColumn &time_col = ORDERS_COLS[CREATE_TIME_COL];
+    auto start = bench_clock::now();
+    for (int t : starts) {
+        RmPredicate pred(
+            {RmCondition{time_col, OP_GE, int_value(t)}, RmCondition{time_col, OP_LT, int_value(t + window)}});
+        RmPredicateScan scan(file_handle, buffer_pool_manager, pred, zone_map);
+        for (; !scan.is_end(); scan.next()) {
+            result.matched++;
+        }
+        const RmPredicateScanStats &stats = scan.get_stats();
+        result.stats.pages_scanned += stats.pages_scanned;
+        result.stats.pages_skipped += stats.pages_skipped;
+        result.stats.rows_examined += stats.rows_examined;
+        result.stats.rows_matched += stats.rows_matched;
+    }
+    result.sec = std::chrono::duration<double>(bench_clock::now() - start).count();
+    return result;
+}
+
+bool parse_args(int argc, char **argv, ZoneMapBenchConfig *config) {
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        size_t eq = arg.find('=');
+        std::string key = arg.substr(0, eq);
+        std::string value = eq == std::string::npos ? "" : arg.substr(eq + 1);
+        if (key == "--rows") {
+            config->rows = std::max(1, std::atoi(value.c_str()));
+        } else if (key == "--ranges") {
+            config->ranges.clear();
+            std::stringstream ss(value);
+            std::string item;
+            while (std::getline(ss, item, ',')) {
+                config->ranges.push_back(std::min(1.0, std::max(0.0, std::atof(item.c_str()))));
+            }
+            if (config->ranges.empty()) {
+                return false;
+            }
+        } else if (key == "--queries") {
+            config->queries = std::max(1, std::atoi(value.c_str()));
+        } else if (key == "--zone-pages") {
+            config->zone_pages = std::max(1, std::atoi(value.c_str()));
+        } else if (key == "--pool") {
+            config->pool_size = std::strtoull(value.c_str(), nullptr, 10);
+        } else if (key == "--dir") {
+            config->dir = value;
+        } else if (key == "--format") {
+            config->json = value == "json";
+        } else {
+            return false;
+        }
+    }
+    return true;
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+    ZoneMapBenchConfig config;
+    if (!parse_args(argc, argv, &config)) {
+        fprintf(stderr,
+                "usage: %s [--rows=N] [--ranges=W1,W2,...] [--queries=N] [--zone-pages=N] [--pool=FRAMES] "
+                "[--dir=PATH] [--format=text|json]\n",
+                argv[0]);
+        return 1;
+    }
+    if (config.pool_size == 0) {
+        config.pool_size = (size_t)config.rows / std::max(1, PAGE_SIZE / ORDERS_RECORD_SIZE - 1) + 64;
+    }
+
+    DiskManager disk_manager;
+    BufferPoolManager buffer_pool_manager(config.pool_size, &disk_manager);
+    RmManager rm_manager(&disk_manager, &buffer_pool_manager);
+    if (!disk_manager.is_dir(config.dir)) {
+        disk_manager.create_dir(config.dir);
+    }
+    std::string path = config.dir + "/orders";
+    if (disk_manager.is_file(path)) {
+        disk_manager.destroy_file(path);
+    }
+    rm_manager.create_file(path, ORDERS_RECORD_SIZE);
+    std::unique_ptr<RmFileHandle> file_handle = rm_manager.open_file(path);
+    std::mt19937_64 rng(42);
+    std::vector<char> rec(ORDERS_RECORD_SIZE);
+    for (int i = 1; i <= config.rows; i++) {
+        make_order(rec.data(), i, rng);
+        file_handle->insert_record(rec.data(), nullptr);
+    }
+
+    auto build_start = bench_clock::now();
+    // 构造时扫描一遍文件算出每个区的区间
+    auto zone_map = std::make_unique<RmZoneMap>(file_handle.get(), &buffer_pool_manager,
+                                                std::vector<RmColumn>{ORDERS_COLS[CREATE_TIME_COL]}, config.zone_pages);
+    double build_sec = std::chrono::duration<double>(bench_clock::now() - build_start).count();
+
+    int span = (config.rows + 1) * SECONDS_PER_ORDER;
+    std::vector<ZoneMapBenchResult> results;
+    for (double range : config.ranges) {
+        int window = std::max(1, (int)(span * range));
+        std::vector<int> starts(config.queries);
+        for (int &t : starts) {
+            t = BASE_TIME + rng() % std::max(1, span - window + 1);
+        }
+        results.push_back(run_queries(range, "plain", starts, window, file_handle.get(), &buffer_pool_manager,
+                                      nullptr));
+        results.push_back(run_queries(range, "zone-map", starts, window, file_handle.get(), &buffer_pool_manager,
+                                      zone_map.get()));
+    }
+
+    int num_pages = file_handle->get_file_hdr().num_pages;
+    zone_map.reset();
+    rm_manager.close_file(file_handle.get());
+    file_handle.reset();
+    disk_manager.destroy_file(path);
+
+    if (config.json) {
+        printf("{\"rows\":%d,\"pages\":%d,\"queries\":%d,\"zone_pages\":%d,\"build_sec\":%.4f,\"results\":[",
+               config.rows, num_pages, config.queries, config.zone_pages, build_sec);
+        for (size_t i = 0; i < results.size(); i++) {
+            const ZoneMapBenchResult &r = results[i];
+            printf("%s{\"range\":%g,\"mode\":\"%s\",\"sec\":%.4f,\"queries_per_sec\":%.1f,"
+                   "\"pages_scanned_per_query\":%.1f,\"pages_skipped_per_query\":%.1f,\"matched\":%zu}",
+                   i == 0 ? "" : ",", r.range, r.mode, r.sec, config.queries / r.sec,
+                   (double)r.stats.pages_scanned / config.queries, (double)r.stats.pages_skipped / config.queries,
+                   r.matched);
+        }
+        printf("]}\n");
+    } else {
+        printf("rows=%d pages=%d queries=%d zone_pages=%d build_sec=%.4f\n", config.rows, num_pages, config.queries,
+               config.zone_pages, build_sec);
+        printf("%-8s %-9s %10s %12s %14s %14s %10s\n", "range", "mode", "sec", "queries/s", "scanned/query",
+               "skipped/query", "matched");
+        for (const ZoneMapBenchResult &r : results) {
+            printf("%-8g %-9s %10.4f %12.1f %14.1f %14.1f %10zu\n", r.range, r.mode, r.sec, config.queries / r.sec,
+                   (double)r.stats.pages_scanned / config.queries, (double)r.stats.pages_skipped / config.queries,
+                   r.matched);
+        }
+    }
+    return 0;
+}